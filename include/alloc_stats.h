@@ -0,0 +1,45 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <stdint.h>
+
+// Subsystem a heap allocation is charged to; set per thread around each
+// pipeline stage
+typedef enum {
+    ALLOC_SCOPE_OTHER,
+    ALLOC_SCOPE_DECODE,
+    ALLOC_SCOPE_RESIZE,
+    ALLOC_SCOPE_CONVERT,
+    ALLOC_SCOPE_RENDER,
+    ALLOC_SCOPE_COUNT
+} AllocScope;
+
+typedef struct {
+    uint64_t allocs;
+    uint64_t bytes;
+    uint64_t frees;
+} AllocCounters;
+
+typedef struct {
+    AllocCounters scopes[ALLOC_SCOPE_COUNT];
+    int64_t live_bytes;
+    int64_t peak_live_bytes;
+    int64_t frames;
+} AllocSnapshot;
+
+// Checked by the malloc wrappers of an ALLOC_STATS build on every call, so
+// counting costs one load and a predictable branch while it is off
+extern int alloc_stats_enabled;
+
+int alloc_stats_enable(void);
+AllocScope alloc_scope_enter(AllocScope scope);
+void alloc_scope_leave(AllocScope previous);
+void alloc_stats_snapshot(AllocSnapshot* snap);
+uint64_t alloc_stats_count_since(const AllocSnapshot* since);
+void alloc_stats_frame_end(void);
+void alloc_stats_last_frame(uint64_t* allocs, uint64_t* bytes);
+long alloc_stats_peak_rss_kb(void);
+void alloc_stats_report(void);
+const char* alloc_scope_name(AllocScope scope);
+
+#endif
@@ -2,6 +2,10 @@
 #define ASCII_CONVERTER_H
 
 #include "image_loader.h"
+#include "auto_exposure.h"
+#include "glyph_hysteresis.h"
+#include "thread_pool.h"
+#include "shape_match.h"
 
 typedef struct {
     const char* chars;
@@ -12,13 +16,50 @@ typedef struct {
 extern const AsciiCharSet ASCII_SETS[];
 extern const int NUM_ASCII_SETS;
 
+#define ASCII_MAX_GLYPHS 64
+// Output cells per frame above which conversion splits rows across the
+// config's pool, and how finely
+#define ASCII_PARALLEL_MIN_CELLS (1 << 15)
+#define ASCII_BANDS_PER_THREAD 4
+#define ASCII_MAX_BANDS 256
+
+typedef enum {
+    ASCII_MODE_CHARSET,
+    ASCII_MODE_BRAILLE,
+    ASCII_MODE_HALFBLOCK,
+    ASCII_MODE_SHAPE,
+    ASCII_MODE_COUNT
+} AsciiMode;
+
 typedef struct {
     int char_set_index;
     int invert_brightness;
     double aspect_ratio_correction;
+    AsciiMode mode;
+    // Optional; gathers this frame's histogram and applies the curve built
+    // from earlier ones. Conversions sharing one must not run concurrently.
+    AutoExposure* exposure;
+    // Ordered-dither strength for charset mode, 0 (off) to 1 (one glyph step)
+    double dither;
+    // Optional per-cell glyph memory for charset mode; same sharing rule as
+    // exposure
+    GlyphHysteresis* hysteresis;
+    // Optional; large frames are converted in row bands on it. Must not be
+    // a pool whose task is doing the conversion.
+    ThreadPool* pool;
+    // Glyph masks for shape mode, built from the font the output is drawn
+    // in (see glyph_cache_shape_glyphs); shape mode fails without them
+    const ShapeGlyphs* shapes;
 } AsciiConfig;
 
 char* image_to_ascii(const Image* img, const AsciiConfig* config);
+int image_to_ascii_into(const Image* img, const AsciiConfig* config, char* out, size_t out_size);
+size_t ascii_buffer_size(int width, int height, const AsciiConfig* config);
+int ascii_output_width(int width, const AsciiConfig* config);
+int ascii_output_height(int height, const AsciiConfig* config);
+void ascii_cell_footprint(const AsciiConfig* config, int* px_w, int* px_h);
+void ascii_grid_limits(const AsciiConfig* config, int cols, int rows, int* max_width, int* max_height);
+const char* ascii_mode_name(AsciiMode mode);
 char brightness_to_ascii(uint8_t brightness, const AsciiCharSet* char_set, int invert);
 void print_ascii_art(const char* ascii_art, int width, int height);
 int save_ascii_to_file(const char* ascii_art, int width, int height, const char* filename);
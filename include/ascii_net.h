@@ -0,0 +1,10 @@
+#ifndef ASCII_NET_H
+#define ASCII_NET_H
+
+// Addresses are "unix:<path>" or "tcp:<port>"; TCP only binds/connects to
+// 127.0.0.1.
+int ascii_net_listen(const char* address);
+int ascii_net_connect(const char* address);
+int ascii_net_set_nonblocking(int fd);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef ASCII_RASTER_H
+#define ASCII_RASTER_H
+
+#include <stdint.h>
+#include "glyph_cache.h"
+#include "thread_pool.h"
+
+// Row bands per worker, so uneven rows (half-block colour changes) even out
+#define ASCII_RASTER_BANDS_PER_THREAD 4
+
+// Draws converted text into an 8-bit gray framebuffer from a glyph cache,
+// one band of text rows per pool task. SGR colour escapes from half-block
+// output are honoured as gray levels. The XRGB8888 target is drawn through
+// one gray text row per band in scratch, widened a row at a time.
+typedef struct {
+    const GlyphCache* glyphs;
+    ThreadPool* pool;
+    const char** rows;
+    int row_capacity;
+    int num_rows;
+    int band_rows;
+    uint8_t* target;
+    int target_width;
+    int target_height;
+    int target_stride;
+    uint32_t* target_xrgb;
+    int xrgb_stride;
+    uint8_t* scratch;
+    size_t scratch_capacity;
+} AsciiRaster;
+
+AsciiRaster* ascii_raster_create(const GlyphCache* glyphs, ThreadPool* pool);
+void ascii_raster_destroy(AsciiRaster* raster);
+int ascii_raster_render(AsciiRaster* raster, const char* ascii_art, uint8_t* dst,
+                        int width, int height, int stride);
+int ascii_raster_render_xrgb(AsciiRaster* raster, const char* ascii_art, uint32_t* dst,
+                             int width, int height, int stride);
+
+#endif
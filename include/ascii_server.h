@@ -0,0 +1,69 @@
+#ifndef ASCII_SERVER_H
+#define ASCII_SERVER_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SERVER_RING_SIZE 32
+#define SERVER_MAX_CLIENTS 64
+// Backlog (in frames) that moves a client onto key-only updates
+#define SERVER_LAG_FRAMES 4
+// Consecutive on-time keys before a key-only client gets deltas again
+#define SERVER_RECOVER_FRAMES 30
+
+// One published frame, shared by every client that sends it. The ring
+// holds one reference and each client holds one while writing it out, so
+// slots are never copied per client.
+typedef struct FrameBlob {
+    int refcount;
+    uint32_t seq;
+    uint8_t* key;
+    size_t key_len;
+    size_t key_capacity;
+    uint8_t* delta;
+    size_t delta_len;
+    size_t delta_capacity;
+    struct FrameBlob* next_free;
+} FrameBlob;
+
+typedef struct {
+    int fd;
+    FrameBlob* sending;
+    const uint8_t* send_data;
+    size_t send_len;
+    size_t send_pos;
+    uint32_t send_seq;
+    uint32_t last_seq;
+    int has_sent;
+    int key_only;
+    int on_time;
+    int64_t frames_sent;
+    int64_t keys_sent;
+} ServerClient;
+
+typedef struct {
+    int listen_fd;
+    int wake_pipe[2];
+    char* unix_path;
+    pthread_t thread;
+    int running;
+    pthread_mutex_t lock;
+    FrameBlob* ring[SERVER_RING_SIZE];
+    FrameBlob* free_list;
+    uint32_t latest_seq;
+    int has_frame;
+    ServerClient clients[SERVER_MAX_CLIENTS];
+    int num_clients;
+    char* prev_text;
+    size_t prev_capacity;
+} AsciiServer;
+
+AsciiServer* ascii_server_start(const char* address);
+void ascii_server_stop(AsciiServer* server);
+int ascii_server_publish(AsciiServer* server, const char* ascii_art);
+int ascii_server_client_count(AsciiServer* server);
+int ascii_server_stream_video(const char* video_file, const char* address, int cols, int rows,
+                              int static_skip);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef ASCIICAST_RECORDER_H
+#define ASCIICAST_RECORDER_H
+
+#include <stdint.h>
+#include "async_writer.h"
+#include "term_display.h"
+
+// Writes asciicast v2: a JSON header line, then one [time, "o", data]
+// event per frame whose data is only the row diff against the last frame.
+typedef struct {
+    AsyncWriter* writer;
+    TermDisplay* diff;
+    char* line;
+    size_t line_capacity;
+    int header_written;
+    double base_time;
+    double last_time;
+    int64_t frames;
+    int64_t empty_frames;
+} AsciicastRecorder;
+
+AsciicastRecorder* asciicast_recorder_open(const char* filename);
+int asciicast_recorder_frame(AsciicastRecorder* rec, const char* ascii_art, double time_s);
+int asciicast_recorder_close(AsciicastRecorder* rec);
+int asciicast_recorder_convert(const char* video_file, const char* output_file, int cols, int rows);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASYNC_WRITER_BUFFER_SIZE (1 << 20)
+// A partly filled buffer is still handed off after this long
+#define ASYNC_WRITER_FLUSH_MS 500.0
+
+// Double-buffered file writer: callers append to the front buffer while a
+// background thread writes the back one. A caller never waits for the disk;
+// if the back buffer is still in flight when the front fills, the front
+// buffer grows instead.
+typedef struct {
+    int fd;
+    char* buffers[2];
+    size_t capacity[2];
+    size_t length[2];
+    int front;
+    int pending;
+    int busy;
+    int shutdown;
+    int failed;
+    double last_handoff_ms;
+    int64_t bytes_written;
+    int64_t grows;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+} AsyncWriter;
+
+AsyncWriter* async_writer_open(const char* filename, size_t buffer_size);
+int async_writer_write(AsyncWriter* writer, const void* data, size_t len);
+int async_writer_close(AsyncWriter* writer);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef AUDIO_PLAYER_H
+#define AUDIO_PLAYER_H
+
+#include <pthread.h>
+#include <SDL2/SDL.h>
+#include <libswresample/swresample.h>
+#include "video_processor.h"
+
+// Ring capacity in sample frames (about 0.7 s at 48 kHz); a power of two
+#define AUDIO_RING_FRAMES 32768
+// Device buffer in sample frames; also the latency the clock allows for
+#define AUDIO_DEVICE_FRAMES 1024
+// Decode-thread sleep while the ring is full or the stream has ended
+#define AUDIO_IDLE_MS 4
+
+// The audio track of a video, decoded on its own thread through its own
+// demuxer, so neither stream's packets ever wait on the other's. Samples
+// reach the SDL callback through a single-producer single-consumer ring:
+// the decode thread only advances write_pos, the callback only read_pos.
+// Times are on the video stream's timeline, like video_processor_frame_time.
+typedef struct {
+    AVFormatContext* format_ctx;
+    AVCodecContext* codec_ctx;
+    AVPacket* packet;
+    AVFrame* frame;
+    struct SwrContext* swr;
+    int stream_index;
+    AVRational time_base;
+    // Start of the video stream in seconds, which media times count from
+    double origin;
+    SDL_AudioDeviceID device;
+    int sample_rate;
+    int channels;
+    int device_frames;
+    int16_t* ring;
+    uint64_t write_pos;
+    uint64_t read_pos;
+    int16_t* scratch;
+    int scratch_frames;
+    // Media time of the sample frame at segment_pos; set under the device
+    // lock when a seek starts a new segment
+    double segment_time;
+    uint64_t segment_pos;
+    uint64_t segment_request;
+    // Published by the callback: the media time being heard at clock_ms
+    double clock_time;
+    double clock_ms;
+    int clock_valid;
+    // Seeks are requested by the player and carried out by the decode thread
+    uint64_t seek_requests;
+    int64_t seek_target_us;
+    int at_end;
+    int stop;
+    pthread_t thread;
+    int thread_started;
+    // Times the callback ran dry mid-stream; shown in the stats overlay
+    int64_t underruns;
+} AudioPlayer;
+
+AudioPlayer* audio_player_create(const char* filename);
+void audio_player_destroy(AudioPlayer* ap);
+void audio_player_seek(AudioPlayer* ap, double seconds);
+void audio_player_set_paused(AudioPlayer* ap, int paused);
+int audio_player_clock(AudioPlayer* ap, double* seconds);
+
+#endif
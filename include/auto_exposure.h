@@ -0,0 +1,46 @@
+#ifndef AUTO_EXPOSURE_H
+#define AUTO_EXPOSURE_H
+
+#include <stdint.h>
+
+// Interleaved sub-histograms, so consecutive pixels of equal luma do not
+// serialize on the same counter
+#define AUTO_EXPOSURE_LANES 4
+// Fraction of pixels clipped at each end when auto-levelling
+#define AUTO_EXPOSURE_CLIP 0.01
+// Narrowest input range stretched to full scale; caps the gain on flat frames
+#define AUTO_EXPOSURE_MIN_RANGE 48
+// Equalization bins are clipped at this multiple of the mean bin count
+#define AUTO_EXPOSURE_EQ_LIMIT 4
+// Weight of the new frame's curve in the running curve
+#define AUTO_EXPOSURE_SMOOTHING 0.12f
+
+typedef enum {
+    AUTO_EXPOSURE_OFF,
+    AUTO_EXPOSURE_LEVELS,
+    AUTO_EXPOSURE_EQUALIZE,
+    AUTO_EXPOSURE_MODE_COUNT
+} AutoExposureMode;
+
+// The converter fills histogram while it computes luma for the current
+// frame and maps every pixel through transfer, which holds the curve built
+// from earlier frames. The curve is folded into the glyph LUT once per
+// frame, so there is no extra per-pixel work beyond the histogram count.
+typedef struct {
+    AutoExposureMode mode;
+    uint32_t histogram[AUTO_EXPOSURE_LANES][256];
+    float curve[256];
+    uint8_t transfer[256];
+    int has_curve;
+    // Set when the last update left transfer as it was; a still picture has
+    // no more adapting to do, so its frames may be skipped
+    int settled;
+} AutoExposure;
+
+void auto_exposure_init(AutoExposure* ae, AutoExposureMode mode);
+void auto_exposure_reset(AutoExposure* ae);
+void auto_exposure_update(AutoExposure* ae);
+const char* auto_exposure_mode_name(AutoExposureMode mode);
+int auto_exposure_parse_mode(const char* name, AutoExposureMode* mode);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef DECODER_PREROLL_H
+#define DECODER_PREROLL_H
+
+#include <pthread.h>
+#include "video_processor.h"
+
+// How long before the end of the video the next loop starts pre-rolling
+#define DECODER_PREROLL_LEAD_S 2.0
+
+// A second decoder for the same file, opened and run up to its first frame
+// on a helper thread, so looping swaps decoders instead of seeking and
+// waiting for the codec to refill. The decoder and frame it replaces are
+// retired to the helper, which frees them off the playback thread.
+typedef struct {
+    char* video_file;
+    VideoProcessor* video_processor;
+    Image* frame;
+    VideoProcessor* retired;
+    Image* retired_frame;
+    int roi[4];
+    int running;
+    int ready;
+    pthread_t thread;
+} DecoderPreroll;
+
+DecoderPreroll* decoder_preroll_create(const char* video_file);
+void decoder_preroll_destroy(DecoderPreroll* preroll);
+int decoder_preroll_start(DecoderPreroll* preroll);
+int decoder_preroll_ready(DecoderPreroll* preroll);
+VideoProcessor* decoder_preroll_take(DecoderPreroll* preroll, Image** frame);
+void decoder_preroll_retire(DecoderPreroll* preroll, VideoProcessor* vp, Image* frame);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef FONT_LOADER_H
+#define FONT_LOADER_H
+
+#include <SDL2/SDL_ttf.h>
+
+#define DEFAULT_FONT_SIZE 8
+#define FONT_CACHE_VERSION 1
+
+TTF_Font* font_loader_open(int font_size, int* char_width, int* char_height, int* cache_hit);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Wire format shared by the fan-out server and its clients. Every message
+// is a 16-byte little-endian header followed by a payload:
+//   key:   the full frame text, rows separated by '\n'
+//   delta: (row u16, length u16, bytes) for each row that changed since
+//          the frame with sequence number seq - 1
+#define FRAME_CODEC_MAGIC 0x31464156u
+#define FRAME_CODEC_HEADER_SIZE 16
+
+typedef enum {
+    FRAME_TYPE_KEY = 1,
+    FRAME_TYPE_DELTA = 2
+} FrameType;
+
+typedef struct {
+    uint8_t type;
+    uint16_t rows;
+    uint32_t seq;
+    uint32_t payload_len;
+} FrameHeader;
+
+typedef struct {
+    char* data;
+    int len;
+    int capacity;
+} FrameRow;
+
+typedef struct {
+    FrameRow* rows;
+    int num_rows;
+    int rows_capacity;
+    uint32_t seq;
+    int has_key;
+    char* text;
+    size_t text_capacity;
+} FrameState;
+
+size_t frame_codec_max_size(size_t text_len, int rows);
+size_t frame_codec_encode_key(const char* ascii_art, uint32_t seq, uint8_t* out, size_t capacity);
+size_t frame_codec_encode_delta(const char* prev, const char* cur, uint32_t seq, uint8_t* out, size_t capacity);
+int frame_codec_read_header(const uint8_t* buf, FrameHeader* header);
+int frame_codec_count_rows(const char* ascii_art);
+
+FrameState* frame_state_create(void);
+void frame_state_free(FrameState* state);
+int frame_state_apply(FrameState* state, const FrameHeader* header, const uint8_t* payload);
+const char* frame_state_text(FrameState* state);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "image_loader.h"
+#include "async_writer.h"
+
+#define FRAME_TRACE_MAGIC 0x52544156  // "VATR" little-endian
+#define FRAME_TRACE_VERSION 1
+#define FRAME_TRACE_ITERATIONS 5
+
+// 32-byte header followed by fixed-size records: a double timestamp (seconds)
+// then width * height * channels pixel bytes. The frame count is implied by
+// the file size, so capture never has to seek back.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t reserved[3];
+} FrameTraceHeader;
+
+typedef struct {
+    AsyncWriter* writer;
+    FrameTraceHeader header;
+    int64_t frames;
+} FrameTraceWriter;
+
+typedef struct {
+    int fd;
+    uint8_t* map;
+    size_t map_size;
+    FrameTraceHeader header;
+    size_t record_size;
+    int64_t num_frames;
+} FrameTrace;
+
+FrameTraceWriter* frame_trace_writer_open(const char* filename, int width, int height, int channels);
+int frame_trace_writer_append(FrameTraceWriter* tw, const Image* img, double time_s);
+int frame_trace_writer_close(FrameTraceWriter* tw);
+FrameTrace* frame_trace_open(const char* filename);
+void frame_trace_close(FrameTrace* trace);
+int frame_trace_frame(const FrameTrace* trace, int64_t index, Image* view, double* time_s);
+int frame_trace_capture(const char* video_file, const char* trace_file, int cols, int rows);
+int frame_trace_replay(const char* trace_file, int iterations, int num_threads, int steady_state,
+                       int pin_threads);
+
+#endif
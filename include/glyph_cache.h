@@ -0,0 +1,37 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <stdint.h>
+#include <SDL2/SDL_ttf.h>
+#include "shape_match.h"
+
+// Open-addressed slots for non-ASCII glyphs (braille alone needs 256)
+#define GLYPH_CACHE_SLOTS 1024
+
+typedef struct {
+    uint32_t codepoint;
+    int index;
+} GlyphSlot;
+
+// Every glyph the converter can emit, rasterized once into 8-bit coverage
+// cells. Lookups are read-only after creation, so any number of threads can
+// blit from one cache.
+typedef struct {
+    TTF_Font* font;
+    int owns_ttf;
+    int cell_width;
+    int cell_height;
+    uint8_t* bitmaps;
+    int num_glyphs;
+    int capacity;
+    int ascii_index[128];
+    GlyphSlot slots[GLYPH_CACHE_SLOTS];
+} GlyphCache;
+
+GlyphCache* glyph_cache_create(int font_size);
+void glyph_cache_destroy(GlyphCache* cache);
+const uint8_t* glyph_cache_lookup(const GlyphCache* cache, uint32_t codepoint);
+int glyph_cache_shape_glyphs(const GlyphCache* cache, ShapeGlyphs* shapes);
+int utf8_decode(const char* s, uint32_t* codepoint);
+
+#endif
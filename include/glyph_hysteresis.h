@@ -0,0 +1,45 @@
+#ifndef GLYPH_HYSTERESIS_H
+#define GLYPH_HYSTERESIS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "image_loader.h"
+
+// Levels a cell's luma must move past its glyph's boundary before the
+// glyph changes
+#define GLYPH_HYSTERESIS_DEFAULT_MARGIN 6
+// Luma sampled on a 16x16 grid; a mean change above this is a scene cut
+#define GLYPH_HYSTERESIS_SAMPLES 16
+#define GLYPH_HYSTERESIS_SCENE_CUT 24
+// Table row (and cell value) meaning "no previous glyph"
+#define GLYPH_HYSTERESIS_NONE 64
+
+// Per-cell glyph memory for charset conversion. The converter maps every
+// cell through table[previous glyph][level] in the same pass that
+// quantizes it, so holding a glyph costs one lookup and one byte per cell.
+typedef struct {
+    int margin;
+    uint8_t* cells;
+    size_t capacity;
+    int cols;
+    int rows;
+    uint8_t table[GLYPH_HYSTERESIS_NONE + 1][256];
+    uint8_t levels[256];
+    int num_glyphs;
+    uint8_t samples[GLYPH_HYSTERESIS_SAMPLES * GLYPH_HYSTERESIS_SAMPLES];
+    int has_samples;
+    int64_t cells_changed;
+    int64_t cells_total;
+    int64_t scene_cuts;
+} GlyphHysteresis;
+
+GlyphHysteresis* glyph_hysteresis_create(int margin);
+void glyph_hysteresis_destroy(GlyphHysteresis* h);
+void glyph_hysteresis_reset(GlyphHysteresis* h);
+void glyph_hysteresis_set_margin(GlyphHysteresis* h, int margin);
+int glyph_hysteresis_resize(GlyphHysteresis* h, int cols, int rows);
+int glyph_hysteresis_prepare(GlyphHysteresis* h, const Image* img, const uint8_t levels[256],
+                             int num_glyphs, int cols, int rows);
+double glyph_hysteresis_change_rate(const GlyphHysteresis* h);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef GOP_CACHE_H
+#define GOP_CACHE_H
+
+#include <pthread.h>
+#include "video_processor.h"
+#include "image_resize.h"
+
+// Grid-sized frames kept for backward navigation; enough for a few
+// 2-second GOPs at the usual grid sizes
+#define GOP_CACHE_MAX_BYTES (64 * 1024 * 1024)
+#define GOP_CACHE_MIN_FRAMES 16
+
+typedef struct {
+    Image* image;
+    double time;
+} GopFrame;
+
+// Decoded frames covering one contiguous stretch of the video, oldest
+// first. A private decoder on a helper thread fills it one GOP at a time:
+// seek to the keyframe before the oldest cached frame, decode up to it and
+// prepend. Reverse playback walks the cache backwards while the next older
+// GOP is decoded.
+typedef struct {
+    char* video_file;
+    VideoProcessor* video_processor;
+    Image* frame_buffer;
+    ResizePlan* resize_plan;
+    int grid_width;
+    int grid_height;
+    ResizeFilter filter;
+    int roi_x;
+    int roi_y;
+    int roi_width;
+    int roi_height;
+    GopFrame* frames;
+    int count;
+    int capacity;
+    int at_start;
+    int generation;
+    int request_pending;
+    double request_end;
+    int decoding;
+    int shutdown;
+    double frame_interval;
+    int64_t gops_decoded;
+    double last_decode_ms;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t ready;
+} GopCache;
+
+GopCache* gop_cache_create(const char* video_file, double fps);
+void gop_cache_destroy(GopCache* cache);
+int gop_cache_configure(GopCache* cache, int grid_width, int grid_height, ResizeFilter filter);
+int gop_cache_set_roi(GopCache* cache, int x, int y, int width, int height);
+int gop_cache_frame_before(GopCache* cache, double time, Image* dst, double* frame_time, int wait);
+int gop_cache_frame_after(GopCache* cache, double time, Image* dst, double* frame_time);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef GRID_CONTROLLER_H
+#define GRID_CONTROLLER_H
+
+#include <stdint.h>
+
+// Grid scale steps below the full window grid; each one scales both axes
+// by GRID_CONTROL_STEP (about 30% fewer cells)
+#define GRID_CONTROL_LEVELS 8
+#define GRID_CONTROL_STEP 0.84
+// Frames averaged per decision
+#define GRID_CONTROL_WINDOW 20
+// Step down when the average exceeds this share of the frame budget, to a
+// level predicted to land at GRID_CONTROL_TARGET
+#define GRID_CONTROL_OVER 0.90
+#define GRID_CONTROL_TARGET 0.75
+// Step up only when the next larger level is predicted to stay under this
+#define GRID_CONTROL_UNDER 0.70
+// Windows to wait after a step down before trying a larger grid; doubled
+// each time a step up has to be taken back
+#define GRID_CONTROL_HOLD 3
+#define GRID_CONTROL_MAX_HOLD 48
+
+// Feedback controller for the grid size. It watches the grid-dependent
+// per-frame work (resize, convert, draw) against the frame budget; the
+// cost is modelled as proportional to the cell count, i.e. scale squared.
+typedef struct {
+    int enabled;
+    int level;
+    double sum_ms;
+    int samples;
+    int hold;
+    int hold_windows;
+    int stepped_up;
+    double average_ms;
+    int64_t steps;
+} GridController;
+
+void grid_controller_init(GridController* gc, int enabled);
+void grid_controller_restart(GridController* gc);
+int grid_controller_sample(GridController* gc, double work_ms, double budget_ms);
+double grid_controller_scale(const GridController* gc);
+double grid_controller_level_scale(int level);
+
+#endif
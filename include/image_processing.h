@@ -3,9 +3,18 @@
 
 #include "image_loader.h"
 
+// Rec. 601 luma in 8-bit fixed point: 0.299, 0.587 and 0.114 scaled by 256.
+// Every path that turns RGB into a brightness level uses this one, so the
+// converter, the half-block display and the frame checks agree.
+static inline uint8_t rgb_luma(int r, int g, int b) {
+    return (uint8_t)((77 * r + 150 * g + 29 * b) >> 8);
+}
+
 Image* convert_to_grayscale(const Image* img);
 Image* resize_image(const Image* img, int new_width, int new_height);
+int resize_image_into(const Image* img, Image* dst);
 Image* resize_image_aspect_ratio(const Image* img, int max_width, int max_height);
+void fit_aspect_ratio(int width, int height, int max_width, int max_height, int* out_width, int* out_height);
 uint8_t get_pixel_brightness(const Image* img, int x, int y);
 uint8_t bilinear_interpolate(const Image* img, float x, float y, int channel);
 
@@ -0,0 +1,61 @@
+#ifndef IMAGE_RESIZE_H
+#define IMAGE_RESIZE_H
+
+#include <stdint.h>
+#include "image_loader.h"
+#include "thread_pool.h"
+
+#define RESIZE_COEF_BITS 14
+// Multiply-adds per frame above which a plan splits rows across the pool
+#define RESIZE_PARALLEL_MIN_WORK (1 << 22)
+
+typedef enum {
+    RESIZE_NEAREST,
+    RESIZE_BOX,
+    RESIZE_BILINEAR,
+    RESIZE_LANCZOS,
+    RESIZE_FILTER_COUNT
+} ResizeFilter;
+
+#define RESIZE_DEFAULT_FILTER RESIZE_BILINEAR
+
+// Fixed-point taps for one axis. Every output uses the same tap count; the
+// window start is clamped so start + taps never runs off the source.
+typedef struct {
+    int src_size;
+    int dst_size;
+    int taps;
+    int* start;
+    int16_t* coef;
+} ResizeAxis;
+
+// Coefficient tables for one (source size, destination size, filter), the
+// source rows the vertical taps actually read, and the scratch rows of the
+// horizontal pass. A plan is reused for every frame
+// of that geometry but must not be run from two threads at once.
+typedef struct {
+    int src_width;
+    int src_height;
+    int dst_width;
+    int dst_height;
+    int channels;
+    ResizeFilter filter;
+    ResizeAxis horizontal;
+    ResizeAxis vertical;
+    int* rows;
+    int num_rows;
+    uint8_t* temp;
+    int64_t work;
+} ResizePlan;
+
+ResizePlan* resize_plan_create(int src_width, int src_height, int dst_width, int dst_height,
+                               int channels, ResizeFilter filter);
+void resize_plan_destroy(ResizePlan* plan);
+int resize_plan_matches(const ResizePlan* plan, const Image* src, const Image* dst, ResizeFilter filter);
+ResizePlan* resize_plan_update(ResizePlan* plan, const Image* src, const Image* dst, ResizeFilter filter);
+int resize_plan_run(ResizePlan* plan, const Image* src, Image* dst, ThreadPool* pool);
+int resize_plan_run_strided(ResizePlan* plan, const uint8_t* src, size_t src_stride, Image* dst,
+                            ThreadPool* pool);
+const char* resize_filter_name(ResizeFilter filter);
+
+#endif
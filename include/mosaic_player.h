@@ -0,0 +1,63 @@
+#ifndef MOSAIC_PLAYER_H
+#define MOSAIC_PLAYER_H
+
+#include "video_processor.h"
+#include "sdl_display.h"
+#include "ascii_converter.h"
+#include "thread_pool.h"
+#include "image_resize.h"
+
+// Upper bound on frames a late tile decodes (without converting) per job
+#define MOSAIC_MAX_CATCHUP 8
+
+typedef struct {
+    const char* source;
+    VideoProcessor* video_processor;
+    Image* frame_buffer;
+    Image* grid_buffer;
+    ResizePlan* resize_plan;
+    char* ascii_front;
+    char* ascii_back;
+    size_t ascii_size;
+    int cell_x;
+    int cell_y;
+    int text_cols;
+    int text_rows;
+    double frame_interval_ms;
+    double media_ms;
+    double job_clock_ms;
+    double job_time_ms;
+    int busy;
+    int ready;
+    int64_t frames_shown;
+    int64_t frames_dropped;
+    const AsciiConfig* ascii_config;
+} MosaicTile;
+
+typedef struct {
+    MosaicTile* tiles;
+    int num_tiles;
+    int tiles_x;
+    int tiles_y;
+    int cols;
+    int rows;
+    ThreadPool* pool;
+    SDLDisplay* display;
+    AsciiConfig ascii_config;
+    char* composite;
+    size_t composite_size;
+    int paused;
+    double clock_start_ms;
+    double pause_start_ms;
+    int show_stats;
+    int resize_pending;
+    int pending_width;
+    int pending_height;
+} MosaicPlayer;
+
+MosaicPlayer* mosaic_player_init(const char** video_files, int num_files, int window_width,
+                                 int window_height, int num_threads);
+void mosaic_player_cleanup(MosaicPlayer* mp);
+int mosaic_player_run(MosaicPlayer* mp);
+
+#endif
@@ -4,6 +4,10 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include "image_loader.h"
+#include "startup_profile.h"
+#include "font_loader.h"
+#include "glyph_cache.h"
+#include "ascii_raster.h"
 
 typedef struct {
     SDL_Window* window;
@@ -17,9 +21,31 @@ typedef struct {
     int video_height;
     int ascii_width;
     int ascii_height;
+    // Part of the ASCII texture the grid fills; stretched over the window
+    // when the grid is smaller than the window's
+    int text_width;
+    int text_height;
+    // Time the last SDL_RenderPresent blocked (vsync), not frame work
+    double present_ms;
     int font_size;
     int char_width;
     int char_height;
+    int video_texture_width;
+    int video_texture_height;
+    char* line_buffer;
+    size_t line_capacity;
+    // Set when only SDL's software renderer was available
+    int software_renderer;
+    // Text drawn on the CPU from cached glyphs into a streaming texture,
+    // instead of one TTF surface and texture per line
+    GlyphCache* glyphs;
+    AsciiRaster* raster;
+    SDL_Texture* raster_texture;
+    // Texture and rects the last frame was copied from, so the overlay can
+    // be redrawn over it without converting again; NULL once dropped
+    SDL_Texture* shown_texture;
+    SDL_Rect shown_src;
+    SDL_Rect shown_dst;
 } SDLDisplay;
 
 typedef struct {
@@ -27,12 +53,31 @@ typedef struct {
     int frame_count;
     double avg_process_time;
     double last_frame_time;
+    double speed;
+    double actual_speed;
+    double static_rate;
+    double change_rate;
+    int grid_cols;
+    int grid_rows;
+    // Set while video follows the audio clock
+    int av_sync;
+    double av_drift_ms;
+    int64_t frames_dropped;
+    int64_t audio_underruns;
+    // Only filled in while allocation statistics are on
+    double rss_peak_mb;
+    double heap_peak_mb;
+    uint64_t frame_allocs;
+    uint64_t frame_alloc_bytes;
 } SDLPerformanceStats;
 
-SDLDisplay* sdl_display_init(int width, int height);
+SDLDisplay* sdl_display_init(int width, int height, StartupProfile* profile);
 void sdl_display_cleanup(SDLDisplay* display);
+int sdl_display_resize(SDLDisplay* display, int width, int height);
+int sdl_display_grid_size(const SDLDisplay* display, int* cols, int* rows);
+void sdl_display_set_text_grid(SDLDisplay* display, int cols, int rows);
+int sdl_display_set_raster(SDLDisplay* display, int enabled, ThreadPool* pool);
 int sdl_display_frame_split(SDLDisplay* display, const Image* img, const char* ascii_art, SDLPerformanceStats* stats);
-
-#define DEFAULT_FONT_SIZE 8
+int sdl_display_redraw(SDLDisplay* display, SDLPerformanceStats* stats);
 
 #endif
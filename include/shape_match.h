@@ -0,0 +1,56 @@
+#ifndef SHAPE_MATCH_H
+#define SHAPE_MATCH_H
+
+#include <stdint.h>
+
+// Masks are 8x8 bits, row-major, bit 0 top left. A shape-mode cell covers
+// SHAPE_CELL_WIDTH x SHAPE_CELL_HEIGHT grid pixels; each pixel column sets
+// two mask columns, matching the roughly 1:2 aspect of a glyph cell.
+#define SHAPE_MASK_SIZE 8
+#define SHAPE_CELL_WIDTH 4
+#define SHAPE_CELL_HEIGHT 8
+// Printable ASCII
+#define SHAPE_MAX_GLYPHS 95
+// A glyph mask bit is set where the mean coverage under it reaches this
+#define SHAPE_COVERAGE_THRESHOLD 96
+// Glyphs the search window grows by on each side per step
+#define SHAPE_SCAN_CHUNK 8
+
+// Direct-mapped memo entries in front of the search; flat areas repeat the
+// same dithered masks, so most cells of a frame are found here
+#define SHAPE_MEMO_BITS 9
+#define SHAPE_MEMO_SIZE (1 << SHAPE_MEMO_BITS)
+
+// Glyph masks sorted by popcount, bits[i] being masks[i]'s; start[k] is the
+// first glyph with at least k bits set. Glyphs whose masks repeat an
+// earlier one's are dropped.
+typedef struct {
+    uint64_t masks[SHAPE_MAX_GLYPHS];
+    char glyphs[SHAPE_MAX_GLYPHS];
+    uint8_t bits[SHAPE_MAX_GLYPHS];
+    int count;
+    int start[SHAPE_MASK_SIZE * SHAPE_MASK_SIZE + 2];
+} ShapeGlyphs;
+
+// Recent masks and their glyphs. Every entry always holds a valid pair, so
+// lookups need no empty marker. One per thread.
+typedef struct {
+    uint64_t masks[SHAPE_MEMO_SIZE];
+    char glyphs[SHAPE_MEMO_SIZE];
+} ShapeMemo;
+
+int shape_glyphs_build(ShapeGlyphs* shapes, const char* glyphs, const uint8_t* const* bitmaps,
+                       int cell_width, int cell_height);
+char shape_glyphs_match(const ShapeGlyphs* shapes, uint64_t mask);
+void shape_memo_init(ShapeMemo* memo, const ShapeGlyphs* shapes);
+
+static inline char shape_memo_match(ShapeMemo* memo, const ShapeGlyphs* shapes, uint64_t mask) {
+    int slot = (int)((mask * 0x9E3779B97F4A7C15ULL) >> (64 - SHAPE_MEMO_BITS));
+    if (memo->masks[slot] != mask) {
+        memo->masks[slot] = mask;
+        memo->glyphs[slot] = shape_glyphs_match(shapes, mask);
+    }
+    return memo->glyphs[slot];
+}
+
+#endif
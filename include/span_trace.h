@@ -0,0 +1,44 @@
+#ifndef SPAN_TRACE_H
+#define SPAN_TRACE_H
+
+#include <stdint.h>
+
+// Spans kept per thread; older ones are overwritten once a ring wraps
+#define SPAN_TRACE_RING_SIZE (1 << 16)
+#define SPAN_TRACE_MAX_THREADS 64
+
+typedef struct {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} TraceSpan;
+
+// Written only by its owning thread; the head is published with release
+// stores so the exporter can read a consistent prefix without locking
+typedef struct {
+    TraceSpan spans[SPAN_TRACE_RING_SIZE];
+    uint64_t head;
+    int tid;
+    char thread_name[32];
+} SpanRing;
+
+// Checked inline at every span site, so a disabled trace costs one load
+// and a predictable branch
+extern int span_trace_enabled;
+
+int span_trace_start(const char* path);
+int span_trace_stop(void);
+void span_trace_name_thread(const char* name);
+uint64_t span_trace_now_ns(void);
+void span_trace_record(const char* name, uint64_t start_ns);
+
+static inline uint64_t span_begin(void) {
+    return __builtin_expect(span_trace_enabled, 0) ? span_trace_now_ns() : 0;
+}
+
+// name must be a string literal (or otherwise outlive the trace)
+static inline void span_end(const char* name, uint64_t start_ns) {
+    if (__builtin_expect(span_trace_enabled, 0) && start_ns) span_trace_record(name, start_ns);
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef STARTUP_PROFILE_H
+#define STARTUP_PROFILE_H
+
+typedef enum {
+    STARTUP_PHASE_DECODER_OPEN,
+    STARTUP_PHASE_SDL_INIT,
+    STARTUP_PHASE_TTF_INIT,
+    STARTUP_PHASE_FONT_LOAD,
+    STARTUP_PHASE_WINDOW,
+    STARTUP_PHASE_FIRST_FRAME,
+    STARTUP_PHASE_COUNT
+} StartupPhase;
+
+typedef struct {
+    double start_ms;
+    double phase_ms[STARTUP_PHASE_COUNT];
+    double total_ms;
+    int font_cache_hit;
+} StartupProfile;
+
+double startup_now_ms(void);
+void startup_profile_begin(StartupProfile* profile);
+void startup_profile_record(StartupProfile* profile, StartupPhase phase, double since_ms);
+void startup_profile_finish(StartupProfile* profile);
+void startup_profile_print(const StartupProfile* profile);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef STATIC_FRAME_H
+#define STATIC_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "image_loader.h"
+
+// Luma a single grid pixel may move before a frame counts as changed;
+// absorbs encoder noise on otherwise still content
+#define STATIC_FRAME_NOISE 3
+
+// Signature of a grid image: the luma of every pixel, so a change confined
+// to one cell is still seen. Frames are compared against the last one that
+// was actually presented, so slow drift below the noise threshold still
+// adds up to a redraw.
+typedef struct {
+    int width;
+    int height;
+    uint8_t* luma;
+    size_t capacity;
+} FrameSignature;
+
+// Zeroed memory is a valid, enabled detector
+typedef struct {
+    FrameSignature presented;
+    FrameSignature current;
+    int has_presented;
+    int disabled;
+    int64_t frames;
+    int64_t skipped;
+} StaticFrameDetector;
+
+int frame_signature_compute(FrameSignature* sig, const Image* grid);
+int frame_signature_matches(const FrameSignature* a, const FrameSignature* b, int noise);
+void static_frame_init(StaticFrameDetector* detector);
+void static_frame_free(StaticFrameDetector* detector);
+void static_frame_set_enabled(StaticFrameDetector* detector, int enabled);
+int static_frame_check(StaticFrameDetector* detector, const Image* grid);
+void static_frame_reset(StaticFrameDetector* detector);
+double static_frame_skip_rate(const StaticFrameDetector* detector);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef TERM_DISPLAY_H
+#define TERM_DISPLAY_H
+
+#include <stddef.h>
+
+// Hide the cursor and clear the screen
+#define TERM_DISPLAY_SETUP "\x1b[?25l\x1b[2J"
+
+typedef struct {
+    int fd;
+    char* prev;
+    size_t prev_size;
+    char* out;
+    size_t out_capacity;
+    size_t out_len;
+    int has_prev;
+    int rows_changed;
+} TermDisplay;
+
+TermDisplay* term_display_init(int fd);
+void term_display_cleanup(TermDisplay* td);
+int term_display_encode_frame(TermDisplay* td, const char* ascii_art);
+int term_display_present(TermDisplay* td, const char* ascii_art);
+void term_display_invalidate(TermDisplay* td);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+
+typedef void (*ThreadPoolTask)(void* arg);
+typedef void (*ThreadPoolRangeTask)(void* arg, int index);
+
+typedef struct {
+    ThreadPoolTask task;
+    void* arg;
+} ThreadPoolJob;
+
+typedef struct {
+    pthread_t* threads;
+    int num_threads;
+    ThreadPoolJob* queue;
+    int queue_capacity;
+    int queue_head;
+    int queue_count;
+    int active;
+    int shutdown;
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;
+    pthread_cond_t work_done;
+} ThreadPool;
+
+ThreadPool* thread_pool_create(int num_threads, int queue_capacity);
+void thread_pool_destroy(ThreadPool* pool);
+int thread_pool_submit(ThreadPool* pool, ThreadPoolTask task, void* arg);
+void thread_pool_wait_idle(ThreadPool* pool);
+void thread_pool_parallel_for(ThreadPool* pool, int count, ThreadPoolRangeTask task, void* arg);
+int thread_pool_cpu_count(void);
+int thread_pool_pin_workers(ThreadPool* pool);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef VIDEO_EXPORTER_H
+#define VIDEO_EXPORTER_H
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+
+// Encoder preference; the first one that opens wins
+#define EXPORT_ENCODER_PRIMARY "libx264"
+#define EXPORT_CRF "20"
+
+// Encodes gray ASCII renderings as YUV 4:2:0: callers draw straight into
+// the luma plane and the chroma planes stay neutral.
+typedef struct {
+    AVFormatContext* format_ctx;
+    AVCodecContext* codec_ctx;
+    AVStream* stream;
+    AVFrame* frame;
+    AVPacket* packet;
+    AVRational source_time_base;
+    int64_t frame_duration;
+    int64_t last_pts;
+    int width;
+    int height;
+    int64_t frames_written;
+} VideoExporter;
+
+VideoExporter* video_exporter_init(const char* filename, int width, int height,
+                                   AVRational time_base, AVRational frame_rate);
+void video_exporter_cleanup(VideoExporter* ex);
+uint8_t* video_exporter_luma(VideoExporter* ex, int* stride);
+int video_exporter_write_frame(VideoExporter* ex, int64_t pts);
+int video_exporter_finish(VideoExporter* ex);
+int video_exporter_export(const char* video_file, const char* output_file, int cols, int rows,
+                          int num_threads, int pin_threads);
+
+#endif
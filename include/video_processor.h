@@ -5,6 +5,7 @@
 #include <libavcodec/avcodec.h>
 #include <libswscale/swscale.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include "image_loader.h"
 
 typedef struct {
@@ -16,9 +17,18 @@ typedef struct {
     AVPacket* packet;
     struct SwsContext* sws_ctx;
     int video_stream_index;
+    // Output size: the region of interest, or the whole frame
     int width;
     int height;
+    int source_width;
+    int source_height;
+    int roi_x;
+    int roi_y;
+    int roi_pixstep[4];
     double fps;
+    AVRational time_base;
+    AVRational frame_rate;
+    int64_t frame_pts;
     int64_t total_frames;
     int64_t current_frame;
     uint8_t* rgb_buffer;
@@ -28,12 +38,20 @@ typedef struct {
 VideoProcessor* video_processor_init(const char* filename);
 void video_processor_cleanup(VideoProcessor* vp);
 Image* video_processor_get_next_frame(VideoProcessor* vp);
+int video_processor_read_frame(VideoProcessor* vp, Image* dst);
+int video_processor_skip_frame(VideoProcessor* vp);
+int video_processor_convert_frame(VideoProcessor* vp, Image* dst);
+int video_processor_seek_time(VideoProcessor* vp, double seconds);
+void video_processor_set_discard(VideoProcessor* vp, enum AVDiscard discard);
+int video_processor_set_roi(VideoProcessor* vp, int x, int y, int width, int height);
 void video_processor_reset(VideoProcessor* vp);
+double video_processor_get_duration(VideoProcessor* vp);
 double video_processor_get_fps(VideoProcessor* vp);
 int video_processor_get_width(VideoProcessor* vp);
 int video_processor_get_height(VideoProcessor* vp);
 int64_t video_processor_get_total_frames(VideoProcessor* vp);
 int64_t video_processor_get_current_frame(VideoProcessor* vp);
+double video_processor_frame_time(VideoProcessor* vp);
 int video_processor_is_valid(VideoProcessor* vp);
 void video_processor_print_info(VideoProcessor* vp);
 
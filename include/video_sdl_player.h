@@ -4,6 +4,29 @@
 #include "video_processor.h"
 #include "sdl_display.h"
 #include "ascii_converter.h"
+#include "startup_profile.h"
+#include "asciicast_recorder.h"
+#include "image_resize.h"
+#include "thread_pool.h"
+#include "gop_cache.h"
+#include "decoder_preroll.h"
+#include "static_frame.h"
+#include "grid_controller.h"
+#include "audio_player.h"
+
+// Above this speed the decoder drops non-reference frames outright
+#define PLAYER_NONREF_SPEED 2.0
+// Above this speed only keyframes are decoded
+#define PLAYER_KEYFRAME_SPEED 4.0
+// Lag behind the media clock that makes keyframe mode seek ahead
+#define PLAYER_SEEK_LAG_S 1.0
+// Dither strength change per [ / ] key press
+#define PLAYER_DITHER_STEP 0.25
+// Weight of each new A/V drift measurement in the displayed average
+#define PLAYER_DRIFT_SMOOTHING 0.1
+// Zoom factor per key press and the smallest region zoom goes down to
+#define PLAYER_ZOOM_STEP 1.25
+#define PLAYER_MIN_ROI 16
 
 typedef enum {
     PLAYER_STOPPED,
@@ -27,16 +50,69 @@ typedef struct {
     int show_stats;
     double last_frame_time;
     double frame_delay_ms;
+    Image* frame_buffer;
+    Image* grid_buffer;
+    size_t grid_capacity;
+    ResizePlan* resize_plan;
+    ResizePlan* level_plans[GRID_CONTROL_LEVELS];
+    ResizeFilter resize_filter;
+    ThreadPool* pool;
+    char* ascii_buffer;
+    size_t ascii_buffer_size;
+    int has_frame;
+    int resize_pending;
+    int pending_width;
+    int pending_height;
+    StartupProfile startup;
+    int startup_report;
+    int first_frame_shown;
+    AsciicastRecorder* recorder;
+    GopCache* gop_cache;
+    int reverse;
+    double position_time;
+    int forward_synced;
+    double media_time;
+    double key_interval;
+    double actual_speed;
+    double speed_window_ms;
+    double speed_window_time;
+    DecoderPreroll* preroll;
+    double duration;
+    int roi_x;
+    int roi_y;
+    int roi_width;
+    int roi_height;
+    StaticFrameDetector static_frames;
+    AutoExposure exposure;
+    GlyphHysteresis* hysteresis;
+    ShapeGlyphs* shapes;
+    GridController grid_control;
+    AudioPlayer* audio;
+    int audio_running;
+    double av_drift_ms;
+    int64_t frames_dropped;
 } VideoPlayer;
 
 VideoPlayer* video_player_init(const char* video_file, int window_width, int window_height);
 void video_player_cleanup(VideoPlayer* player);
+int video_player_start_recording(VideoPlayer* player, const char* filename);
 int video_player_run(VideoPlayer* player);
 void video_player_play(VideoPlayer* player);
 void video_player_pause(VideoPlayer* player);
 void video_player_stop(VideoPlayer* player);
 void video_player_set_speed(VideoPlayer* player, double speed);
 void video_player_seek_frame(VideoPlayer* player, int64_t frame);
+void video_player_step(VideoPlayer* player, int direction);
+void video_player_set_reverse(VideoPlayer* player, int reverse);
+int video_player_set_roi(VideoPlayer* player, int x, int y, int width, int height);
+void video_player_zoom(VideoPlayer* player, double factor);
+void video_player_pan(VideoPlayer* player, int dx, int dy);
+void video_player_set_exposure(VideoPlayer* player, AutoExposureMode mode);
+void video_player_set_dither(VideoPlayer* player, double strength);
+int video_player_set_hysteresis(VideoPlayer* player, int margin);
+int video_player_set_mode(VideoPlayer* player, AsciiMode mode);
+void video_player_set_adaptive_grid(VideoPlayer* player, int enabled);
+void video_player_set_static_skip(VideoPlayer* player, int enabled);
 int video_player_handle_events(VideoPlayer* player);
 void video_player_update_display(VideoPlayer* player, const Image* frame, const char* ascii_art);
 double get_current_time_ms(void);
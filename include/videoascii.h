@@ -0,0 +1,95 @@
+#ifndef VIDEOASCII_H
+#define VIDEOASCII_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ascii_converter.h"
+#include "image_resize.h"
+
+// Embeddable converter from video frames to ASCII cell grids, built as
+// libvideoascii. Each context owns everything it touches and allocates only
+// in videoascii_create, so independent contexts can run on different
+// threads and pushing a frame never allocates. Nothing is printed; errors
+// go to the log callback.
+
+#define VIDEOASCII_VERSION_MAJOR 1
+#define VIDEOASCII_VERSION_MINOR 0
+
+// The shared library is built with hidden visibility and exports only the
+// functions marked with this
+#ifdef __GNUC__
+#define VIDEOASCII_API __attribute__((visibility("default")))
+#else
+#define VIDEOASCII_API
+#endif
+
+typedef enum {
+    VIDEOASCII_OK = 0,
+    VIDEOASCII_ERROR_ARGUMENT = -1,
+    VIDEOASCII_ERROR_FORMAT = -2,
+    VIDEOASCII_ERROR_SIZE = -3,
+    VIDEOASCII_ERROR_BUFFER = -4,
+    VIDEOASCII_ERROR_MEMORY = -5
+} VideoAsciiStatus;
+
+// Planar and semi-planar YUV are read from the luma plane only, which is
+// all the cell mapping uses
+typedef enum {
+    VIDEOASCII_FORMAT_GRAY8,
+    VIDEOASCII_FORMAT_RGB24,
+    VIDEOASCII_FORMAT_YUV420P,
+    VIDEOASCII_FORMAT_NV12
+} VideoAsciiFormat;
+
+typedef enum {
+    VIDEOASCII_LOG_ERROR,
+    VIDEOASCII_LOG_WARNING,
+    VIDEOASCII_LOG_INFO
+} VideoAsciiLogLevel;
+
+typedef void (*VideoAsciiLogFn)(void* user, VideoAsciiLogLevel level, const char* message);
+
+typedef struct {
+    int source_width;
+    int source_height;
+    VideoAsciiFormat format;
+    // YUV luma in 0-255 rather than the 16-235 video range. AVFrames are
+    // also taken as full range when their format (YUVJ) or color_range
+    // says so.
+    int full_range;
+    int cols;
+    int rows;
+    // Shrink the grid to the source aspect ratio instead of filling it
+    int keep_aspect;
+    AsciiConfig ascii;
+    ResizeFilter filter;
+    VideoAsciiLogFn log;
+    void* log_user;
+} VideoAsciiParams;
+
+typedef struct {
+    VideoAsciiParams params;
+    int channels;
+    Image* grid;
+    ResizePlan* plan;
+    size_t output_size;
+    // Stretches 16-235 luma to 0-255; applied while video_range is set
+    uint8_t range_lut[256];
+    int video_range;
+    int64_t frames;
+} VideoAsciiContext;
+
+struct AVFrame;
+
+VIDEOASCII_API void videoascii_default_params(VideoAsciiParams* params);
+VIDEOASCII_API VideoAsciiContext* videoascii_create(const VideoAsciiParams* params);
+VIDEOASCII_API void videoascii_destroy(VideoAsciiContext* ctx);
+VIDEOASCII_API size_t videoascii_output_size(const VideoAsciiContext* ctx);
+VIDEOASCII_API void videoascii_grid_size(const VideoAsciiContext* ctx, int* cols, int* rows);
+VIDEOASCII_API int videoascii_push(VideoAsciiContext* ctx, const uint8_t* const planes[],
+                                   const int strides[], char* out, size_t out_size);
+VIDEOASCII_API int videoascii_push_avframe(VideoAsciiContext* ctx, const struct AVFrame* frame,
+                                           char* out, size_t out_size);
+VIDEOASCII_API const char* videoascii_status_string(int status);
+
+#endif
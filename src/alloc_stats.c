@@ -0,0 +1,273 @@
+#define _GNU_SOURCE
+#include "alloc_stats.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#if defined(ALLOC_STATS) && defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+int alloc_stats_enabled = 0;
+
+static AllocCounters counters[ALLOC_SCOPE_COUNT];
+static int64_t live_bytes = 0;
+static int64_t peak_live_bytes = 0;
+static int64_t frames = 0;
+static uint64_t frame_mark_allocs = 0;
+static uint64_t frame_mark_bytes = 0;
+static uint64_t last_frame_allocs = 0;
+static uint64_t last_frame_bytes = 0;
+static __thread int current_scope = ALLOC_SCOPE_OTHER;
+
+static const char* scope_names[ALLOC_SCOPE_COUNT] = {
+    "other",
+    "decode",
+    "resize",
+    "convert",
+    "render"
+};
+
+#if defined(ALLOC_STATS) && defined(__GLIBC__)
+// The program's malloc family forwards to glibc's own entry points, so every
+// allocation in the process (FFmpeg and SDL included) is seen here. Only
+// instrumented builds replace it; the wrappers put a header on every block,
+// which sanitizers and libraries with their own allocator pairing do not
+// expect.
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* ptr);
+
+// Every block starts with a header just below the pointer handed out. It
+// records whether the block was counted, so blocks from before counting
+// was enabled are not charged when they are freed. offset leads back from
+// the pointer to the block glibc returned, which differs for over-aligned
+// blocks.
+typedef struct {
+    uint64_t size;
+    uint32_t offset;
+    uint32_t counted;
+} AllocHeader;
+
+#define ALLOC_HEADER_SIZE 16
+
+static inline AllocHeader* block_header(void* ptr) {
+    return (AllocHeader*)((char*)ptr - sizeof(AllocHeader));
+}
+
+static void note_alloc(size_t size) {
+    AllocCounters* c = &counters[current_scope];
+    __atomic_fetch_add(&c->allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&c->bytes, size, __ATOMIC_RELAXED);
+
+    int64_t live = __atomic_add_fetch(&live_bytes, (int64_t)size, __ATOMIC_RELAXED);
+    int64_t peak = __atomic_load_n(&peak_live_bytes, __ATOMIC_RELAXED);
+    while (live > peak && !__atomic_compare_exchange_n(&peak_live_bytes, &peak, live, 1,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void note_free(const AllocHeader* header) {
+    if (!header->counted) return;
+    __atomic_fetch_add(&counters[current_scope].frees, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&live_bytes, (int64_t)header->size, __ATOMIC_RELAXED);
+}
+
+// Fills in the header of a block glibc returned and charges it while
+// counting is on
+static void* track_block(void* raw, size_t offset, size_t size) {
+    if (!raw) return NULL;
+
+    void* ptr = (char*)raw + offset;
+    AllocHeader* header = block_header(ptr);
+    header->size = size;
+    header->offset = (uint32_t)offset;
+    header->counted = __builtin_expect(alloc_stats_enabled, 0) != 0;
+    if (header->counted) note_alloc(size);
+    return ptr;
+}
+
+void* malloc(size_t size) {
+    if (size > SIZE_MAX - ALLOC_HEADER_SIZE) return NULL;
+    return track_block(__libc_malloc(size + ALLOC_HEADER_SIZE), ALLOC_HEADER_SIZE, size);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (size && count > (SIZE_MAX - ALLOC_HEADER_SIZE) / size) return NULL;
+    return track_block(__libc_calloc(1, count * size + ALLOC_HEADER_SIZE), ALLOC_HEADER_SIZE,
+                       count * size);
+}
+
+void free(void* ptr) {
+    if (!ptr) return;
+    AllocHeader* header = block_header(ptr);
+    note_free(header);
+    __libc_free((char*)ptr - header->offset);
+}
+
+// A realloc counts as a free of the old block and an allocation of the new
+void* realloc(void* ptr, size_t size) {
+    if (!ptr) return malloc(size);
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    if (size > SIZE_MAX - ALLOC_HEADER_SIZE) return NULL;
+
+    AllocHeader old = *block_header(ptr);
+    if (old.offset != ALLOC_HEADER_SIZE) {
+        // Over-aligned blocks cannot move through glibc's realloc
+        void* result = malloc(size);
+        if (!result) return NULL;
+        memcpy(result, ptr, old.size < size ? old.size : size);
+        free(ptr);
+        return result;
+    }
+
+    // On failure the old block is untouched and stays as it was counted
+    void* raw = __libc_realloc((char*)ptr - ALLOC_HEADER_SIZE, size + ALLOC_HEADER_SIZE);
+    if (!raw) return NULL;
+    note_free(&old);
+    return track_block(raw, ALLOC_HEADER_SIZE, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    if (alignment <= ALLOC_HEADER_SIZE) return malloc(size);
+    if (size > SIZE_MAX - alignment) return NULL;
+    // A whole alignment unit in front keeps the pointer aligned and leaves
+    // room for the header
+    return track_block(__libc_memalign(alignment, size + alignment), alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    if (alignment % sizeof(void*) || (alignment & (alignment - 1))) return EINVAL;
+    void* ptr = memalign(alignment, size);
+    if (!ptr) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+void* valloc(size_t size) {
+    return memalign((size_t)sysconf(_SC_PAGESIZE), size);
+}
+
+void* pvalloc(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return memalign(page, (size + page - 1) & ~(page - 1));
+}
+
+// glibc's answer would be for the block behind the header
+size_t malloc_usable_size(void* ptr) {
+    return ptr ? (size_t)block_header(ptr)->size : 0;
+}
+
+int alloc_stats_enable(void) {
+    alloc_stats_enabled = 1;
+    return 1;
+}
+#elif defined(ALLOC_STATS)
+int alloc_stats_enable(void) {
+    fprintf(stderr, "Error: Allocation statistics need glibc\n");
+    return 0;
+}
+#else
+int alloc_stats_enable(void) {
+    fprintf(stderr, "Error: Allocation statistics need a build with 'make ALLOC_STATS=1'\n");
+    return 0;
+}
+#endif
+
+// Returns the scope to restore with alloc_scope_leave
+AllocScope alloc_scope_enter(AllocScope scope) {
+    AllocScope previous = (AllocScope)current_scope;
+    current_scope = scope;
+    return previous;
+}
+
+void alloc_scope_leave(AllocScope previous) {
+    current_scope = previous;
+}
+
+void alloc_stats_snapshot(AllocSnapshot* snap) {
+    for (int i = 0; i < ALLOC_SCOPE_COUNT; i++) {
+        snap->scopes[i].allocs = __atomic_load_n(&counters[i].allocs, __ATOMIC_RELAXED);
+        snap->scopes[i].bytes = __atomic_load_n(&counters[i].bytes, __ATOMIC_RELAXED);
+        snap->scopes[i].frees = __atomic_load_n(&counters[i].frees, __ATOMIC_RELAXED);
+    }
+    snap->live_bytes = __atomic_load_n(&live_bytes, __ATOMIC_RELAXED);
+    snap->peak_live_bytes = __atomic_load_n(&peak_live_bytes, __ATOMIC_RELAXED);
+    snap->frames = frames;
+}
+
+// Allocations in every scope since the snapshot was taken
+uint64_t alloc_stats_count_since(const AllocSnapshot* since) {
+    uint64_t total = 0;
+    for (int i = 0; i < ALLOC_SCOPE_COUNT; i++) {
+        total += __atomic_load_n(&counters[i].allocs, __ATOMIC_RELAXED) - since->scopes[i].allocs;
+    }
+    return total;
+}
+
+// Closes one frame: what was allocated since the previous call becomes the
+// last-frame figure shown in the overlay
+void alloc_stats_frame_end(void) {
+    if (!alloc_stats_enabled) return;
+
+    uint64_t allocs = 0, bytes = 0;
+    for (int i = 0; i < ALLOC_SCOPE_COUNT; i++) {
+        allocs += __atomic_load_n(&counters[i].allocs, __ATOMIC_RELAXED);
+        bytes += __atomic_load_n(&counters[i].bytes, __ATOMIC_RELAXED);
+    }
+    last_frame_allocs = allocs - frame_mark_allocs;
+    last_frame_bytes = bytes - frame_mark_bytes;
+    frame_mark_allocs = allocs;
+    frame_mark_bytes = bytes;
+    frames++;
+}
+
+void alloc_stats_last_frame(uint64_t* allocs, uint64_t* bytes) {
+    *allocs = last_frame_allocs;
+    *bytes = last_frame_bytes;
+}
+
+long alloc_stats_peak_rss_kb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;
+}
+
+const char* alloc_scope_name(AllocScope scope) {
+    if (scope < 0 || scope >= ALLOC_SCOPE_COUNT) return "unknown";
+    return scope_names[scope];
+}
+
+// Totals since counting was enabled, per frame where frames were marked
+void alloc_stats_report(void) {
+    if (!alloc_stats_enabled) return;
+
+    AllocSnapshot snap;
+    alloc_stats_snapshot(&snap);
+    double per = snap.frames > 0 ? 1.0 / (double)snap.frames : 0.0;
+
+    printf("\n=== Allocations (%ld frames) ===\n", (long)snap.frames);
+    printf("%-8s %12s %14s %12s %14s %14s\n", "Scope", "allocs", "bytes", "frees",
+           "allocs/frame", "bytes/frame");
+    for (int i = 0; i < ALLOC_SCOPE_COUNT; i++) {
+        const AllocCounters* c = &snap.scopes[i];
+        printf("%-8s %12llu %14llu %12llu %14.2f %14.0f\n", scope_names[i],
+               (unsigned long long)c->allocs, (unsigned long long)c->bytes,
+               (unsigned long long)c->frees, c->allocs * per, c->bytes * per);
+    }
+    printf("Heap high-water: %.1f MB | Live at exit: %.1f MB | Peak RSS: %.1f MB\n",
+           snap.peak_live_bytes / 1048576.0, snap.live_bytes / 1048576.0,
+           alloc_stats_peak_rss_kb() / 1024.0);
+    printf("================================\n");
+}
@@ -0,0 +1,109 @@
+#define _GNU_SOURCE
+#include "ascii_net.h"
+#include "frame_codec.h"
+#include "term_display.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void stop_handler(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static int read_full(int fd, uint8_t* buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, buf + got, len - got);
+        if (n <= 0) return 0;
+        got += n;
+    }
+    return 1;
+}
+
+void print_usage(const char* program_name) {
+    printf("ASCII Video Stream Client\n");
+    printf("=========================\n\n");
+    printf("Usage: %s <address>\n\n", program_name);
+    printf("Address:\n");
+    printf("  unix:<path>  Unix domain socket of a running server\n");
+    printf("  tcp:<port>   Server on localhost\n\n");
+    printf("Start a server with: video_ascii_player <video_file> --serve <address>\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || strcmp(argv[1], "--help") == 0) {
+        print_usage(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+
+    int fd = ascii_net_connect(argv[1]);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot connect to %s\n", argv[1]);
+        return 1;
+    }
+
+    // No SA_RESTART, so a blocked read returns and the terminal is restored
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_handler;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    FrameState* state = frame_state_create();
+    TermDisplay* td = term_display_init(STDOUT_FILENO);
+    uint8_t header_buf[FRAME_CODEC_HEADER_SIZE];
+    uint8_t* payload = NULL;
+    size_t payload_capacity = 0;
+    long frames = 0, keys = 0, skipped = 0;
+    int result = 0;
+
+    if (!state || !td) {
+        fprintf(stderr, "Error: Cannot allocate client state\n");
+        result = 1;
+        stop_requested = 1;
+    }
+
+    while (!stop_requested) {
+        FrameHeader header;
+        if (!read_full(fd, header_buf, sizeof(header_buf))) break;
+        if (!frame_codec_read_header(header_buf, &header)) {
+            fprintf(stderr, "Error: Invalid frame header from server\n");
+            result = 1;
+            break;
+        }
+
+        if (header.payload_len > payload_capacity) {
+            uint8_t* grown = realloc(payload, header.payload_len);
+            if (!grown) {
+                result = 1;
+                break;
+            }
+            payload = grown;
+            payload_capacity = header.payload_len;
+        }
+        if (header.payload_len > 0 && !read_full(fd, payload, header.payload_len)) break;
+
+        if (!frame_state_apply(state, &header, payload)) {
+            skipped++;
+            continue;
+        }
+
+        if (header.type == FRAME_TYPE_KEY) keys++;
+        frames++;
+        term_display_present(td, frame_state_text(state));
+    }
+
+    term_display_cleanup(td);
+    frame_state_free(state);
+    free(payload);
+    close(fd);
+
+    printf("Received %ld frames (%ld keys, %ld skipped)\n", frames, keys, skipped);
+    return result;
+}
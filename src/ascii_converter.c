@@ -1,7 +1,11 @@
 #include "ascii_converter.h"
+#include "span_trace.h"
 #include "image_processing.h"
 #include <stdlib.h>
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 const AsciiCharSet ASCII_SETS[] = {
     {"@%#*+=-:. ", 10, "Standard"},
@@ -14,14 +18,118 @@ const AsciiCharSet ASCII_SETS[] = {
 
 const int NUM_ASCII_SETS = sizeof(ASCII_SETS) / sizeof(ASCII_SETS[0]);
 
+static const char* mode_names[ASCII_MODE_COUNT] = {
+    "Charset",
+    "Braille",
+    "Half-block",
+    "Shape"
+};
+
+// Braille dot bit for each pixel of a 2x4 cell, indexed [row][column]
+static const uint8_t braille_bits[4][2] = {
+    {0x01, 0x08},
+    {0x02, 0x10},
+    {0x04, 0x20},
+    {0x40, 0x80}
+};
+
+// 8x8 Bayer index matrix; (v + 0.5) / 64 spreads its thresholds evenly
+// over one quantization step
+static const uint8_t bayer8[8][8] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21}
+};
+
+// "\x1b[38;5;NNN;48;5;NNNm" + U+2580 (upper half block)
+#define HALFBLOCK_CELL_BYTES 23
+#define HALFBLOCK_RESET "\x1b[0m"
+#define HALFBLOCK_RESET_BYTES 4
+#define BRAILLE_CELL_BYTES 3
+// Shape-mode cells whose masks are built per pass along the image rows
+#define SHAPE_ROW_CHUNK 256
+
+// Byte offset and length of every glyph of a charset, so multibyte UTF-8
+// glyphs are copied whole instead of being indexed byte by byte
+typedef struct {
+    uint8_t offset[ASCII_MAX_GLYPHS];
+    uint8_t len[ASCII_MAX_GLYPHS];
+    int count;
+    int max_len;
+} GlyphTable;
+
+static int utf8_sequence_length(uint8_t lead) {
+    if (lead < 0x80) return 1;
+    if ((lead & 0xE0) == 0xC0) return 2;
+    if ((lead & 0xF0) == 0xE0) return 3;
+    if ((lead & 0xF8) == 0xF0) return 4;
+    return 1;
+}
+
+static void build_glyph_table(const AsciiCharSet* char_set, GlyphTable* table) {
+    const uint8_t* p = (const uint8_t*)char_set->chars;
+    int offset = 0;
+
+    table->count = 0;
+    table->max_len = 1;
+
+    while (p[offset] && table->count < char_set->length && table->count < ASCII_MAX_GLYPHS) {
+        int len = utf8_sequence_length(p[offset]);
+        table->offset[table->count] = (uint8_t)offset;
+        table->len[table->count] = (uint8_t)len;
+        if (len > table->max_len) table->max_len = len;
+        table->count++;
+        offset += len;
+    }
+}
+
+// Same mapping as brightness_to_ascii, precomputed for all 256 levels
+static void build_level_lut(int num_glyphs, int invert, uint8_t lut[256]) {
+    for (int b = 0; b < 256; b++) {
+        int index = invert ? (b * (num_glyphs - 1)) / 255
+                           : ((255 - b) * (num_glyphs - 1)) / 255;
+        lut[b] = (uint8_t)index;
+    }
+}
+
+// Exposure state to gather into and apply, or NULL when it is off
+static AutoExposure* active_exposure(const AsciiConfig* config) {
+    if (!config->exposure || config->exposure->mode == AUTO_EXPOSURE_OFF) return NULL;
+    return config->exposure;
+}
+
+static inline uint8_t pixel_luma(const Image* img, int x, int y) {
+    const uint8_t* p = img->data + ((size_t)y * img->width + x) * img->channels;
+    if (img->channels < 3) return p[0];
+    return rgb_luma(p[0], p[1], p[2]);
+}
+
 AsciiConfig create_default_config(void) {
     AsciiConfig config;
     config.char_set_index = 0;
     config.invert_brightness = 0;
     config.aspect_ratio_correction = 0.5;  
+    config.mode = ASCII_MODE_CHARSET;
+    config.exposure = NULL;
+    config.dither = 0.0;
+    config.hysteresis = NULL;
+    config.pool = NULL;
+    config.shapes = NULL;
     return config;
 }
 
+const char* ascii_mode_name(AsciiMode mode) {
+    if (mode < 0 || mode >= ASCII_MODE_COUNT) return "Unknown";
+    return mode_names[mode];
+}
+
+// Only meaningful for single-byte charsets; multibyte sets go through the
+// glyph table in image_to_ascii_into
 char brightness_to_ascii(uint8_t brightness, const AsciiCharSet* char_set, int invert) {
     if (!char_set || char_set->length == 0) return ' ';
     
@@ -38,56 +146,606 @@ char brightness_to_ascii(uint8_t brightness, const AsciiCharSet* char_set, int i
     return char_set->chars[index];
 }
 
-char* image_to_ascii(const Image* img, const AsciiConfig* config) {
-    if (!img || !img->data || !config) return NULL;
-    
-    if (config->char_set_index < 0 || config->char_set_index >= NUM_ASCII_SETS) {
-        fprintf(stderr, "Error: Invalid character set index\n");
-        return NULL;
+void ascii_cell_footprint(const AsciiConfig* config, int* px_w, int* px_h) {
+    *px_w = 1;
+    *px_h = 1;
+    if (!config) return;
+
+    switch (config->mode) {
+        case ASCII_MODE_BRAILLE:
+            *px_w = 2;
+            *px_h = 4;
+            break;
+        case ASCII_MODE_HALFBLOCK:
+            *px_h = 2;
+            break;
+        case ASCII_MODE_SHAPE:
+            *px_w = SHAPE_CELL_WIDTH;
+            *px_h = SHAPE_CELL_HEIGHT;
+            break;
+        default:
+            if (config->aspect_ratio_correction > 0.0) {
+                *px_h = (int)(1.0 / config->aspect_ratio_correction + 0.5);
+                if (*px_h < 1) *px_h = 1;
+            }
+            break;
     }
+}
+
+// Largest grid image (in pixels) that still fits cols x rows output cells
+void ascii_grid_limits(const AsciiConfig* config, int cols, int rows, int* max_width, int* max_height) {
+    int px_w, px_h;
+    ascii_cell_footprint(config, &px_w, &px_h);
+    *max_width = cols * px_w;
+    *max_height = rows * px_h;
+}
+
+int ascii_output_width(int width, const AsciiConfig* config) {
+    if (!config) return 0;
+    switch (config->mode) {
+        case ASCII_MODE_BRAILLE:
+            return width / 2;
+        case ASCII_MODE_SHAPE:
+            return width / SHAPE_CELL_WIDTH;
+        default:
+            return width;
+    }
+}
+
+int ascii_output_height(int height, const AsciiConfig* config) {
+    if (!config) return 0;
+    switch (config->mode) {
+        case ASCII_MODE_BRAILLE:
+            return height / 4;
+        case ASCII_MODE_HALFBLOCK:
+            return height / 2;
+        case ASCII_MODE_SHAPE:
+            return height / SHAPE_CELL_HEIGHT;
+        default:
+            return (int)(height * config->aspect_ratio_correction);
+    }
+}
+
+// Per-frame tables and output layout shared by every row band of one
+// conversion. Each band writes at its first row times row_bytes, the
+// longest a row can get, and the bands are packed together afterwards.
+typedef struct {
+    const Image* img;
+    const AsciiConfig* config;
+    AutoExposure* exposure;
+    int output_width;
+    int output_height;
+    size_t row_bytes;
+    char* out;
+    int band_rows;
+    size_t band_len[ASCII_MAX_BANDS];
+    int64_t cells_changed;
+    // Charset mode
+    GlyphTable table;
+    int dither;
+    int held;
+    uint8_t lut[256];
+    // One table per Bayer cell, row-major
+    uint8_t luts[64][256];
+    int thresholds[64];
+    // Braille dot masks, half-block colors or shape levels, per luma
+    uint8_t cell_lut[256];
+    // Shape mode's ink thresholds, indexed [y & 7][x & 7]
+    uint8_t shape_thresholds[8][8];
+} ConvertJob;
+
+static size_t row_capacity(int output_width, const AsciiConfig* config) {
+    if (config->mode == ASCII_MODE_BRAILLE) {
+        return (size_t)BRAILLE_CELL_BYTES * output_width + 1;
+    }
+    if (config->mode == ASCII_MODE_SHAPE) {
+        return (size_t)output_width + 1;
+    }
+    if (config->mode == ASCII_MODE_HALFBLOCK) {
+        return (size_t)HALFBLOCK_CELL_BYTES * output_width + HALFBLOCK_RESET_BYTES + 1;
+    }
+    size_t cell_bytes = 1;
+    if (config->char_set_index >= 0 && config->char_set_index < NUM_ASCII_SETS) {
+        GlyphTable table;
+        build_glyph_table(&ASCII_SETS[config->char_set_index], &table);
+        cell_bytes = table.max_len;
+    }
+    return cell_bytes * output_width + 1;
+}
+
+size_t ascii_buffer_size(int width, int height, const AsciiConfig* config) {
+    int output_width = ascii_output_width(width, config);
+    int output_height = ascii_output_height(height, config);
+    if (output_width <= 0 || output_height <= 0) return 1;
+
+    return row_capacity(output_width, config) * output_height + 1;
+}
+
+// Threshold of one Bayer cell, in levels. Strength 1 spans one glyph step
+// and makes the floor quantizer unbiased.
+static int dither_threshold(int cell, int num_glyphs, double strength) {
+    double step = 255.0 / (num_glyphs > 1 ? num_glyphs - 1 : 1);
+    if (strength > 1.0) strength = 1.0;
+    return (int)((bayer8[cell >> 3][cell & 7] + 0.5) / 64.0 * step * strength);
+}
+
+// One glyph LUT per Bayer cell: the threshold is added to the level before
+// quantizing, saturating at the ends. Non-inverted ramps run from bright to
+// dark, so there the threshold is subtracted. base holds the level of each
+// luma (the exposure curve, or identity). The quantizer is the one in
+// build_level_lut, with x / 255 computed as (x + (x >> 8) + 1) >> 8, which
+// is exact for every product that can occur here.
+static void build_dither_luts(const uint8_t base[256], int num_glyphs, int invert, double strength,
+                              uint8_t luts[64][256]) {
+    for (int cell = 0; cell < 64; cell++) {
+        int offset = dither_threshold(cell, num_glyphs, strength);
+        uint8_t* lut = luts[cell];
+        int b = 0;
+#ifdef __SSE2__
+        __m128i off = _mm_set1_epi8((char)offset);
+        __m128i scale = _mm_set1_epi16((short)(num_glyphs - 1));
+        __m128i one = _mm_set1_epi16(1);
+        __m128i flip = _mm_set1_epi8(invert ? 0 : (char)0xFF);
+        __m128i zero = _mm_setzero_si128();
+        for (; b + 16 <= 256; b += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(base + b));
+            v = invert ? _mm_adds_epu8(v, off) : _mm_subs_epu8(v, off);
+            v = _mm_xor_si128(v, flip);
+            __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), scale);
+            __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), scale);
+            lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), one), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), one), 8);
+            _mm_storeu_si128((__m128i*)(lut + b), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; b < 256; b++) {
+            int v = invert ? base[b] + offset : base[b] - offset;
+            v = v < 0 ? 0 : v > 255 ? 255 : v;
+            lut[b] = (uint8_t)((invert ? v : 255 - v) * (num_glyphs - 1) / 255);
+        }
+    }
+}
+
+// Per-frame charset setup: the glyph table, and either the hysteresis
+// cells (exposure and dither are then applied per pixel, since its table
+// works on levels) or the glyph LUTs with exposure and dither folded in.
+// Returns 0 when the charset has no glyphs.
+static int charset_setup(ConvertJob* job) {
+    const AsciiConfig* config = job->config;
+    AutoExposure* ae = job->exposure;
+
+    build_glyph_table(&ASCII_SETS[config->char_set_index], &job->table);
+    if (job->table.count == 0) return 0;
+    job->dither = config->dither > 0.0;
+
+    if (config->hysteresis) {
+        uint8_t levels[256];
+        build_level_lut(job->table.count, config->invert_brightness, levels);
+        job->held = glyph_hysteresis_prepare(config->hysteresis, job->img, levels, job->table.count,
+                                             job->output_width, job->output_height);
+    }
+    if (job->held) {
+        memset(job->thresholds, 0, sizeof(job->thresholds));
+        if (job->dither) {
+            for (int cell = 0; cell < 64; cell++) {
+                int t = dither_threshold(cell, job->table.count, config->dither);
+                job->thresholds[cell] = config->invert_brightness ? t : -t;
+            }
+        }
+    } else if (job->dither) {
+        uint8_t base[256];
+        for (int b = 0; b < 256; b++) base[b] = ae ? ae->transfer[b] : (uint8_t)b;
+        build_dither_luts(base, job->table.count, config->invert_brightness, config->dither, job->luts);
+    } else {
+        uint8_t levels[256];
+        build_level_lut(job->table.count, config->invert_brightness, levels);
+        for (int b = 0; b < 256; b++) job->lut[b] = levels[ae ? ae->transfer[b] : b];
+    }
+    return 1;
+}
+
+// Charset rows through the per-cell hysteresis table; adds the number of
+// cells whose glyph changed to *changed
+static size_t charset_held_rows(const ConvertJob* job, int first, int last,
+                                uint32_t (*hist)[256], char* out, int64_t* changed) {
+    const Image* img = job->img;
+    const AsciiConfig* config = job->config;
+    GlyphHysteresis* hyst = config->hysteresis;
+    const GlyphTable* table = &job->table;
+    const char* chars = ASCII_SETS[config->char_set_index].chars;
+    AutoExposure* ae = job->exposure;
+    int output_width = job->output_width;
+    size_t pos = 0;
+    int64_t count = 0;
+
+    for (int y = first; y < last; y++) {
+        int src_y = (int)((float)y / config->aspect_ratio_correction);
+        if (src_y >= img->height) src_y = img->height - 1;
+        uint8_t* cells = hyst->cells + (size_t)y * output_width;
+        const int* row_thresholds = job->thresholds + (y & 7) * 8;
+
+        for (int x = 0; x < output_width; x++) {
+            uint8_t luma = pixel_luma(img, x, src_y);
+            if (hist) hist[x & (AUTO_EXPOSURE_LANES - 1)][luma]++;
+            int v = (ae ? ae->transfer[luma] : luma) + row_thresholds[x & 7];
+            v = v < 0 ? 0 : v > 255 ? 255 : v;
+
+            int glyph = hyst->table[cells[x]][v];
+            count += glyph != cells[x];
+            cells[x] = (uint8_t)glyph;
+            memcpy(out + pos, chars + table->offset[glyph], table->len[glyph]);
+            pos += table->len[glyph];
+        }
+        out[pos++] = '\n';
+    }
+
+    *changed += count;
+    return pos;
+}
+
+static size_t charset_rows(const ConvertJob* job, int first, int last,
+                           uint32_t (*hist)[256], char* out) {
+    const Image* img = job->img;
+    const AsciiConfig* config = job->config;
+    const GlyphTable* table = &job->table;
+    const char* chars = ASCII_SETS[config->char_set_index].chars;
+    int output_width = job->output_width;
+    size_t pos = 0;
+    // Local copy: stores to out may alias anything reachable through job
+    uint8_t lut[256];
+    memcpy(lut, job->lut, sizeof(lut));
+
+    for (int y = first; y < last; y++) {
+        int src_y = (int)((float)y / config->aspect_ratio_correction);
+        if (src_y >= img->height) src_y = img->height - 1;
+
+        if (job->dither && table->max_len == 1) {
+            // Whole matrix rows at a time, so each table is a fixed offset
+            const uint8_t (*row_luts)[256] = job->luts + (y & 7) * 8;
+            int x = 0;
+            for (; x + 8 <= output_width; x += 8) {
+                for (int k = 0; k < 8; k++) {
+                    uint8_t luma = pixel_luma(img, x + k, src_y);
+                    if (hist) hist[k & (AUTO_EXPOSURE_LANES - 1)][luma]++;
+                    out[pos + k] = chars[row_luts[k][luma]];
+                }
+                pos += 8;
+            }
+            for (; x < output_width; x++) {
+                uint8_t luma = pixel_luma(img, x, src_y);
+                if (hist) hist[x & (AUTO_EXPOSURE_LANES - 1)][luma]++;
+                out[pos++] = chars[row_luts[x & 7][luma]];
+            }
+        } else if (job->dither) {
+            const uint8_t (*row_luts)[256] = job->luts + (y & 7) * 8;
+            for (int x = 0; x < output_width; x++) {
+                uint8_t luma = pixel_luma(img, x, src_y);
+                if (hist) hist[x & (AUTO_EXPOSURE_LANES - 1)][luma]++;
+                int glyph = row_luts[x & 7][luma];
+                memcpy(out + pos, chars + table->offset[glyph], table->len[glyph]);
+                pos += table->len[glyph];
+            }
+        } else if (table->max_len == 1) {
+            for (int x = 0; x < output_width; x++) {
+                uint8_t luma = pixel_luma(img, x, src_y);
+                if (hist) hist[x & (AUTO_EXPOSURE_LANES - 1)][luma]++;
+                out[pos++] = chars[lut[luma]];
+            }
+        } else {
+            for (int x = 0; x < output_width; x++) {
+                uint8_t luma = pixel_luma(img, x, src_y);
+                if (hist) hist[x & (AUTO_EXPOSURE_LANES - 1)][luma]++;
+                int glyph = lut[luma];
+                memcpy(out + pos, chars + table->offset[glyph], table->len[glyph]);
+                pos += table->len[glyph];
+            }
+        }
+        out[pos++] = '\n';
+    }
+
+    return pos;
+}
+
+// Braille threshold compare folded into a mask table, so there is no
+// per-pixel branch. Non-inverted lights dots on bright pixels, matching
+// the charset ramps.
+static void braille_setup(ConvertJob* job) {
+    AutoExposure* ae = job->exposure;
+    int flip = job->config->invert_brightness ? 0xFF : 0x00;
+    const int threshold = 127;
+
+    for (int b = 0; b < 256; b++) {
+        int level = (ae ? ae->transfer[b] : b) ^ flip;
+        job->cell_lut[b] = level > threshold ? 0xFF : 0x00;
+    }
+}
+
+// Packs each 2x4 block into a braille pattern (U+2800 + dot bits)
+static size_t braille_rows(const ConvertJob* job, int first, int last,
+                           uint32_t (*hist)[256], char* out) {
+    const Image* img = job->img;
+    const uint8_t* dot_mask = job->cell_lut;
+    int output_width = job->output_width;
+    size_t pos = 0;
+
+    for (int cy = first; cy < last; cy++) {
+        for (int cx = 0; cx < output_width; cx++) {
+            unsigned pattern = 0;
+            for (int dy = 0; dy < 4; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    uint8_t luma = pixel_luma(img, cx * 2 + dx, cy * 4 + dy);
+                    if (hist) hist[dx * 2 + (dy & 1)][luma]++;
+                    pattern |= braille_bits[dy][dx] & dot_mask[luma];
+                }
+            }
+            out[pos++] = (char)0xE2;
+            out[pos++] = (char)(0xA0 | (pattern >> 6));
+            out[pos++] = (char)(0x80 | (pattern & 0x3F));
+        }
+        out[pos++] = '\n';
+    }
+
+    return pos;
+}
+
+// Half-block colors on the 24-step xterm gray ramp (colors 232-255)
+static void halfblock_setup(ConvertJob* job) {
+    AutoExposure* ae = job->exposure;
+    int flip = job->config->invert_brightness ? 0xFF : 0x00;
+
+    for (int b = 0; b < 256; b++) {
+        int level = (ae ? ae->transfer[b] : b) ^ flip;
+        job->cell_lut[b] = (uint8_t)(232 + (level * 23 + 127) / 255);
+    }
+}
+
+// One upper-half-block per cell with the top pixel as foreground and the
+// bottom pixel as background. Colors are only re-sent when they change.
+static size_t halfblock_rows(const ConvertJob* job, int first, int last,
+                             uint32_t (*hist)[256], char* out) {
+    const Image* img = job->img;
+    const uint8_t* ramp = job->cell_lut;
+    int output_width = job->output_width;
+    size_t pos = 0;
+
+    for (int cy = first; cy < last; cy++) {
+        int prev_fg = -1, prev_bg = -1;
+
+        for (int cx = 0; cx < output_width; cx++) {
+            uint8_t top = pixel_luma(img, cx, cy * 2);
+            uint8_t bottom = pixel_luma(img, cx, cy * 2 + 1);
+            if (hist) {
+                hist[(cx & 1) * 2][top]++;
+                hist[(cx & 1) * 2 + 1][bottom]++;
+            }
+            int fg = ramp[top];
+            int bg = ramp[bottom];
+
+            if (fg != prev_fg || bg != prev_bg) {
+                memcpy(out + pos, "\x1b[38;5;", 7);
+                out[pos + 7] = (char)('0' + fg / 100);
+                out[pos + 8] = (char)('0' + fg / 10 % 10);
+                out[pos + 9] = (char)('0' + fg % 10);
+                memcpy(out + pos + 10, ";48;5;", 6);
+                out[pos + 16] = (char)('0' + bg / 100);
+                out[pos + 17] = (char)('0' + bg / 10 % 10);
+                out[pos + 18] = (char)('0' + bg % 10);
+                out[pos + 19] = 'm';
+                pos += 20;
+                prev_fg = fg;
+                prev_bg = bg;
+            }
+            memcpy(out + pos, "\xe2\x96\x80", 3);
+            pos += 3;
+        }
+        memcpy(out + pos, HALFBLOCK_RESET, HALFBLOCK_RESET_BYTES);
+        pos += HALFBLOCK_RESET_BYTES;
+        out[pos++] = '\n';
+    }
+
+    return pos;
+}
+
+// Shape levels get the braille polarity. Ink thresholds follow the Bayer
+// matrix, so a flat area lights a share of its mask that tracks brightness
+// while an edge lights one side of it.
+static void shape_setup(ConvertJob* job) {
+    AutoExposure* ae = job->exposure;
+    int flip = job->config->invert_brightness ? 0xFF : 0x00;
+
+    for (int b = 0; b < 256; b++) {
+        job->cell_lut[b] = (uint8_t)((ae ? ae->transfer[b] : b) ^ flip);
+    }
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) job->shape_thresholds[y][x] = (uint8_t)(bayer8[y][x] * 4 + 2);
+    }
+}
+
+// Thresholds each 4x8 block into an 8x8 mask, every pixel setting two
+// adjacent bits, and emits the glyph whose mask is nearest. Masks are built
+// a chunk of cells at a time, streaming along image rows.
+static size_t shape_rows(const ConvertJob* job, int first, int last,
+                         uint32_t (*hist)[256], char* out) {
+    const Image* img = job->img;
+    const ShapeGlyphs* shapes = job->config->shapes;
+    const uint8_t* level = job->cell_lut;
+    int channels = img->channels;
+    int output_width = job->output_width;
+    uint64_t masks[SHAPE_ROW_CHUNK];
+    ShapeMemo memo;
+    shape_memo_init(&memo, shapes);
+    size_t pos = 0;
+
+    for (int cy = first; cy < last; cy++) {
+        for (int cx0 = 0; cx0 < output_width; cx0 += SHAPE_ROW_CHUNK) {
+            int cells = output_width - cx0 < SHAPE_ROW_CHUNK ? output_width - cx0 : SHAPE_ROW_CHUNK;
+            memset(masks, 0, sizeof(uint64_t) * cells);
+
+            for (int dy = 0; dy < SHAPE_CELL_HEIGHT; dy++) {
+                int y = cy * SHAPE_CELL_HEIGHT + dy;
+                const uint8_t* threshold = job->shape_thresholds[y & 7];
+                size_t offset = (size_t)y * img->width + (size_t)cx0 * SHAPE_CELL_WIDTH;
+                const uint8_t* p = img->data + offset * channels;
+                for (int c = 0; c < cells; c++) {
+                    // Cells alternate between the two halves of the Bayer row
+                    const uint8_t* t = threshold + ((cx0 + c) & 1) * SHAPE_CELL_WIDTH;
+                    unsigned row = 0;
+                    for (int dx = 0; dx < SHAPE_CELL_WIDTH; dx++, p += channels) {
+                        int luma = p[0];
+                        if (channels >= 3) luma = rgb_luma(p[0], p[1], p[2]);
+                        if (hist) hist[dx][luma]++;
+                        row |= (unsigned)(level[luma] > t[dx]) << (dx * 2);
+                    }
+                    masks[c] |= (uint64_t)(row * 3) << (dy * SHAPE_MASK_SIZE);
+                }
+            }
+
+            for (int c = 0; c < cells; c++) out[pos++] = shape_memo_match(&memo, shapes, masks[c]);
+        }
+        out[pos++] = '\n';
+    }
+
+    return pos;
+}
+
+static size_t convert_rows(const ConvertJob* job, int first, int last, uint32_t (*hist)[256],
+                           char* out, int64_t* changed) {
+    switch (job->config->mode) {
+        case ASCII_MODE_BRAILLE:
+            return braille_rows(job, first, last, hist, out);
+        case ASCII_MODE_HALFBLOCK:
+            return halfblock_rows(job, first, last, hist, out);
+        case ASCII_MODE_SHAPE:
+            return shape_rows(job, first, last, hist, out);
+        default:
+            if (job->held) return charset_held_rows(job, first, last, hist, out, changed);
+            return charset_rows(job, first, last, hist, out);
+    }
+}
+
+// One band of a parallel conversion. Histogram counts and changed cells are
+// gathered locally and added to the shared totals once per band.
+static void convert_band(void* arg, int band) {
+    ConvertJob* job = (ConvertJob*)arg;
+    int first = band * job->band_rows;
+    int last = first + job->band_rows;
+    if (last > job->output_height) last = job->output_height;
+
+    uint32_t hist[AUTO_EXPOSURE_LANES][256];
+    if (job->exposure) memset(hist, 0, sizeof(hist));
+    int64_t changed = 0;
+
+    job->band_len[band] = convert_rows(job, first, last, job->exposure ? hist : NULL,
+                                       job->out + (size_t)first * job->row_bytes, &changed);
+
+    if (job->exposure) {
+        uint32_t* total = job->exposure->histogram[0];
+        for (int b = 0; b < 256; b++) {
+            uint32_t count = 0;
+            for (int lane = 0; lane < AUTO_EXPOSURE_LANES; lane++) count += hist[lane][b];
+            if (count) __atomic_fetch_add(&total[b], count, __ATOMIC_RELAXED);
+        }
+    }
+    if (changed) __atomic_fetch_add(&job->cells_changed, changed, __ATOMIC_RELAXED);
+}
+
+// Converts every row, in bands on the config's pool when the grid is large
+// enough, and returns the number of bytes written
+static size_t convert_frame(ConvertJob* job) {
+    ThreadPool* pool = job->config->pool;
+    int bands = 1;
+    if (pool && (int64_t)job->output_width * job->output_height >= ASCII_PARALLEL_MIN_CELLS) {
+        bands = (pool->num_threads + 1) * ASCII_BANDS_PER_THREAD;
+        if (bands > ASCII_MAX_BANDS) bands = ASCII_MAX_BANDS;
+    }
+    job->band_rows = (job->output_height + bands - 1) / bands;
+    if (job->band_rows < 1) job->band_rows = 1;
+    int count = (job->output_height + job->band_rows - 1) / job->band_rows;
+
+    if (count <= 1) {
+        AutoExposure* ae = job->exposure;
+        return convert_rows(job, 0, job->output_height, ae ? ae->histogram : NULL, job->out,
+                            &job->cells_changed);
+    }
+
+    thread_pool_parallel_for(pool, count, convert_band, job);
+
+    // Bands only ever move towards the start, so packing in order is safe
+    size_t pos = 0;
+    for (int band = 0; band < count; band++) {
+        size_t offset = (size_t)band * job->band_rows * job->row_bytes;
+        if (offset != pos) memmove(job->out + pos, job->out + offset, job->band_len[band]);
+        pos += job->band_len[band];
+    }
+    return pos;
+}
+
+// Returns 0 without printing on an invalid charset, shape mode without
+// masks or a buffer smaller than ascii_buffer_size; callers report it
+int image_to_ascii_into(const Image* img, const AsciiConfig* config, char* out, size_t out_size) {
+    if (!img || !img->data || !config || !out) return 0;
     
-    const AsciiCharSet* char_set = &ASCII_SETS[config->char_set_index];
-    
-    Image* gray_img = NULL;
-    const Image* work_img = img;
+    if (config->char_set_index < 0 || config->char_set_index >= NUM_ASCII_SETS) return 0;
+    if (config->mode == ASCII_MODE_SHAPE && !config->shapes) return 0;
+    if (out_size < ascii_buffer_size(img->width, img->height, config)) return 0;
     
-    if (img->channels > 1) {
-        gray_img = convert_to_grayscale(img);
-        if (!gray_img) {
-            fprintf(stderr, "Error: Failed to convert image to grayscale\n");
-            return NULL;
-        }
-        work_img = gray_img;
+    uint64_t span = span_begin();
+    ConvertJob job;
+    job.img = img;
+    job.config = config;
+    job.exposure = active_exposure(config);
+    job.output_width = ascii_output_width(img->width, config);
+    job.output_height = ascii_output_height(img->height, config);
+    job.row_bytes = row_capacity(job.output_width, config);
+    job.out = out;
+    job.cells_changed = 0;
+    job.held = 0;
+
+    size_t len = 0;
+    int ready = 1;
+    switch (config->mode) {
+        case ASCII_MODE_BRAILLE:
+            braille_setup(&job);
+            break;
+        case ASCII_MODE_HALFBLOCK:
+            halfblock_setup(&job);
+            break;
+        case ASCII_MODE_SHAPE:
+            shape_setup(&job);
+            break;
+        default:
+            ready = charset_setup(&job);
+            break;
     }
+    if (ready && job.output_width > 0 && job.output_height > 0) len = convert_frame(&job);
+    if (job.held) {
+        config->hysteresis->cells_changed += job.cells_changed;
+        config->hysteresis->cells_total += (int64_t)job.output_width * job.output_height;
+    }
+    
+    out[len] = '\0'; 
+    if (job.exposure) auto_exposure_update(config->exposure);
+    span_end("image_to_ascii", span);
     
-    int output_width = work_img->width;
-    int output_height = (int)(work_img->height * config->aspect_ratio_correction);
+    return 1;
+}
+
+char* image_to_ascii(const Image* img, const AsciiConfig* config) {
+    if (!img || !img->data || !config) return NULL;
     
-    char* ascii_art = malloc((output_width + 1) * output_height + 1);
+    size_t size = ascii_buffer_size(img->width, img->height, config);
+    char* ascii_art = malloc(size);
     if (!ascii_art) {
         fprintf(stderr, "Error: Cannot allocate memory for ASCII art\n");
-        if (gray_img) free_image(gray_img);
         return NULL;
     }
     
-    int ascii_index = 0;
-    
-    for (int y = 0; y < output_height; y++) {
-        for (int x = 0; x < output_width; x++) {
-            int src_y = (int)((float)y / config->aspect_ratio_correction);
-            if (src_y >= work_img->height) src_y = work_img->height - 1;
-            
-            uint8_t brightness = get_pixel_brightness(work_img, x, src_y);
-            char ascii_char = brightness_to_ascii(brightness, char_set, config->invert_brightness);
-            ascii_art[ascii_index++] = ascii_char;
-        }
-        ascii_art[ascii_index++] = '\n'; 
+    if (!image_to_ascii_into(img, config, ascii_art, size)) {
+        fprintf(stderr, "Error: Cannot convert image to ASCII\n");
+        free(ascii_art);
+        return NULL;
     }
     
-    ascii_art[ascii_index] = '\0'; 
-    
-    if (gray_img) free_image(gray_img);
-    
     return ascii_art;
 }
 
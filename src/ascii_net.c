@@ -0,0 +1,137 @@
+#define _GNU_SOURCE
+#include "ascii_net.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+static int parse_tcp_port(const char* spec) {
+    int port = atoi(spec);
+    return (port > 0 && port < 65536) ? port : -1;
+}
+
+static int fill_unix_address(struct sockaddr_un* addr, const char* path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Error: Socket path too long: %s\n", path);
+        return 0;
+    }
+    strcpy(addr->sun_path, path);
+    return 1;
+}
+
+static void fill_tcp_address(struct sockaddr_in* addr, int port) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons((uint16_t)port);
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+int ascii_net_set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return 0;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+int ascii_net_listen(const char* address) {
+    if (!address) return -1;
+
+    int fd = -1;
+
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un addr;
+        if (!fill_unix_address(&addr, address + 5)) return -1;
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+
+        // A stale socket file from a previous run would make bind fail
+        unlink(addr.sun_path);
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            perror("Error: Cannot bind unix socket");
+            close(fd);
+            return -1;
+        }
+    } else if (strncmp(address, "tcp:", 4) == 0) {
+        int port = parse_tcp_port(address + 4);
+        if (port < 0) {
+            fprintf(stderr, "Error: Invalid TCP port in %s\n", address);
+            return -1;
+        }
+
+        struct sockaddr_in addr;
+        fill_tcp_address(&addr, port);
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            perror("Error: Cannot bind TCP socket");
+            close(fd);
+            return -1;
+        }
+    } else {
+        fprintf(stderr, "Error: Address must be unix:<path> or tcp:<port>\n");
+        return -1;
+    }
+
+    if (listen(fd, 16) < 0 || !ascii_net_set_nonblocking(fd)) {
+        perror("Error: Cannot listen on socket");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int ascii_net_connect(const char* address) {
+    if (!address) return -1;
+
+    int fd = -1;
+
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un addr;
+        if (!fill_unix_address(&addr, address + 5)) return -1;
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            perror("Error: Cannot connect to unix socket");
+            close(fd);
+            return -1;
+        }
+    } else if (strncmp(address, "tcp:", 4) == 0) {
+        int port = parse_tcp_port(address + 4);
+        if (port < 0) {
+            fprintf(stderr, "Error: Invalid TCP port in %s\n", address);
+            return -1;
+        }
+
+        struct sockaddr_in addr;
+        fill_tcp_address(&addr, port);
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            perror("Error: Cannot connect to TCP socket");
+            close(fd);
+            return -1;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    } else {
+        fprintf(stderr, "Error: Address must be unix:<path> or tcp:<port>\n");
+        return -1;
+    }
+
+    return fd;
+}
@@ -0,0 +1,279 @@
+#include "ascii_raster.h"
+#include "image_processing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define SGR_MAX_PARAMS 16
+
+static const uint8_t basic_gray[16] = {
+    0, 38, 75, 113, 15, 53, 90, 192,
+    128, 76, 150, 226, 29, 105, 179, 255
+};
+
+// Gray level of an xterm 256-colour index
+static uint8_t xterm_gray(int n) {
+    if (n < 0 || n > 255) return 255;
+    if (n >= 232) return (uint8_t)(8 + (n - 232) * 10);
+    if (n < 16) return basic_gray[n];
+
+    n -= 16;
+    int r = n / 36, g = (n / 6) % 6, b = n % 6;
+    int rv = r ? 55 + r * 40 : 0;
+    int gv = g ? 55 + g * 40 : 0;
+    int bv = b ? 55 + b * 40 : 0;
+    return rgb_luma(rv, gv, bv);
+}
+
+// Applies one CSI sequence starting at the ESC; returns the bytes consumed
+static int apply_escape(const char* p, uint8_t* fg, uint8_t* bg) {
+    if (p[1] != '[') return 1;
+
+    int params[SGR_MAX_PARAMS];
+    int num_params = 0;
+    int value = 0;
+    int i = 2;
+
+    for (; p[i] && p[i] != '\n'; i++) {
+        char c = p[i];
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+        } else if (c == ';') {
+            if (num_params < SGR_MAX_PARAMS) params[num_params++] = value;
+            value = 0;
+        } else {
+            break;
+        }
+    }
+    if (p[i] != 'm') return i;
+    if (num_params < SGR_MAX_PARAMS) params[num_params++] = value;
+
+    for (int k = 0; k < num_params; k++) {
+        if (params[k] == 0) {
+            *fg = 255;
+            *bg = 0;
+        } else if ((params[k] == 38 || params[k] == 48) && k + 2 < num_params &&
+                   params[k + 1] == 5) {
+            uint8_t level = xterm_gray(params[k + 2]);
+            if (params[k] == 38) *fg = level; else *bg = level;
+            k += 2;
+        } else if (params[k] == 39) {
+            *fg = 255;
+        } else if (params[k] == 49) {
+            *bg = 0;
+        }
+    }
+    return i + 1;
+}
+
+static void blit_glyph(uint8_t* dst, int stride, const uint8_t* glyph, int cell_width,
+                       int w, int h, uint8_t fg, uint8_t bg) {
+    if (fg == 255 && bg == 0) {
+        for (int y = 0; y < h; y++) {
+            memcpy(dst + (size_t)y * stride, glyph + (size_t)y * cell_width, w);
+        }
+        return;
+    }
+
+    for (int y = 0; y < h; y++) {
+        uint8_t* out = dst + (size_t)y * stride;
+        const uint8_t* a = glyph + (size_t)y * cell_width;
+        for (int x = 0; x < w; x++) {
+            out[x] = (uint8_t)((bg * (255 - a[x]) + fg * a[x] + 127) / 255);
+        }
+    }
+}
+
+static void raster_row(AsciiRaster* raster, const char* p, uint8_t* dst, int h) {
+    const GlyphCache* glyphs = raster->glyphs;
+    int cell_width = glyphs->cell_width;
+    int width = raster->target_width;
+    uint8_t fg = 255, bg = 0;
+    int x = 0;
+
+    while (*p && *p != '\n' && x < width) {
+        if (*p == '\x1b') {
+            p += apply_escape(p, &fg, &bg);
+            continue;
+        }
+
+        uint32_t codepoint;
+        p += utf8_decode(p, &codepoint);
+
+        int w = width - x < cell_width ? width - x : cell_width;
+        blit_glyph(dst + x, raster->target_stride, glyph_cache_lookup(glyphs, codepoint),
+                   cell_width, w, h, fg, bg);
+        x += cell_width;
+    }
+
+    if (x < width) {
+        for (int y = 0; y < h; y++) {
+            memset(dst + (size_t)y * raster->target_stride + x, 0, width - x);
+        }
+    }
+}
+
+// Widens gray pixels to XRGB8888 (x, g, g, g)
+static void gray_to_xrgb(uint32_t* dst, const uint8_t* src, int width) {
+    int x = 0;
+
+#ifdef __SSE2__
+    // Byte pairs (g, g) and (g, 0) interleave into one pixel per dword
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 16 <= width; x += 16) {
+        __m128i g = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i gg_lo = _mm_unpacklo_epi8(g, g);
+        __m128i gg_hi = _mm_unpackhi_epi8(g, g);
+        __m128i g0_lo = _mm_unpacklo_epi8(g, zero);
+        __m128i g0_hi = _mm_unpackhi_epi8(g, zero);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_unpacklo_epi16(gg_lo, g0_lo));
+        _mm_storeu_si128((__m128i*)(dst + x + 4), _mm_unpackhi_epi16(gg_lo, g0_lo));
+        _mm_storeu_si128((__m128i*)(dst + x + 8), _mm_unpacklo_epi16(gg_hi, g0_hi));
+        _mm_storeu_si128((__m128i*)(dst + x + 12), _mm_unpackhi_epi16(gg_hi, g0_hi));
+    }
+#endif
+    for (; x < width; x++) dst[x] = src[x] * 0x010101u;
+}
+
+static void clear_rows(AsciiRaster* raster, int first, int last) {
+    for (int y = first; y < last; y++) {
+        if (raster->target_xrgb) {
+            memset(raster->target_xrgb + (size_t)y * raster->xrgb_stride, 0,
+                   (size_t)raster->target_width * sizeof(uint32_t));
+        } else {
+            memset(raster->target + (size_t)y * raster->target_stride, 0, raster->target_width);
+        }
+    }
+}
+
+static void raster_band(void* arg, int band) {
+    AsciiRaster* raster = (AsciiRaster*)arg;
+    int cell_height = raster->glyphs->cell_height;
+    int first = band * raster->band_rows;
+    int last = first + raster->band_rows;
+    if (last > raster->num_rows) last = raster->num_rows;
+
+    for (int r = first; r < last; r++) {
+        int y0 = r * cell_height;
+        if (y0 >= raster->target_height) return;
+
+        int h = raster->target_height - y0 < cell_height ? raster->target_height - y0 : cell_height;
+        if (!raster->target_xrgb) {
+            raster_row(raster, raster->rows[r], raster->target + (size_t)y0 * raster->target_stride, h);
+            continue;
+        }
+
+        uint8_t* line = raster->scratch + (size_t)band * raster->target_width * cell_height;
+        raster_row(raster, raster->rows[r], line, h);
+        for (int y = 0; y < h; y++) {
+            gray_to_xrgb(raster->target_xrgb + (size_t)(y0 + y) * raster->xrgb_stride,
+                         line + (size_t)y * raster->target_width, raster->target_width);
+        }
+    }
+
+    // The last band also clears whatever the text does not reach
+    if (last == raster->num_rows) clear_rows(raster, last * cell_height, raster->target_height);
+}
+
+AsciiRaster* ascii_raster_create(const GlyphCache* glyphs, ThreadPool* pool) {
+    if (!glyphs) return NULL;
+
+    AsciiRaster* raster = calloc(1, sizeof(AsciiRaster));
+    if (!raster) return NULL;
+
+    raster->glyphs = glyphs;
+    raster->pool = pool;
+    return raster;
+}
+
+void ascii_raster_destroy(AsciiRaster* raster) {
+    if (!raster) return;
+    free(raster->rows);
+    free(raster->scratch);
+    free(raster);
+}
+
+// Indexes row starts up front so bands can start mid-text, and splits the
+// rows into bands; returns the band count, or -1 when out of memory
+static int raster_prepare(AsciiRaster* raster, const char* ascii_art, int width, int height) {
+    raster->num_rows = 0;
+    const char* p = ascii_art;
+    while (*p) {
+        if (raster->num_rows == raster->row_capacity) {
+            int capacity = raster->row_capacity ? raster->row_capacity * 2 : 256;
+            const char** rows = realloc(raster->rows, capacity * sizeof(const char*));
+            if (!rows) return -1;
+            raster->rows = rows;
+            raster->row_capacity = capacity;
+        }
+        raster->rows[raster->num_rows++] = p;
+
+        const char* end = strchr(p, '\n');
+        if (!end) break;
+        p = end + 1;
+    }
+
+    raster->target_width = width;
+    raster->target_height = height;
+
+    int threads = raster->pool ? raster->pool->num_threads + 1 : 1;
+    int bands = threads * ASCII_RASTER_BANDS_PER_THREAD;
+    raster->band_rows = (raster->num_rows + bands - 1) / bands;
+    if (raster->band_rows < 1) raster->band_rows = 1;
+    return (raster->num_rows + raster->band_rows - 1) / raster->band_rows;
+}
+
+int ascii_raster_render(AsciiRaster* raster, const char* ascii_art, uint8_t* dst,
+                        int width, int height, int stride) {
+    if (!raster || !ascii_art || !dst || width <= 0 || height <= 0) return 0;
+
+    int bands = raster_prepare(raster, ascii_art, width, height);
+    if (bands < 0) return 0;
+
+    raster->target = dst;
+    raster->target_stride = stride;
+    raster->target_xrgb = NULL;
+
+    if (bands == 0) {
+        clear_rows(raster, 0, height);
+        return 1;
+    }
+
+    thread_pool_parallel_for(raster->pool, bands, raster_band, raster);
+    return 1;
+}
+
+// Same text drawn as XRGB8888, e.g. straight into a locked texture; stride
+// is in pixels. Every target pixel is written and none is read back.
+int ascii_raster_render_xrgb(AsciiRaster* raster, const char* ascii_art, uint32_t* dst,
+                             int width, int height, int stride) {
+    if (!raster || !ascii_art || !dst || width <= 0 || height <= 0) return 0;
+
+    int bands = raster_prepare(raster, ascii_art, width, height);
+    if (bands < 0) return 0;
+
+    size_t scratch_size = (size_t)bands * width * raster->glyphs->cell_height;
+    if (scratch_size > raster->scratch_capacity) {
+        uint8_t* scratch = realloc(raster->scratch, scratch_size);
+        if (!scratch) return 0;
+        raster->scratch = scratch;
+        raster->scratch_capacity = scratch_size;
+    }
+
+    // Glyphs are blitted into the band's scratch row, one text row high
+    raster->target = NULL;
+    raster->target_stride = width;
+    raster->target_xrgb = dst;
+    raster->xrgb_stride = stride;
+
+    if (bands == 0) {
+        clear_rows(raster, 0, height);
+        return 1;
+    }
+
+    thread_pool_parallel_for(raster->pool, bands, raster_band, raster);
+    return 1;
+}
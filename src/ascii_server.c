@@ -0,0 +1,464 @@
+#define _GNU_SOURCE
+#include "ascii_server.h"
+#include "ascii_net.h"
+#include "frame_codec.h"
+#include "video_processor.h"
+#include "image_processing.h"
+#include "image_resize.h"
+#include "ascii_converter.h"
+#include "static_frame.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t stream_stop_requested = 0;
+
+static void stream_stop_handler(int sig) {
+    (void)sig;
+    stream_stop_requested = 1;
+}
+
+static double server_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int ensure_capacity(void** buf, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) return 1;
+    void* grown = realloc(*buf, needed);
+    if (!grown) return 0;
+    *buf = grown;
+    *capacity = needed;
+    return 1;
+}
+
+// Both helpers expect server->lock to be held
+static void blob_release(AsciiServer* server, FrameBlob* blob) {
+    if (!blob) return;
+    if (--blob->refcount == 0) {
+        blob->next_free = server->free_list;
+        server->free_list = blob;
+    }
+}
+
+static FrameBlob* blob_acquire(AsciiServer* server) {
+    FrameBlob* blob = server->free_list;
+    if (blob) {
+        server->free_list = blob->next_free;
+    } else {
+        blob = calloc(1, sizeof(FrameBlob));
+        if (!blob) return NULL;
+    }
+    blob->next_free = NULL;
+    blob->refcount = 0;
+    return blob;
+}
+
+static void blob_free(FrameBlob* blob) {
+    if (!blob) return;
+    free(blob->key);
+    free(blob->delta);
+    free(blob);
+}
+
+static void server_wake(AsciiServer* server) {
+    char byte = 1;
+    if (write(server->wake_pipe[1], &byte, 1) < 0) {
+        // Pipe full means a wakeup is already pending
+    }
+}
+
+static void client_close(AsciiServer* server, int index) {
+    ServerClient* client = &server->clients[index];
+
+    pthread_mutex_lock(&server->lock);
+    blob_release(server, client->sending);
+    pthread_mutex_unlock(&server->lock);
+
+    close(client->fd);
+    printf("Client disconnected (%ld frames, %ld keys)\n", client->frames_sent, client->keys_sent);
+
+    server->clients[index] = server->clients[server->num_clients - 1];
+    server->num_clients--;
+}
+
+// Picks the next message for an idle client. Clients that keep up get
+// consecutive deltas; clients more than SERVER_LAG_FRAMES behind only get
+// the newest key until they have kept up for SERVER_RECOVER_FRAMES.
+static void client_schedule(AsciiServer* server, ServerClient* client) {
+    pthread_mutex_lock(&server->lock);
+
+    if (!server->has_frame || (client->has_sent && client->last_seq == server->latest_seq)) {
+        pthread_mutex_unlock(&server->lock);
+        return;
+    }
+
+    uint32_t latest = server->latest_seq;
+    uint32_t backlog = client->has_sent ? latest - client->last_seq : UINT32_MAX;
+
+    if (client->has_sent && !client->key_only && backlog > SERVER_LAG_FRAMES) {
+        client->key_only = 1;
+        client->on_time = 0;
+        printf("Client fell %u frames behind, switching to key-only updates\n", backlog);
+    } else if (client->key_only) {
+        client->on_time = backlog <= 1 ? client->on_time + 1 : 0;
+        if (client->on_time >= SERVER_RECOVER_FRAMES) {
+            client->key_only = 0;
+            printf("Client caught up, resuming delta updates\n");
+        }
+    }
+
+    FrameBlob* blob = NULL;
+    int use_delta = 0;
+
+    if (!client->key_only && client->has_sent && backlog < SERVER_RING_SIZE) {
+        FrameBlob* next = server->ring[(client->last_seq + 1) % SERVER_RING_SIZE];
+        if (next && next->seq == client->last_seq + 1 && next->delta_len > 0) {
+            blob = next;
+            use_delta = 1;
+        }
+    }
+
+    if (!blob) {
+        blob = server->ring[latest % SERVER_RING_SIZE];
+    }
+
+    blob->refcount++;
+    client->sending = blob;
+    client->send_seq = blob->seq;
+    client->send_data = use_delta ? blob->delta : blob->key;
+    client->send_len = use_delta ? blob->delta_len : blob->key_len;
+    client->send_pos = 0;
+    if (!use_delta) client->keys_sent++;
+
+    pthread_mutex_unlock(&server->lock);
+}
+
+// Writes as much as the socket accepts. Returns 0 if the client is gone.
+static int client_flush(AsciiServer* server, ServerClient* client) {
+    // Bounded so one fast client cannot starve the others
+    for (int burst = 0; burst < SERVER_RING_SIZE; burst++) {
+        if (!client->sending) {
+            client_schedule(server, client);
+            if (!client->sending) return 1;
+        }
+
+        while (client->send_pos < client->send_len) {
+            ssize_t n = send(client->fd, client->send_data + client->send_pos,
+                             client->send_len - client->send_pos, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return 1;
+                return 0;
+            }
+            client->send_pos += n;
+        }
+
+        pthread_mutex_lock(&server->lock);
+        blob_release(server, client->sending);
+        pthread_mutex_unlock(&server->lock);
+
+        client->sending = NULL;
+        client->last_seq = client->send_seq;
+        client->has_sent = 1;
+        client->frames_sent++;
+    }
+
+    return 1;
+}
+
+static void server_accept(AsciiServer* server) {
+    while (1) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) return;
+
+        if (server->num_clients >= SERVER_MAX_CLIENTS || !ascii_net_set_nonblocking(fd)) {
+            fprintf(stderr, "Warning: Rejecting client (limit %d)\n", SERVER_MAX_CLIENTS);
+            close(fd);
+            continue;
+        }
+
+        ServerClient* client = &server->clients[server->num_clients++];
+        memset(client, 0, sizeof(ServerClient));
+        client->fd = fd;
+        printf("Client connected (%d total)\n", server->num_clients);
+    }
+}
+
+static void* server_thread(void* arg) {
+    AsciiServer* server = (AsciiServer*)arg;
+    struct pollfd fds[SERVER_MAX_CLIENTS + 2];
+
+    while (__atomic_load_n(&server->running, __ATOMIC_ACQUIRE)) {
+        fds[0].fd = server->wake_pipe[0];
+        fds[0].events = POLLIN;
+        fds[1].fd = server->listen_fd;
+        fds[1].events = POLLIN;
+
+        int count = server->num_clients;
+        for (int i = 0; i < count; i++) {
+            fds[i + 2].fd = server->clients[i].fd;
+            fds[i + 2].events = POLLIN | (server->clients[i].sending ? POLLOUT : 0);
+            fds[i + 2].revents = 0;
+        }
+
+        if (poll(fds, count + 2, 100) < 0 && errno != EINTR) break;
+
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (read(server->wake_pipe[0], drain, sizeof(drain)) > 0) {}
+        }
+
+        // Walk backwards so closing (swap-with-last) keeps indices valid
+        for (int i = count - 1; i >= 0; i--) {
+            int alive = 1;
+            short revents = fds[i + 2].revents;
+
+            if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                alive = 0;
+            } else if (revents & POLLIN) {
+                char discard[256];
+                ssize_t n = recv(server->clients[i].fd, discard, sizeof(discard), MSG_DONTWAIT);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) alive = 0;
+            }
+
+            if (alive) alive = client_flush(server, &server->clients[i]);
+            if (!alive) client_close(server, i);
+        }
+
+        if (fds[1].revents & POLLIN) {
+            server_accept(server);
+        }
+    }
+
+    return NULL;
+}
+
+AsciiServer* ascii_server_start(const char* address) {
+    AsciiServer* server = calloc(1, sizeof(AsciiServer));
+    if (!server) return NULL;
+
+    server->listen_fd = ascii_net_listen(address);
+    if (server->listen_fd < 0) {
+        free(server);
+        return NULL;
+    }
+
+    if (strncmp(address, "unix:", 5) == 0) {
+        server->unix_path = strdup(address + 5);
+    }
+
+    if (pipe(server->wake_pipe) < 0 ||
+        !ascii_net_set_nonblocking(server->wake_pipe[0]) ||
+        !ascii_net_set_nonblocking(server->wake_pipe[1])) {
+        perror("Error: Cannot create wakeup pipe");
+        close(server->listen_fd);
+        free(server->unix_path);
+        free(server);
+        return NULL;
+    }
+
+    pthread_mutex_init(&server->lock, NULL);
+    server->running = 1;
+
+    if (pthread_create(&server->thread, NULL, server_thread, server) != 0) {
+        fprintf(stderr, "Error: Cannot start server thread\n");
+        server->running = 0;
+        ascii_server_stop(server);
+        return NULL;
+    }
+
+    printf("ASCII server listening on %s\n", address);
+    return server;
+}
+
+void ascii_server_stop(AsciiServer* server) {
+    if (!server) return;
+
+    if (__atomic_exchange_n(&server->running, 0, __ATOMIC_ACQ_REL)) {
+        server_wake(server);
+        pthread_join(server->thread, NULL);
+    }
+
+    while (server->num_clients > 0) {
+        client_close(server, server->num_clients - 1);
+    }
+
+    for (int i = 0; i < SERVER_RING_SIZE; i++) {
+        blob_free(server->ring[i]);
+    }
+    while (server->free_list) {
+        FrameBlob* next = server->free_list->next_free;
+        blob_free(server->free_list);
+        server->free_list = next;
+    }
+
+    close(server->listen_fd);
+    close(server->wake_pipe[0]);
+    close(server->wake_pipe[1]);
+    if (server->unix_path) {
+        unlink(server->unix_path);
+        free(server->unix_path);
+    }
+
+    pthread_mutex_destroy(&server->lock);
+    free(server->prev_text);
+    free(server);
+}
+
+// Encodes the frame once (as both a key and a delta against the previous
+// frame) and publishes it to the ring. Never waits on clients.
+int ascii_server_publish(AsciiServer* server, const char* ascii_art) {
+    if (!server || !ascii_art) return 0;
+
+    pthread_mutex_lock(&server->lock);
+    FrameBlob* blob = blob_acquire(server);
+    uint32_t seq = server->has_frame ? server->latest_seq + 1 : 0;
+    int has_prev = server->has_frame;
+    pthread_mutex_unlock(&server->lock);
+
+    if (!blob) return 0;
+
+    // The blob is private until it is linked into the ring below
+    size_t text_len = strlen(ascii_art);
+    size_t max_size = frame_codec_max_size(text_len, frame_codec_count_rows(ascii_art));
+    int ok = ensure_capacity((void**)&blob->key, &blob->key_capacity, max_size) &&
+             ensure_capacity((void**)&blob->delta, &blob->delta_capacity, max_size);
+
+    if (ok) {
+        blob->seq = seq;
+        blob->key_len = frame_codec_encode_key(ascii_art, seq, blob->key, blob->key_capacity);
+        blob->delta_len = has_prev ? frame_codec_encode_delta(server->prev_text, ascii_art, seq,
+                                                              blob->delta, blob->delta_capacity) : 0;
+        ok = blob->key_len > 0 &&
+             ensure_capacity((void**)&server->prev_text, &server->prev_capacity, text_len + 1);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    if (!ok) {
+        blob->refcount = 1;
+        blob_release(server, blob);
+        pthread_mutex_unlock(&server->lock);
+        return 0;
+    }
+
+    memcpy(server->prev_text, ascii_art, text_len + 1);
+
+    int slot = seq % SERVER_RING_SIZE;
+    blob_release(server, server->ring[slot]);
+    blob->refcount = 1;
+    server->ring[slot] = blob;
+    server->latest_seq = seq;
+    server->has_frame = 1;
+    pthread_mutex_unlock(&server->lock);
+
+    server_wake(server);
+    return 1;
+}
+
+int ascii_server_client_count(AsciiServer* server) {
+    if (!server) return 0;
+    return __atomic_load_n(&server->num_clients, __ATOMIC_RELAXED);
+}
+
+// Headless source: decodes and converts the video once at its native rate
+// (looping) and publishes every frame until interrupted.
+int ascii_server_stream_video(const char* video_file, const char* address, int cols, int rows,
+                              int static_skip) {
+    VideoProcessor* vp = video_processor_init(video_file);
+    if (!vp) {
+        fprintf(stderr, "Error: Failed to initialize video processor\n");
+        return 1;
+    }
+
+    AsciiConfig config = create_default_config();
+    int grid_w, grid_h, max_grid_w, max_grid_h;
+    ascii_grid_limits(&config, cols, rows, &max_grid_w, &max_grid_h);
+    fit_aspect_ratio(vp->width, vp->height, max_grid_w, max_grid_h, &grid_w, &grid_h);
+
+    Image* frame = create_image(vp->width, vp->height, 3);
+    Image* grid = create_image(grid_w, grid_h, 3);
+    ResizePlan* plan = resize_plan_create(vp->width, vp->height, grid_w, grid_h, 3,
+                                          RESIZE_DEFAULT_FILTER);
+    if (!plan) fprintf(stderr, "Error: Cannot allocate resize plan\n");
+    size_t ascii_size = ascii_buffer_size(grid_w, grid_h, &config);
+    char* ascii = malloc(ascii_size);
+    AsciiServer* server = (frame && grid && plan && ascii) ? ascii_server_start(address) : NULL;
+
+    if (!server) {
+        fprintf(stderr, "Error: Failed to start ASCII server\n");
+        free(ascii);
+        resize_plan_destroy(plan);
+        free_image(grid);
+        free_image(frame);
+        video_processor_cleanup(vp);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stream_stop_handler;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    double interval = vp->fps > 0.0 ? 1000.0 / vp->fps : 1000.0 / 30.0;
+    double next_due = server_now_ms();
+    int64_t published = 0;
+    int result = 0;
+    StaticFrameDetector static_frames;
+    static_frame_init(&static_frames);
+    static_frame_set_enabled(&static_frames, static_skip);
+
+    printf("Streaming %s as %dx%d characters at %.2f FPS (Ctrl+C to stop)\n",
+           video_file, ascii_output_width(grid_w, &config), ascii_output_height(grid_h, &config),
+           vp->fps);
+
+    while (!stream_stop_requested) {
+        double now = server_now_ms();
+        if (now < next_due) {
+            struct timespec ts = {0, (long)((next_due - now) * 1000000.0)};
+            nanosleep(&ts, NULL);
+            continue;
+        }
+
+        if (!video_processor_read_frame(vp, frame)) {
+            video_processor_reset(vp);
+            continue;
+        }
+
+        // Clients already show an unchanged frame; skip converting and sending it
+        resize_plan_run(plan, frame, grid, NULL);
+        if (!static_frame_check(&static_frames, grid)) {
+            if (!image_to_ascii_into(grid, &config, ascii, ascii_size)) {
+                fprintf(stderr, "Error: Cannot convert frame %ld to ASCII\n", vp->current_frame);
+                result = 1;
+                break;
+            }
+            ascii_server_publish(server, ascii);
+            published++;
+        }
+
+        // Do not try to make up for a stall by bursting frames
+        next_due += interval;
+        if (now - next_due > interval) next_due = now;
+    }
+
+    printf("Server stopped after %ld frames (%.1f%% static frames skipped)\n", published,
+           static_frame_skip_rate(&static_frames) * 100.0);
+
+    ascii_server_stop(server);
+    static_frame_free(&static_frames);
+    free(ascii);
+    resize_plan_destroy(plan);
+    free_image(grid);
+    free_image(frame);
+    video_processor_cleanup(vp);
+    return result;
+}
@@ -0,0 +1,209 @@
+#define _GNU_SOURCE
+#include "asciicast_recorder.h"
+#include "video_processor.h"
+#include "image_processing.h"
+#include "image_resize.h"
+#include "ascii_converter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int line_reserve(AsciicastRecorder* rec, size_t needed) {
+    if (needed <= rec->line_capacity) return 1;
+
+    size_t capacity = rec->line_capacity ? rec->line_capacity : 16384;
+    while (capacity < needed) capacity *= 2;
+
+    char* line = realloc(rec->line, capacity);
+    if (!line) return 0;
+    rec->line = line;
+    rec->line_capacity = capacity;
+    return 1;
+}
+
+// JSON string body; UTF-8 passes through, control bytes are escaped
+static size_t json_escape(char* out, const char* data, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)data[i];
+        if (c == '"' || c == '\\') {
+            out[n++] = '\\';
+            out[n++] = (char)c;
+        } else if (c == '\n') {
+            out[n++] = '\\';
+            out[n++] = 'n';
+        } else if (c < 0x20) {
+            memcpy(out + n, "\\u00", 4);
+            out[n + 4] = hex[c >> 4];
+            out[n + 5] = hex[c & 0xF];
+            n += 6;
+        } else {
+            out[n++] = (char)c;
+        }
+    }
+    return n;
+}
+
+// Terminal columns of one row: UTF-8 lead bytes, not counting escapes
+static int row_columns(const char* row) {
+    int cols = 0;
+    const char* p = row;
+
+    while (*p && *p != '\n') {
+        if (*p == '\x1b' && p[1] == '[') {
+            p += 2;
+            while (*p && !(*p >= 0x40 && *p <= 0x7E)) p++;
+            if (*p) p++;
+            continue;
+        }
+        if (((unsigned char)*p & 0xC0) != 0x80) cols++;
+        p++;
+    }
+    return cols;
+}
+
+static int write_header(AsciicastRecorder* rec, const char* ascii_art) {
+    int rows = 0;
+    for (const char* p = ascii_art; *p; p++) {
+        if (*p == '\n') rows++;
+    }
+    if (ascii_art[0] && ascii_art[strlen(ascii_art) - 1] != '\n') rows++;
+
+    char header[256];
+    int n = snprintf(header, sizeof(header),
+                     "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": %lld, "
+                     "\"env\": {\"TERM\": \"xterm-256color\"}}\n",
+                     row_columns(ascii_art), rows, (long long)time(NULL));
+    return async_writer_write(rec->writer, header, n);
+}
+
+AsciicastRecorder* asciicast_recorder_open(const char* filename) {
+    AsciicastRecorder* rec = calloc(1, sizeof(AsciicastRecorder));
+    if (!rec) return NULL;
+
+    rec->writer = async_writer_open(filename, ASYNC_WRITER_BUFFER_SIZE);
+    rec->diff = term_display_init(-1);
+    if (!rec->writer || !rec->diff) {
+        fprintf(stderr, "Error: Cannot start asciicast recording\n");
+        if (rec->writer) async_writer_close(rec->writer);
+        term_display_cleanup(rec->diff);
+        free(rec);
+        return NULL;
+    }
+
+    return rec;
+}
+
+// time_s is the frame's media time. Recordings start at zero, and a jump
+// backwards (seek or loop) continues from the last event instead of
+// producing a non-monotonic cast.
+int asciicast_recorder_frame(AsciicastRecorder* rec, const char* ascii_art, double time_s) {
+    if (!rec || !ascii_art) return 0;
+
+    if (!rec->header_written) {
+        if (!write_header(rec, ascii_art)) return 0;
+        rec->header_written = 1;
+        rec->base_time = time_s;
+    }
+
+    double t = time_s - rec->base_time;
+    if (t < rec->last_time) {
+        rec->base_time = time_s - rec->last_time;
+        t = rec->last_time;
+    }
+
+    int first = rec->frames == 0;
+    if (!term_display_encode_frame(rec->diff, ascii_art)) return 0;
+    rec->frames++;
+
+    // Unchanged frame: nothing for a player to draw
+    if (rec->diff->out_len == 0) {
+        rec->empty_frames++;
+        return 1;
+    }
+    rec->last_time = t;
+
+    size_t setup_len = first ? sizeof(TERM_DISPLAY_SETUP) - 1 : 0;
+    if (!line_reserve(rec, 48 + (setup_len + rec->diff->out_len) * 6)) return 0;
+
+    size_t n = (size_t)snprintf(rec->line, rec->line_capacity, "[%.6f, \"o\", \"", t);
+    if (first) n += json_escape(rec->line + n, TERM_DISPLAY_SETUP, setup_len);
+    n += json_escape(rec->line + n, rec->diff->out, rec->diff->out_len);
+    memcpy(rec->line + n, "\"]\n", 3);
+    n += 3;
+
+    return async_writer_write(rec->writer, rec->line, n);
+}
+
+int asciicast_recorder_close(AsciicastRecorder* rec) {
+    if (!rec) return 0;
+
+    int ok = async_writer_close(rec->writer);
+    term_display_cleanup(rec->diff);
+    free(rec->line);
+    free(rec);
+    return ok;
+}
+
+int asciicast_recorder_convert(const char* video_file, const char* output_file, int cols, int rows) {
+    VideoProcessor* vp = video_processor_init(video_file);
+    if (!vp) {
+        fprintf(stderr, "Error: Failed to initialize video processor\n");
+        return 1;
+    }
+
+    AsciiConfig config = create_default_config();
+    int grid_w, grid_h, max_grid_w, max_grid_h;
+    ascii_grid_limits(&config, cols, rows, &max_grid_w, &max_grid_h);
+    fit_aspect_ratio(vp->width, vp->height, max_grid_w, max_grid_h, &grid_w, &grid_h);
+
+    Image* frame = create_image(vp->width, vp->height, 3);
+    Image* grid = create_image(grid_w, grid_h, 3);
+    ResizePlan* plan = resize_plan_create(vp->width, vp->height, grid_w, grid_h, 3,
+                                          RESIZE_DEFAULT_FILTER);
+    if (!plan) fprintf(stderr, "Error: Cannot allocate resize plan\n");
+    size_t ascii_size = ascii_buffer_size(grid_w, grid_h, &config);
+    char* ascii = malloc(ascii_size);
+    AsciicastRecorder* rec = (frame && grid && plan && ascii) ? asciicast_recorder_open(output_file) : NULL;
+
+    if (!rec) {
+        free(ascii);
+        resize_plan_destroy(plan);
+        free_image(grid);
+        free_image(frame);
+        video_processor_cleanup(vp);
+        return 1;
+    }
+
+    printf("Recording %s to %s as %dx%d characters\n", video_file, output_file,
+           ascii_output_width(grid_w, &config), ascii_output_height(grid_h, &config));
+
+    int result = 0;
+    while (video_processor_read_frame(vp, frame)) {
+        resize_plan_run(plan, frame, grid, NULL);
+        if (!image_to_ascii_into(grid, &config, ascii, ascii_size)) {
+            fprintf(stderr, "Error: Cannot convert frame %ld to ASCII\n", vp->current_frame);
+            result = 1;
+            break;
+        }
+        if (!asciicast_recorder_frame(rec, ascii, video_processor_frame_time(vp))) {
+            fprintf(stderr, "Error: Recording failed at frame %ld\n", vp->current_frame);
+            result = 1;
+            break;
+        }
+    }
+
+    int64_t frames = rec->frames;
+    if (!asciicast_recorder_close(rec)) result = 1;
+    printf("Recorded %ld frames\n", frames);
+
+    free(ascii);
+    resize_plan_destroy(plan);
+    free_image(grid);
+    free_image(frame);
+    video_processor_cleanup(vp);
+    return result;
+}
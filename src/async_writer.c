@@ -0,0 +1,179 @@
+#define _GNU_SOURCE
+#include "async_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+static double writer_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void* async_writer_thread(void* arg) {
+    AsyncWriter* writer = (AsyncWriter*)arg;
+
+    pthread_mutex_lock(&writer->lock);
+    while (1) {
+        while (!writer->busy && !writer->shutdown) {
+            pthread_cond_wait(&writer->work, &writer->lock);
+        }
+        if (!writer->busy) break;
+
+        int index = writer->pending;
+        pthread_mutex_unlock(&writer->lock);
+
+        // The caller does not touch the pending buffer until busy clears
+        const char* data = writer->buffers[index];
+        size_t len = writer->length[index];
+        size_t written = 0;
+        int failed = 0;
+        while (written < len) {
+            ssize_t n = write(writer->fd, data + written, len - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                failed = 1;
+                break;
+            }
+            written += n;
+        }
+
+        pthread_mutex_lock(&writer->lock);
+        writer->length[index] = 0;
+        writer->bytes_written += written;
+        if (failed) writer->failed = 1;
+        writer->busy = 0;
+        pthread_cond_broadcast(&writer->done);
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+AsyncWriter* async_writer_open(const char* filename, size_t buffer_size) {
+    if (!filename) return NULL;
+    if (buffer_size == 0) buffer_size = ASYNC_WRITER_BUFFER_SIZE;
+
+    AsyncWriter* writer = calloc(1, sizeof(AsyncWriter));
+    if (!writer) return NULL;
+
+    writer->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0) {
+        fprintf(stderr, "Error: Cannot open %s for writing\n", filename);
+        free(writer);
+        return NULL;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        writer->buffers[i] = malloc(buffer_size);
+        writer->capacity[i] = buffer_size;
+    }
+    if (!writer->buffers[0] || !writer->buffers[1]) {
+        fprintf(stderr, "Error: Cannot allocate write buffers\n");
+        free(writer->buffers[0]);
+        free(writer->buffers[1]);
+        close(writer->fd);
+        free(writer);
+        return NULL;
+    }
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->work, NULL);
+    pthread_cond_init(&writer->done, NULL);
+    writer->last_handoff_ms = writer_now_ms();
+
+    if (pthread_create(&writer->thread, NULL, async_writer_thread, writer) != 0) {
+        fprintf(stderr, "Error: Cannot start writer thread\n");
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->work);
+        pthread_cond_destroy(&writer->done);
+        free(writer->buffers[0]);
+        free(writer->buffers[1]);
+        close(writer->fd);
+        free(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+// Swaps the buffers if the writer thread is idle; never waits
+static int async_writer_handoff(AsyncWriter* writer) {
+    pthread_mutex_lock(&writer->lock);
+    if (writer->busy) {
+        pthread_mutex_unlock(&writer->lock);
+        return 0;
+    }
+
+    writer->pending = writer->front;
+    writer->front = 1 - writer->front;
+    writer->busy = 1;
+    pthread_cond_signal(&writer->work);
+    pthread_mutex_unlock(&writer->lock);
+
+    writer->last_handoff_ms = writer_now_ms();
+    return 1;
+}
+
+int async_writer_write(AsyncWriter* writer, const void* data, size_t len) {
+    if (!writer || writer->failed) return 0;
+
+    int front = writer->front;
+    if (writer->length[front] + len > writer->capacity[front] &&
+        writer->length[front] > 0 && async_writer_handoff(writer)) {
+        front = writer->front;
+    }
+
+    if (writer->length[front] + len > writer->capacity[front]) {
+        size_t capacity = writer->capacity[front] * 2;
+        while (capacity < writer->length[front] + len) capacity *= 2;
+
+        char* buffer = realloc(writer->buffers[front], capacity);
+        if (!buffer) return 0;
+        writer->buffers[front] = buffer;
+        writer->capacity[front] = capacity;
+        writer->grows++;
+    }
+
+    memcpy(writer->buffers[front] + writer->length[front], data, len);
+    writer->length[front] += len;
+
+    if (writer_now_ms() - writer->last_handoff_ms >= ASYNC_WRITER_FLUSH_MS) {
+        async_writer_handoff(writer);
+    }
+    return 1;
+}
+
+// Flushes everything, stops the thread and closes the file
+int async_writer_close(AsyncWriter* writer) {
+    if (!writer) return 0;
+
+    pthread_mutex_lock(&writer->lock);
+    while (writer->busy) pthread_cond_wait(&writer->done, &writer->lock);
+    if (writer->length[writer->front] > 0) {
+        writer->pending = writer->front;
+        writer->front = 1 - writer->front;
+        writer->busy = 1;
+        pthread_cond_signal(&writer->work);
+    }
+    writer->shutdown = 1;
+    pthread_cond_signal(&writer->work);
+    pthread_mutex_unlock(&writer->lock);
+
+    pthread_join(writer->thread, NULL);
+
+    int ok = !writer->failed;
+    if (close(writer->fd) != 0) ok = 0;
+
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->work);
+    pthread_cond_destroy(&writer->done);
+    free(writer->buffers[0]);
+    free(writer->buffers[1]);
+    free(writer);
+    return ok;
+}
@@ -0,0 +1,348 @@
+#define _GNU_SOURCE
+#include "audio_player.h"
+#include "startup_profile.h"
+#include "span_trace.h"
+#include "alloc_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libavutil/channel_layout.h>
+
+static void audio_callback(void* userdata, Uint8* stream, int len) {
+    AudioPlayer* ap = (AudioPlayer*)userdata;
+    size_t frame_bytes = (size_t)ap->channels * sizeof(int16_t);
+    int wanted = len / (int)frame_bytes;
+    uint64_t read = ap->read_pos;
+    uint64_t write = __atomic_load_n(&ap->write_pos, __ATOMIC_ACQUIRE);
+
+    // Until the decode thread has started the segment a seek asked for,
+    // whatever is left in the ring belongs to the old position
+    int current = ap->segment_request == __atomic_load_n(&ap->seek_requests, __ATOMIC_ACQUIRE);
+    uint64_t available = current ? write - read : 0;
+    int frames = available < (uint64_t)wanted ? (int)available : wanted;
+
+    size_t start = read & (AUDIO_RING_FRAMES - 1);
+    int first = AUDIO_RING_FRAMES - (int)start;
+    if (first > frames) first = frames;
+    memcpy(stream, ap->ring + start * ap->channels, first * frame_bytes);
+    memcpy(stream + first * frame_bytes, ap->ring, (frames - first) * frame_bytes);
+    memset(stream + frames * frame_bytes, 0, (size_t)len - frames * frame_bytes);
+
+    if (frames < wanted && current && read > 0 && !__atomic_load_n(&ap->at_end, __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&ap->underruns, 1, __ATOMIC_RELAXED);
+    }
+
+    // What is handed over now starts playing once the buffer ahead of it
+    // has, roughly one device buffer from now
+    ap->clock_valid = frames > 0;
+    if (frames > 0) {
+        ap->clock_time = ap->segment_time + (double)(read - ap->segment_pos) / ap->sample_rate -
+                         (double)ap->device_frames / ap->sample_rate;
+        ap->clock_ms = startup_now_ms();
+    }
+    __atomic_store_n(&ap->read_pos, read + frames, __ATOMIC_RELEASE);
+}
+
+// Next decoded frame into ap->frame. Returns 0 once the stream is drained.
+static int audio_player_decode(AudioPlayer* ap) {
+    while (1) {
+        int ret = avcodec_receive_frame(ap->codec_ctx, ap->frame);
+        if (ret == 0) return 1;
+        if (ret != AVERROR(EAGAIN)) return 0;
+
+        if (av_read_frame(ap->format_ctx, ap->packet) < 0) {
+            // End of file: drain what the codec still holds
+            avcodec_send_packet(ap->codec_ctx, NULL);
+            continue;
+        }
+        if (ap->packet->stream_index == ap->stream_index) {
+            avcodec_send_packet(ap->codec_ctx, ap->packet);
+        }
+        av_packet_unref(ap->packet);
+    }
+}
+
+static double audio_player_frame_time(AudioPlayer* ap) {
+    int64_t pts = ap->frame->best_effort_timestamp;
+    if (pts == AV_NOPTS_VALUE) pts = ap->frame->pts;
+    if (pts == AV_NOPTS_VALUE) return -1.0;
+    return pts * av_q2d(ap->time_base) - ap->origin;
+}
+
+// Seeks the demuxer and empties the ring. The reset happens under the
+// device lock, so the callback sees either the old segment or the new one.
+static void audio_player_do_seek(AudioPlayer* ap, double target, uint64_t request) {
+    int64_t ts = (int64_t)((target + ap->origin) / av_q2d(ap->time_base));
+    av_seek_frame(ap->format_ctx, ap->stream_index, ts, AVSEEK_FLAG_BACKWARD);
+    avcodec_flush_buffers(ap->codec_ctx);
+    swr_init(ap->swr);
+
+    SDL_LockAudioDevice(ap->device);
+    ap->read_pos = 0;
+    ap->write_pos = 0;
+    ap->segment_request = request;
+    ap->clock_valid = 0;
+    SDL_UnlockAudioDevice(ap->device);
+    __atomic_store_n(&ap->at_end, 0, __ATOMIC_RELEASE);
+}
+
+// Converts ap->frame into the ring. Returns 0, leaving the frame pending,
+// while the ring has no room for it.
+static int audio_player_write(AudioPlayer* ap, int* segment_open, double segment_time) {
+    int max_frames = swr_get_out_samples(ap->swr, ap->frame->nb_samples);
+    if (max_frames > ap->scratch_frames) {
+        int16_t* scratch = realloc(ap->scratch, (size_t)max_frames * ap->channels * sizeof(int16_t));
+        if (!scratch) return 0;
+        ap->scratch = scratch;
+        ap->scratch_frames = max_frames;
+    }
+
+    uint64_t write = ap->write_pos;
+    uint64_t read = __atomic_load_n(&ap->read_pos, __ATOMIC_ACQUIRE);
+    if (AUDIO_RING_FRAMES - (write - read) < (uint64_t)max_frames) return 0;
+
+    uint8_t* out[1] = {(uint8_t*)ap->scratch};
+    int frames = swr_convert(ap->swr, out, max_frames, (const uint8_t**)ap->frame->extended_data,
+                             ap->frame->nb_samples);
+    if (frames <= 0) return 1;
+
+    size_t start = write & (AUDIO_RING_FRAMES - 1);
+    int first = AUDIO_RING_FRAMES - (int)start;
+    if (first > frames) first = frames;
+    memcpy(ap->ring + start * ap->channels, ap->scratch, (size_t)first * ap->channels * sizeof(int16_t));
+    memcpy(ap->ring, ap->scratch + (size_t)first * ap->channels,
+           (size_t)(frames - first) * ap->channels * sizeof(int16_t));
+
+    if (!*segment_open) {
+        SDL_LockAudioDevice(ap->device);
+        ap->segment_time = segment_time;
+        ap->segment_pos = write;
+        SDL_UnlockAudioDevice(ap->device);
+        *segment_open = 1;
+    }
+    __atomic_store_n(&ap->write_pos, write + frames, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static void* audio_thread(void* arg) {
+    AudioPlayer* ap = (AudioPlayer*)arg;
+    span_trace_name_thread("audio");
+    alloc_scope_enter(ALLOC_SCOPE_DECODE);
+
+    uint64_t handled = 0;
+    double target = 0.0;
+    int segment_open = 0;
+    int pending = 0;
+
+    while (!__atomic_load_n(&ap->stop, __ATOMIC_ACQUIRE)) {
+        uint64_t requests = __atomic_load_n(&ap->seek_requests, __ATOMIC_ACQUIRE);
+        if (requests != handled) {
+            handled = requests;
+            target = __atomic_load_n(&ap->seek_target_us, __ATOMIC_ACQUIRE) / 1e6;
+            audio_player_do_seek(ap, target, handled);
+            av_frame_unref(ap->frame);
+            segment_open = 0;
+            pending = 0;
+            continue;
+        }
+
+        if (!pending && !__atomic_load_n(&ap->at_end, __ATOMIC_ACQUIRE)) {
+            if (!audio_player_decode(ap)) {
+                __atomic_store_n(&ap->at_end, 1, __ATOMIC_RELEASE);
+                continue;
+            }
+            // Seeks land on the packet before the target; frames that end
+            // before it are not played
+            double time = audio_player_frame_time(ap);
+            double end = time + (double)ap->frame->nb_samples / ap->codec_ctx->sample_rate;
+            if (!segment_open && time >= 0.0 && end <= target) {
+                av_frame_unref(ap->frame);
+                continue;
+            }
+            pending = 1;
+        }
+
+        if (pending) {
+            double time = audio_player_frame_time(ap);
+            if (audio_player_write(ap, &segment_open, time >= 0.0 ? time : target)) {
+                av_frame_unref(ap->frame);
+                pending = 0;
+                continue;
+            }
+        }
+        SDL_Delay(AUDIO_IDLE_MS);
+    }
+    return NULL;
+}
+
+static int audio_player_open(AudioPlayer* ap, const char* filename) {
+    if (avformat_open_input(&ap->format_ctx, filename, NULL, NULL) < 0 ||
+        avformat_find_stream_info(ap->format_ctx, NULL) < 0) {
+        return 0;
+    }
+
+    const AVCodec* codec = NULL;
+    ap->stream_index = av_find_best_stream(ap->format_ctx, AVMEDIA_TYPE_AUDIO, -1, -1, &codec, 0);
+    if (ap->stream_index < 0 || !codec) return 0;
+
+    // Times follow the first video stream, the one the video decoder plays
+    for (unsigned int i = 0; i < ap->format_ctx->nb_streams; i++) {
+        AVStream* stream = ap->format_ctx->streams[i];
+        if (stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            if (stream->start_time != AV_NOPTS_VALUE) {
+                ap->origin = stream->start_time * av_q2d(stream->time_base);
+            }
+            break;
+        }
+    }
+    // Only audio packets are read; everything else is skipped in the demuxer
+    for (unsigned int i = 0; i < ap->format_ctx->nb_streams; i++) {
+        if ((int)i != ap->stream_index) ap->format_ctx->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    AVStream* stream = ap->format_ctx->streams[ap->stream_index];
+    ap->time_base = stream->time_base;
+    ap->codec_ctx = avcodec_alloc_context3(codec);
+    if (!ap->codec_ctx || avcodec_parameters_to_context(ap->codec_ctx, stream->codecpar) < 0 ||
+        avcodec_open2(ap->codec_ctx, codec, NULL) < 0) {
+        fprintf(stderr, "Error: Cannot open audio codec\n");
+        return 0;
+    }
+
+    ap->packet = av_packet_alloc();
+    ap->frame = av_frame_alloc();
+    if (!ap->packet || !ap->frame) {
+        fprintf(stderr, "Error: Cannot allocate audio frames/packet\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int audio_player_open_device(AudioPlayer* ap) {
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        fprintf(stderr, "Error: Cannot initialize SDL audio: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    SDL_AudioSpec desired, obtained;
+    memset(&desired, 0, sizeof(desired));
+    desired.freq = ap->codec_ctx->sample_rate;
+    desired.format = AUDIO_S16SYS;
+    desired.channels = ap->codec_ctx->ch_layout.nb_channels > 1 ? 2 : 1;
+    desired.samples = AUDIO_DEVICE_FRAMES;
+    desired.callback = audio_callback;
+    desired.userdata = ap;
+
+    ap->device = SDL_OpenAudioDevice(NULL, 0, &desired, &obtained,
+                                     SDL_AUDIO_ALLOW_FREQUENCY_CHANGE |
+                                     SDL_AUDIO_ALLOW_CHANNELS_CHANGE);
+    if (ap->device == 0) {
+        fprintf(stderr, "Error: Cannot open audio device: %s\n", SDL_GetError());
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return 0;
+    }
+    ap->sample_rate = obtained.freq;
+    ap->channels = obtained.channels;
+    ap->device_frames = obtained.samples;
+
+    AVChannelLayout out_layout;
+    av_channel_layout_default(&out_layout, ap->channels);
+    if (swr_alloc_set_opts2(&ap->swr, &out_layout, AV_SAMPLE_FMT_S16, ap->sample_rate,
+                            &ap->codec_ctx->ch_layout, ap->codec_ctx->sample_fmt,
+                            ap->codec_ctx->sample_rate, 0, NULL) < 0 ||
+        swr_init(ap->swr) < 0) {
+        fprintf(stderr, "Error: Cannot initialize audio resampler\n");
+        return 0;
+    }
+
+    ap->ring = calloc((size_t)AUDIO_RING_FRAMES * ap->channels, sizeof(int16_t));
+    if (!ap->ring) {
+        fprintf(stderr, "Error: Cannot allocate audio ring\n");
+        return 0;
+    }
+    return 1;
+}
+
+// Returns NULL when the file has no playable audio; the device starts paused
+AudioPlayer* audio_player_create(const char* filename) {
+    if (!filename) return NULL;
+
+    AudioPlayer* ap = calloc(1, sizeof(AudioPlayer));
+    if (!ap) return NULL;
+
+    if (!audio_player_open(ap, filename) || !audio_player_open_device(ap) ||
+        pthread_create(&ap->thread, NULL, audio_thread, ap) != 0) {
+        audio_player_destroy(ap);
+        return NULL;
+    }
+    ap->thread_started = 1;
+    return ap;
+}
+
+void audio_player_destroy(AudioPlayer* ap) {
+    if (!ap) return;
+
+    // The decode thread locks the device and the callback reads the ring,
+    // so the thread goes first, then the device, then the buffers
+    if (ap->thread_started) {
+        __atomic_store_n(&ap->stop, 1, __ATOMIC_RELEASE);
+        pthread_join(ap->thread, NULL);
+    }
+    if (ap->device) {
+        SDL_CloseAudioDevice(ap->device);
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    }
+
+    swr_free(&ap->swr);
+    av_frame_free(&ap->frame);
+    av_packet_free(&ap->packet);
+    avcodec_free_context(&ap->codec_ctx);
+    if (ap->format_ctx) avformat_close_input(&ap->format_ctx);
+    free(ap->ring);
+    free(ap->scratch);
+    free(ap);
+}
+
+// Asks the decode thread to continue from seconds. The clock stays invalid
+// until samples from there are playing.
+void audio_player_seek(AudioPlayer* ap, double seconds) {
+    if (!ap) return;
+    if (seconds < 0.0) seconds = 0.0;
+
+    __atomic_store_n(&ap->seek_target_us, (int64_t)(seconds * 1e6), __ATOMIC_RELEASE);
+    SDL_LockAudioDevice(ap->device);
+    ap->clock_valid = 0;
+    __atomic_add_fetch(&ap->seek_requests, 1, __ATOMIC_ACQ_REL);
+    SDL_UnlockAudioDevice(ap->device);
+}
+
+void audio_player_set_paused(AudioPlayer* ap, int paused) {
+    if (!ap) return;
+
+    SDL_PauseAudioDevice(ap->device, paused);
+    if (paused) {
+        SDL_LockAudioDevice(ap->device);
+        ap->clock_valid = 0;
+        SDL_UnlockAudioDevice(ap->device);
+    }
+}
+
+// Media time being heard now. Between callbacks it advances with the
+// monotonic clock, but never by more than one device buffer, so a stalled
+// or starved device stops the clock instead of letting it run on.
+int audio_player_clock(AudioPlayer* ap, double* seconds) {
+    if (!ap) return 0;
+
+    SDL_LockAudioDevice(ap->device);
+    int valid = ap->clock_valid;
+    double time = ap->clock_time;
+    double stamp = ap->clock_ms;
+    SDL_UnlockAudioDevice(ap->device);
+    if (!valid) return 0;
+
+    double ahead = (startup_now_ms() - stamp) / 1000.0;
+    double limit = (double)ap->device_frames / ap->sample_rate;
+    if (ahead > limit) ahead = limit;
+    *seconds = time + ahead;
+    return 1;
+}
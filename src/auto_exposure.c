@@ -0,0 +1,134 @@
+#define _GNU_SOURCE
+#include "auto_exposure.h"
+#include <string.h>
+#include <strings.h>
+
+static const char* mode_names[AUTO_EXPOSURE_MODE_COUNT] = {
+    "off",
+    "levels",
+    "equalize"
+};
+
+void auto_exposure_init(AutoExposure* ae, AutoExposureMode mode) {
+    ae->mode = mode;
+    auto_exposure_reset(ae);
+}
+
+// Back to the identity curve; the next update starts from that frame alone
+void auto_exposure_reset(AutoExposure* ae) {
+    memset(ae->histogram, 0, sizeof(ae->histogram));
+    for (int b = 0; b < 256; b++) {
+        ae->curve[b] = (float)b;
+        ae->transfer[b] = (uint8_t)b;
+    }
+    ae->has_curve = 0;
+    ae->settled = 0;
+}
+
+// Linear stretch of the clipped [lo, hi] range onto [0, 255]
+static void levels_curve(const uint32_t* hist, uint32_t total, float* target) {
+    uint32_t clip = (uint32_t)(total * AUTO_EXPOSURE_CLIP);
+    uint32_t cumulative = 0;
+    int lo = 0, hi = 255;
+
+    for (int b = 0; b < 256; b++) {
+        cumulative += hist[b];
+        if (cumulative > clip) {
+            lo = b;
+            break;
+        }
+    }
+    cumulative = 0;
+    for (int b = 255; b >= 0; b--) {
+        cumulative += hist[b];
+        if (cumulative > clip) {
+            hi = b;
+            break;
+        }
+    }
+
+    if (hi - lo < AUTO_EXPOSURE_MIN_RANGE) {
+        lo = (lo + hi - AUTO_EXPOSURE_MIN_RANGE) / 2;
+        if (lo < 0) lo = 0;
+        if (lo > 255 - AUTO_EXPOSURE_MIN_RANGE) lo = 255 - AUTO_EXPOSURE_MIN_RANGE;
+        hi = lo + AUTO_EXPOSURE_MIN_RANGE;
+    }
+
+    float gain = 255.0f / (float)(hi - lo);
+    for (int b = 0; b < 256; b++) {
+        float v = (float)(b - lo) * gain;
+        target[b] = v < 0.0f ? 0.0f : v > 255.0f ? 255.0f : v;
+    }
+}
+
+// Contrast-limited equalization: bins above the limit are clipped and the
+// excess spread evenly, so a large flat area cannot claim most of the ramp
+static void equalize_curve(const uint32_t* hist, uint32_t total, float* target) {
+    uint32_t limit = (uint32_t)(((uint64_t)total * AUTO_EXPOSURE_EQ_LIMIT) / 256);
+    if (limit < 1) limit = 1;
+
+    uint32_t excess = 0;
+    for (int b = 0; b < 256; b++) {
+        if (hist[b] > limit) excess += hist[b] - limit;
+    }
+    float spread = (float)excess / 256.0f;
+
+    float cumulative = 0.0f;
+    for (int b = 0; b < 256; b++) {
+        float count = (float)(hist[b] > limit ? limit : hist[b]) + spread;
+        // Midpoint of the bin, so the curve is symmetric for a flat histogram
+        target[b] = (cumulative + count * 0.5f) * 255.0f / (float)total;
+        cumulative += count;
+    }
+}
+
+// Builds the curve for the histogram gathered since the last update, blends
+// it into the running curve and clears the histogram for the next frame
+void auto_exposure_update(AutoExposure* ae) {
+    if (ae->mode == AUTO_EXPOSURE_OFF) return;
+
+    uint32_t hist[256];
+    uint32_t total = 0;
+    for (int b = 0; b < 256; b++) {
+        uint32_t count = 0;
+        for (int lane = 0; lane < AUTO_EXPOSURE_LANES; lane++) count += ae->histogram[lane][b];
+        hist[b] = count;
+        total += count;
+    }
+    memset(ae->histogram, 0, sizeof(ae->histogram));
+    if (total == 0) return;
+
+    float target[256];
+    if (ae->mode == AUTO_EXPOSURE_EQUALIZE) {
+        equalize_curve(hist, total, target);
+    } else {
+        levels_curve(hist, total, target);
+    }
+
+    float weight = ae->has_curve ? AUTO_EXPOSURE_SMOOTHING : 1.0f;
+    int changed = 0;
+    for (int b = 0; b < 256; b++) {
+        ae->curve[b] += (target[b] - ae->curve[b]) * weight;
+        int v = (int)(ae->curve[b] + 0.5f);
+        uint8_t t = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+        changed |= t != ae->transfer[b];
+        ae->transfer[b] = t;
+    }
+    ae->has_curve = 1;
+    ae->settled = !changed;
+}
+
+const char* auto_exposure_mode_name(AutoExposureMode mode) {
+    if (mode < 0 || mode >= AUTO_EXPOSURE_MODE_COUNT) return "unknown";
+    return mode_names[mode];
+}
+
+int auto_exposure_parse_mode(const char* name, AutoExposureMode* mode) {
+    for (int i = 0; i < AUTO_EXPOSURE_MODE_COUNT; i++) {
+        if (strcasecmp(name, mode_names[i]) == 0) {
+            *mode = (AutoExposureMode)i;
+            return 1;
+        }
+    }
+    return 0;
+}
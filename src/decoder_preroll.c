@@ -0,0 +1,120 @@
+#define _GNU_SOURCE
+#include "decoder_preroll.h"
+#include "span_trace.h"
+#include "alloc_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void release(VideoProcessor* vp, Image* frame) {
+    if (vp) video_processor_cleanup(vp);
+    free_image(frame);
+}
+
+static void* preroll_thread(void* arg) {
+    DecoderPreroll* preroll = (DecoderPreroll*)arg;
+    span_trace_name_thread("preroll");
+    alloc_scope_enter(ALLOC_SCOPE_DECODE);
+    uint64_t span = span_begin();
+
+    // Whatever the last swap retired goes first; its frame buffer is reused
+    // when the size still fits
+    Image* frame = preroll->retired_frame;
+    if (preroll->retired) video_processor_cleanup(preroll->retired);
+    preroll->retired = NULL;
+    preroll->retired_frame = NULL;
+
+    VideoProcessor* vp = video_processor_init(preroll->video_file);
+    if (vp && !video_processor_set_roi(vp, preroll->roi[0], preroll->roi[1], preroll->roi[2],
+                                       preroll->roi[3])) {
+        video_processor_cleanup(vp);
+        vp = NULL;
+    }
+    if (vp && (!frame || frame->width != vp->width || frame->height != vp->height ||
+               frame->channels != 3)) {
+        free_image(frame);
+        frame = create_image(vp->width, vp->height, 3);
+    }
+
+    if (!vp || !frame || !video_processor_read_frame(vp, frame)) {
+        release(vp, frame);
+        vp = NULL;
+        frame = NULL;
+    }
+
+    preroll->video_processor = vp;
+    preroll->frame = frame;
+    span_end("preroll", span);
+    __atomic_store_n(&preroll->ready, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+DecoderPreroll* decoder_preroll_create(const char* video_file) {
+    if (!video_file) return NULL;
+
+    DecoderPreroll* preroll = calloc(1, sizeof(DecoderPreroll));
+    if (!preroll) return NULL;
+
+    preroll->video_file = strdup(video_file);
+    if (!preroll->video_file) {
+        free(preroll);
+        return NULL;
+    }
+    return preroll;
+}
+
+void decoder_preroll_destroy(DecoderPreroll* preroll) {
+    if (!preroll) return;
+    if (preroll->running) pthread_join(preroll->thread, NULL);
+    release(preroll->video_processor, preroll->frame);
+    release(preroll->retired, preroll->retired_frame);
+    free(preroll->video_file);
+    free(preroll);
+}
+
+// Starts pre-rolling unless a decoder is already on its way
+int decoder_preroll_start(DecoderPreroll* preroll) {
+    if (!preroll) return 0;
+    if (preroll->running) return 1;
+
+    preroll->ready = 0;
+    if (pthread_create(&preroll->thread, NULL, preroll_thread, preroll) != 0) {
+        fprintf(stderr, "Error: Cannot start decoder pre-roll thread\n");
+        return 0;
+    }
+    preroll->running = 1;
+    return 1;
+}
+
+int decoder_preroll_ready(DecoderPreroll* preroll) {
+    return preroll && preroll->running && __atomic_load_n(&preroll->ready, __ATOMIC_ACQUIRE);
+}
+
+// Hands over the pre-rolled decoder with its first frame already converted
+// into *frame. Waits for the helper if it has not finished yet; returns NULL
+// when nothing was started or opening failed.
+VideoProcessor* decoder_preroll_take(DecoderPreroll* preroll, Image** frame) {
+    if (!preroll || !preroll->running) return NULL;
+
+    pthread_join(preroll->thread, NULL);
+    preroll->running = 0;
+
+    VideoProcessor* vp = preroll->video_processor;
+    *frame = preroll->frame;
+    preroll->video_processor = NULL;
+    preroll->frame = NULL;
+    return vp;
+}
+
+void decoder_preroll_retire(DecoderPreroll* preroll, VideoProcessor* vp, Image* frame) {
+    // The helper reads the retired slot while it runs, so only an idle
+    // pre-roll can take it over
+    if (!preroll || preroll->running) {
+        release(vp, frame);
+        return;
+    }
+
+    release(preroll->retired, preroll->retired_frame);
+    preroll->retired = vp;
+    preroll->retired_frame = frame;
+}
@@ -0,0 +1,106 @@
+#define _GNU_SOURCE
+#include "font_loader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const char* font_paths[] = {
+    "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+    "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+    "/System/Library/Fonts/Monaco.ttf",
+    "/usr/share/fonts/truetype/liberation/LiberationMono-Regular.ttf",
+    NULL
+};
+
+static int font_cache_path(char* path, size_t size) {
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    int n;
+
+    if (xdg && *xdg) {
+        n = snprintf(path, size, "%s/video-ascii", xdg);
+    } else if (home && *home) {
+        n = snprintf(path, size, "%s/.cache/video-ascii", home);
+    } else {
+        return 0;
+    }
+    if (n < 0 || (size_t)n >= size) return 0;
+
+    // Best effort: the parent of the cache dir may not exist yet either
+    char* slash = strrchr(path, '/');
+    if (slash && slash != path) {
+        *slash = '\0';
+        mkdir(path, 0755);
+        *slash = '/';
+    }
+    mkdir(path, 0755);
+
+    int m = snprintf(path + n, size - n, "/font.cache");
+    return m > 0 && (size_t)m < size - n;
+}
+
+// Cache line format: version font_size char_width char_height font_mtime path
+static TTF_Font* font_cache_load(int font_size, int* char_width, int* char_height) {
+    char cache_path[1024];
+    if (!font_cache_path(cache_path, sizeof(cache_path))) return NULL;
+
+    FILE* fp = fopen(cache_path, "r");
+    if (!fp) return NULL;
+
+    int version, cached_size, cached_width, cached_height;
+    long long mtime;
+    char font_path[1024];
+    int fields = fscanf(fp, "%d %d %d %d %lld %1023[^\n]",
+                        &version, &cached_size, &cached_width, &cached_height, &mtime, font_path);
+    fclose(fp);
+
+    if (fields != 6 || version != FONT_CACHE_VERSION || cached_size != font_size ||
+        cached_width <= 0 || cached_height <= 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (stat(font_path, &st) != 0 || (long long)st.st_mtime != mtime) return NULL;
+
+    TTF_Font* font = TTF_OpenFont(font_path, font_size);
+    if (!font) return NULL;
+
+    *char_width = cached_width;
+    *char_height = cached_height;
+    return font;
+}
+
+static void font_cache_store(int font_size, int char_width, int char_height, const char* font_path) {
+    char cache_path[1024];
+    struct stat st;
+    if (!font_cache_path(cache_path, sizeof(cache_path)) || stat(font_path, &st) != 0) return;
+
+    FILE* fp = fopen(cache_path, "w");
+    if (!fp) return;
+
+    fprintf(fp, "%d %d %d %d %lld %s\n", FONT_CACHE_VERSION, font_size,
+            char_width, char_height, (long long)st.st_mtime, font_path);
+    fclose(fp);
+}
+
+// The cached font skips both the path search and the glyph measurement
+TTF_Font* font_loader_open(int font_size, int* char_width, int* char_height, int* cache_hit) {
+    TTF_Font* font = font_cache_load(font_size, char_width, char_height);
+    if (cache_hit) *cache_hit = font != NULL;
+    if (font) return font;
+
+    for (int i = 0; font_paths[i] != NULL; i++) {
+        font = TTF_OpenFont(font_paths[i], font_size);
+        if (font) {
+            int w, h;
+            TTF_SizeText(font, "M", &w, &h);
+            *char_width = w;
+            *char_height = h;
+            font_cache_store(font_size, w, h, font_paths[i]);
+            return font;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,216 @@
+#include "frame_codec.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_header(uint8_t* out, uint8_t type, int rows, uint32_t seq, uint32_t payload_len) {
+    put_u32(out, FRAME_CODEC_MAGIC);
+    out[4] = type;
+    out[5] = 0;
+    put_u16(out + 6, (uint16_t)rows);
+    put_u32(out + 8, seq);
+    put_u32(out + 12, payload_len);
+}
+
+int frame_codec_count_rows(const char* ascii_art) {
+    if (!ascii_art || !*ascii_art) return 0;
+
+    int rows = 0;
+    const char* p = ascii_art;
+    while ((p = strchr(p, '\n')) != NULL) {
+        rows++;
+        p++;
+    }
+    // A trailing row without a newline still counts
+    size_t len = strlen(ascii_art);
+    if (ascii_art[len - 1] != '\n') rows++;
+    return rows;
+}
+
+size_t frame_codec_max_size(size_t text_len, int rows) {
+    return FRAME_CODEC_HEADER_SIZE + text_len + (size_t)rows * 4;
+}
+
+size_t frame_codec_encode_key(const char* ascii_art, uint32_t seq, uint8_t* out, size_t capacity) {
+    if (!ascii_art || !out) return 0;
+
+    size_t len = strlen(ascii_art);
+    if (FRAME_CODEC_HEADER_SIZE + len > capacity) return 0;
+
+    write_header(out, FRAME_TYPE_KEY, frame_codec_count_rows(ascii_art), seq, (uint32_t)len);
+    memcpy(out + FRAME_CODEC_HEADER_SIZE, ascii_art, len);
+    return FRAME_CODEC_HEADER_SIZE + len;
+}
+
+size_t frame_codec_encode_delta(const char* prev, const char* cur, uint32_t seq, uint8_t* out, size_t capacity) {
+    if (!prev || !cur || !out || capacity < FRAME_CODEC_HEADER_SIZE) return 0;
+
+    size_t pos = FRAME_CODEC_HEADER_SIZE;
+    int row = 0;
+
+    while (*cur) {
+        const char* cur_eol = strchr(cur, '\n');
+        size_t cur_len = cur_eol ? (size_t)(cur_eol - cur) : strlen(cur);
+
+        int changed = 1;
+        if (*prev) {
+            const char* prev_eol = strchr(prev, '\n');
+            size_t prev_len = prev_eol ? (size_t)(prev_eol - prev) : strlen(prev);
+            changed = prev_len != cur_len || memcmp(prev, cur, cur_len) != 0;
+            prev = prev_eol ? prev_eol + 1 : prev + prev_len;
+        }
+
+        if (changed) {
+            if (cur_len > 0xFFFF || pos + 4 + cur_len > capacity) return 0;
+            put_u16(out + pos, (uint16_t)row);
+            put_u16(out + pos + 2, (uint16_t)cur_len);
+            memcpy(out + pos + 4, cur, cur_len);
+            pos += 4 + cur_len;
+        }
+
+        row++;
+        if (!cur_eol) break;
+        cur = cur_eol + 1;
+    }
+
+    write_header(out, FRAME_TYPE_DELTA, row, seq, (uint32_t)(pos - FRAME_CODEC_HEADER_SIZE));
+    return pos;
+}
+
+int frame_codec_read_header(const uint8_t* buf, FrameHeader* header) {
+    if (!buf || !header || get_u32(buf) != FRAME_CODEC_MAGIC) return 0;
+
+    header->type = buf[4];
+    header->rows = get_u16(buf + 6);
+    header->seq = get_u32(buf + 8);
+    header->payload_len = get_u32(buf + 12);
+
+    return header->type == FRAME_TYPE_KEY || header->type == FRAME_TYPE_DELTA;
+}
+
+FrameState* frame_state_create(void) {
+    return calloc(1, sizeof(FrameState));
+}
+
+void frame_state_free(FrameState* state) {
+    if (!state) return;
+    for (int i = 0; i < state->rows_capacity; i++) {
+        free(state->rows[i].data);
+    }
+    free(state->rows);
+    free(state->text);
+    free(state);
+}
+
+static int frame_state_resize(FrameState* state, int rows) {
+    if (rows > state->rows_capacity) {
+        FrameRow* grown = realloc(state->rows, rows * sizeof(FrameRow));
+        if (!grown) return 0;
+        memset(grown + state->rows_capacity, 0, (rows - state->rows_capacity) * sizeof(FrameRow));
+        state->rows = grown;
+        state->rows_capacity = rows;
+    }
+    for (int i = state->num_rows; i < rows; i++) {
+        state->rows[i].len = 0;
+    }
+    state->num_rows = rows;
+    return 1;
+}
+
+static int frame_state_set_row(FrameState* state, int row, const uint8_t* data, int len) {
+    FrameRow* r = &state->rows[row];
+    if (len > r->capacity) {
+        char* grown = realloc(r->data, len);
+        if (!grown) return 0;
+        r->data = grown;
+        r->capacity = len;
+    }
+    memcpy(r->data, data, len);
+    r->len = len;
+    return 1;
+}
+
+// Returns 0 if the message cannot be applied (a delta that does not follow
+// the current frame); the caller should then wait for the next key.
+int frame_state_apply(FrameState* state, const FrameHeader* header, const uint8_t* payload) {
+    if (!state || !header || (!payload && header->payload_len > 0)) return 0;
+
+    if (header->type == FRAME_TYPE_DELTA &&
+        (!state->has_key || header->seq != state->seq + 1)) {
+        return 0;
+    }
+
+    if (!frame_state_resize(state, header->rows)) return 0;
+
+    const uint8_t* p = payload;
+    const uint8_t* end = payload + header->payload_len;
+
+    if (header->type == FRAME_TYPE_KEY) {
+        for (int row = 0; row < header->rows && p < end; row++) {
+            const uint8_t* eol = memchr(p, '\n', end - p);
+            int len = eol ? (int)(eol - p) : (int)(end - p);
+            if (!frame_state_set_row(state, row, p, len)) return 0;
+            p += len + (eol ? 1 : 0);
+        }
+        state->has_key = 1;
+    } else {
+        while (p + 4 <= end) {
+            int row = get_u16(p);
+            int len = get_u16(p + 2);
+            p += 4;
+            if (row >= header->rows || p + len > end) return 0;
+            if (!frame_state_set_row(state, row, p, len)) return 0;
+            p += len;
+        }
+    }
+
+    state->seq = header->seq;
+    return 1;
+}
+
+const char* frame_state_text(FrameState* state) {
+    if (!state) return NULL;
+
+    size_t size = 1;
+    for (int i = 0; i < state->num_rows; i++) {
+        size += state->rows[i].len + 1;
+    }
+
+    if (size > state->text_capacity) {
+        char* grown = realloc(state->text, size);
+        if (!grown) return NULL;
+        state->text = grown;
+        state->text_capacity = size;
+    }
+
+    char* out = state->text;
+    for (int i = 0; i < state->num_rows; i++) {
+        if (state->rows[i].len > 0) {
+            memcpy(out, state->rows[i].data, state->rows[i].len);
+            out += state->rows[i].len;
+        }
+        *out++ = '\n';
+    }
+    *out = '\0';
+
+    return state->text;
+}
@@ -0,0 +1,337 @@
+#define _GNU_SOURCE
+#include "frame_trace.h"
+#include "video_processor.h"
+#include "image_processing.h"
+#include "image_resize.h"
+#include "ascii_converter.h"
+#include "ascii_raster.h"
+#include "term_display.h"
+#include "font_loader.h"
+#include "startup_profile.h"
+#include "alloc_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+FrameTraceWriter* frame_trace_writer_open(const char* filename, int width, int height, int channels) {
+    if (width <= 0 || height <= 0 || channels <= 0) return NULL;
+
+    FrameTraceWriter* tw = calloc(1, sizeof(FrameTraceWriter));
+    if (!tw) return NULL;
+
+    tw->header.magic = FRAME_TRACE_MAGIC;
+    tw->header.version = FRAME_TRACE_VERSION;
+    tw->header.width = width;
+    tw->header.height = height;
+    tw->header.channels = channels;
+
+    tw->writer = async_writer_open(filename, ASYNC_WRITER_BUFFER_SIZE * 8);
+    if (!tw->writer || !async_writer_write(tw->writer, &tw->header, sizeof(tw->header))) {
+        if (tw->writer) async_writer_close(tw->writer);
+        free(tw);
+        return NULL;
+    }
+
+    return tw;
+}
+
+int frame_trace_writer_append(FrameTraceWriter* tw, const Image* img, double time_s) {
+    if (!tw || !img || (uint32_t)img->width != tw->header.width ||
+        (uint32_t)img->height != tw->header.height || (uint32_t)img->channels != tw->header.channels) {
+        return 0;
+    }
+
+    size_t size = (size_t)img->width * img->height * img->channels;
+    if (!async_writer_write(tw->writer, &time_s, sizeof(time_s)) ||
+        !async_writer_write(tw->writer, img->data, size)) {
+        return 0;
+    }
+    tw->frames++;
+    return 1;
+}
+
+int frame_trace_writer_close(FrameTraceWriter* tw) {
+    if (!tw) return 0;
+    int ok = async_writer_close(tw->writer);
+    free(tw);
+    return ok;
+}
+
+FrameTrace* frame_trace_open(const char* filename) {
+    FrameTrace* trace = calloc(1, sizeof(FrameTrace));
+    if (!trace) return NULL;
+
+    trace->fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (trace->fd < 0 || fstat(trace->fd, &st) != 0 || (size_t)st.st_size < sizeof(FrameTraceHeader)) {
+        fprintf(stderr, "Error: Cannot open trace %s\n", filename);
+        if (trace->fd >= 0) close(trace->fd);
+        free(trace);
+        return NULL;
+    }
+
+    trace->map_size = st.st_size;
+    trace->map = mmap(NULL, trace->map_size, PROT_READ, MAP_PRIVATE, trace->fd, 0);
+    if (trace->map == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map trace %s\n", filename);
+        close(trace->fd);
+        free(trace);
+        return NULL;
+    }
+
+    memcpy(&trace->header, trace->map, sizeof(FrameTraceHeader));
+    if (trace->header.magic != FRAME_TRACE_MAGIC || trace->header.version != FRAME_TRACE_VERSION ||
+        trace->header.width == 0 || trace->header.height == 0 || trace->header.channels == 0) {
+        fprintf(stderr, "Error: %s is not a frame trace\n", filename);
+        frame_trace_close(trace);
+        return NULL;
+    }
+
+    trace->record_size = sizeof(double) +
+                         (size_t)trace->header.width * trace->header.height * trace->header.channels;
+    trace->num_frames = (trace->map_size - sizeof(FrameTraceHeader)) / trace->record_size;
+
+    madvise(trace->map, trace->map_size, MADV_SEQUENTIAL);
+    return trace;
+}
+
+void frame_trace_close(FrameTrace* trace) {
+    if (!trace) return;
+    if (trace->map && trace->map != MAP_FAILED) munmap(trace->map, trace->map_size);
+    if (trace->fd >= 0) close(trace->fd);
+    free(trace);
+}
+
+// Points view at the mapped pixels; nothing is copied
+int frame_trace_frame(const FrameTrace* trace, int64_t index, Image* view, double* time_s) {
+    if (!trace || !view || index < 0 || index >= trace->num_frames) return 0;
+
+    const uint8_t* record = trace->map + sizeof(FrameTraceHeader) + (size_t)index * trace->record_size;
+    if (time_s) memcpy(time_s, record, sizeof(double));
+
+    view->width = trace->header.width;
+    view->height = trace->header.height;
+    view->channels = trace->header.channels;
+    view->data = (uint8_t*)(record + sizeof(double));
+    return 1;
+}
+
+int frame_trace_capture(const char* video_file, const char* trace_file, int cols, int rows) {
+    VideoProcessor* vp = video_processor_init(video_file);
+    if (!vp) {
+        fprintf(stderr, "Error: Failed to initialize video processor\n");
+        return 1;
+    }
+
+    AsciiConfig config = create_default_config();
+    int grid_w, grid_h, max_grid_w, max_grid_h;
+    ascii_grid_limits(&config, cols, rows, &max_grid_w, &max_grid_h);
+    fit_aspect_ratio(vp->width, vp->height, max_grid_w, max_grid_h, &grid_w, &grid_h);
+
+    Image* frame = create_image(vp->width, vp->height, 3);
+    Image* grid = create_image(grid_w, grid_h, 3);
+    ResizePlan* plan = resize_plan_create(vp->width, vp->height, grid_w, grid_h, 3,
+                                          RESIZE_DEFAULT_FILTER);
+    if (!plan) fprintf(stderr, "Error: Cannot allocate resize plan\n");
+    FrameTraceWriter* tw = (frame && grid && plan) ?
+                           frame_trace_writer_open(trace_file, grid_w, grid_h, 3) : NULL;
+
+    int result = 1;
+    if (tw) {
+        printf("Capturing %s to %s at %dx%d\n", video_file, trace_file, grid_w, grid_h);
+        result = 0;
+
+        while (video_processor_read_frame(vp, frame)) {
+            resize_plan_run(plan, frame, grid, NULL);
+            if (!frame_trace_writer_append(tw, grid, video_processor_frame_time(vp))) {
+                fprintf(stderr, "Error: Trace write failed at frame %ld\n", vp->current_frame);
+                result = 1;
+                break;
+            }
+        }
+
+        int64_t frames = tw->frames;
+        if (!frame_trace_writer_close(tw)) result = 1;
+        printf("Captured %ld frames\n", frames);
+    } else {
+        fprintf(stderr, "Error: Failed to set up trace capture\n");
+    }
+
+    resize_plan_destroy(plan);
+    free_image(grid);
+    free_image(frame);
+    video_processor_cleanup(vp);
+    return result;
+}
+
+typedef struct {
+    double convert_ms;
+    double term_ms;
+    double raster_ms;
+    uint32_t checksum;
+    // Heap allocations after the first (warm-up) pass, per scope
+    uint64_t steady_allocs[ALLOC_SCOPE_COUNT];
+} ReplayStats;
+
+// FNV-1a over the converted text, so an A/B run can tell a faster kernel
+// from one that changed the output
+static uint32_t checksum_update(uint32_t hash, const char* text) {
+    for (const uint8_t* p = (const uint8_t*)text; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+static int replay_mode(const FrameTrace* trace, AsciiMode mode, int iterations, ThreadPool* pool,
+                       const ShapeGlyphs* shapes, AsciiRaster* raster, ReplayStats* stats) {
+    AsciiConfig config = create_default_config();
+    config.mode = mode;
+    config.pool = pool;
+    config.shapes = shapes;
+
+    int width = trace->header.width;
+    int height = trace->header.height;
+    size_t ascii_size = ascii_buffer_size(width, height, &config);
+    char* ascii = malloc(ascii_size);
+    TermDisplay* term = term_display_init(-1);
+
+    uint8_t* pixels = NULL;
+    int fb_w = 0, fb_h = 0;
+    if (raster) {
+        fb_w = ascii_output_width(width, &config) * raster->glyphs->cell_width;
+        fb_h = ascii_output_height(height, &config) * raster->glyphs->cell_height;
+        pixels = malloc((size_t)fb_w * fb_h);
+    }
+
+    if (!ascii || !term || (raster && !pixels)) {
+        fprintf(stderr, "Error: Cannot allocate replay buffers\n");
+        free(ascii);
+        free(pixels);
+        term_display_cleanup(term);
+        return 0;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    stats->checksum = 2166136261u;
+
+    AllocSnapshot warm;
+    memset(&warm, 0, sizeof(warm));
+    int ok = 1;
+    for (int it = 0; it < iterations && ok; it++) {
+        if (it == 1) alloc_stats_snapshot(&warm);
+        term_display_invalidate(term);
+
+        for (int64_t i = 0; i < trace->num_frames; i++) {
+            Image view;
+            frame_trace_frame(trace, i, &view, NULL);
+
+            double t0 = startup_now_ms();
+            AllocScope scope = alloc_scope_enter(ALLOC_SCOPE_CONVERT);
+            if (!image_to_ascii_into(&view, &config, ascii, ascii_size)) {
+                fprintf(stderr, "Error: Cannot convert trace frame %ld in %s mode\n", (long)i,
+                        ascii_mode_name(mode));
+                alloc_scope_leave(scope);
+                ok = 0;
+                break;
+            }
+            double t1 = startup_now_ms();
+            alloc_scope_enter(ALLOC_SCOPE_RENDER);
+            term_display_encode_frame(term, ascii);
+            double t2 = startup_now_ms();
+            if (raster) ascii_raster_render(raster, ascii, pixels, fb_w, fb_h, fb_w);
+            double t3 = startup_now_ms();
+            alloc_scope_leave(scope);
+            alloc_stats_frame_end();
+
+            stats->convert_ms += t1 - t0;
+            stats->term_ms += t2 - t1;
+            stats->raster_ms += t3 - t2;
+            if (it == 0) stats->checksum = checksum_update(stats->checksum, ascii);
+        }
+    }
+
+    if (alloc_stats_enabled && iterations > 1) {
+        AllocSnapshot now;
+        alloc_stats_snapshot(&now);
+        for (int i = 0; i < ALLOC_SCOPE_COUNT; i++) {
+            stats->steady_allocs[i] = now.scopes[i].allocs - warm.scopes[i].allocs;
+        }
+    }
+
+    free(ascii);
+    free(pixels);
+    term_display_cleanup(term);
+    return ok;
+}
+
+// With steady_state set, any heap allocation after a mode's first pass over
+// the trace fails the run
+int frame_trace_replay(const char* trace_file, int iterations, int num_threads, int steady_state,
+                       int pin_threads) {
+    FrameTrace* trace = frame_trace_open(trace_file);
+    if (!trace) return 1;
+    if (trace->num_frames == 0) {
+        fprintf(stderr, "Error: Trace %s holds no frames\n", trace_file);
+        frame_trace_close(trace);
+        return 1;
+    }
+    if (iterations <= 0) iterations = FRAME_TRACE_ITERATIONS;
+    if (steady_state && iterations < 2) {
+        fprintf(stderr, "Error: Steady-state check needs at least 2 iterations\n");
+        frame_trace_close(trace);
+        return 1;
+    }
+
+    // Fault every page in before timing so disk cache state is out of the
+    // measurement
+    volatile uint8_t sink = 0;
+    for (size_t off = 0; off < trace->map_size; off += 4096) sink ^= trace->map[off];
+    (void)sink;
+
+    if (num_threads <= 0) num_threads = thread_pool_cpu_count();
+    ThreadPool* pool = num_threads > 1 ? thread_pool_create(num_threads - 1, num_threads) : NULL;
+    if (pin_threads) thread_pool_pin_workers(pool);
+    GlyphCache* glyphs = glyph_cache_create(DEFAULT_FONT_SIZE);
+    AsciiRaster* raster = ascii_raster_create(glyphs, pool);
+    if (!raster) fprintf(stderr, "Warning: No glyph cache, skipping the raster stage\n");
+    ShapeGlyphs shapes;
+    int have_shapes = glyphs && glyph_cache_shape_glyphs(glyphs, &shapes);
+
+    printf("Replaying %s: %ld frames at %ux%u, %d iterations, %d threads\n", trace_file,
+           trace->num_frames, trace->header.width, trace->header.height, iterations, num_threads);
+    printf("%-11s %12s %12s %12s %10s\n", "Mode", "convert us", "term us", "raster us", "checksum");
+
+    int result = 0;
+    double frames = (double)trace->num_frames * iterations;
+    for (int mode = 0; mode < ASCII_MODE_COUNT; mode++) {
+        if (mode == ASCII_MODE_SHAPE && !have_shapes) continue;
+        ReplayStats stats;
+        if (!replay_mode(trace, (AsciiMode)mode, iterations, pool, have_shapes ? &shapes : NULL,
+                         raster, &stats)) {
+            result = 1;
+            break;
+        }
+        printf("%-11s %12.1f %12.1f %12.1f   %08x\n", ascii_mode_name((AsciiMode)mode),
+               stats.convert_ms * 1000.0 / frames, stats.term_ms * 1000.0 / frames,
+               stats.raster_ms * 1000.0 / frames, stats.checksum);
+
+        for (int i = 0; steady_state && i < ALLOC_SCOPE_COUNT; i++) {
+            if (stats.steady_allocs[i] == 0) continue;
+            fprintf(stderr, "Error: %s made %llu %s allocations after warm-up\n",
+                    ascii_mode_name((AsciiMode)mode), (unsigned long long)stats.steady_allocs[i],
+                    alloc_scope_name((AllocScope)i));
+            result = 1;
+        }
+    }
+    if (steady_state && result == 0) printf("Steady state: no allocations after warm-up\n");
+
+    ascii_raster_destroy(raster);
+    glyph_cache_destroy(glyphs);
+    thread_pool_destroy(pool);
+    frame_trace_close(trace);
+    return result;
+}
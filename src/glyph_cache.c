@@ -0,0 +1,180 @@
+#include "glyph_cache.h"
+#include "font_loader.h"
+#include "ascii_converter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GLYPH_BLANK 0
+
+// Decodes one UTF-8 sequence; returns the bytes consumed (at least one, so
+// malformed input still advances)
+int utf8_decode(const char* s, uint32_t* codepoint) {
+    const uint8_t* p = (const uint8_t*)s;
+
+    if (p[0] < 0x80) {
+        *codepoint = p[0];
+        return 1;
+    }
+    if ((p[0] & 0xE0) == 0xC0 && (p[1] & 0xC0) == 0x80) {
+        *codepoint = ((uint32_t)(p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+        return 2;
+    }
+    if ((p[0] & 0xF0) == 0xE0 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80) {
+        *codepoint = ((uint32_t)(p[0] & 0x0F) << 12) | ((uint32_t)(p[1] & 0x3F) << 6) |
+                     (p[2] & 0x3F);
+        return 3;
+    }
+    if ((p[0] & 0xF8) == 0xF0 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80 &&
+        (p[3] & 0xC0) == 0x80) {
+        *codepoint = ((uint32_t)(p[0] & 0x07) << 18) | ((uint32_t)(p[1] & 0x3F) << 12) |
+                     ((uint32_t)(p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        return 4;
+    }
+
+    *codepoint = 0xFFFD;
+    return 1;
+}
+
+static inline int glyph_slot_hash(uint32_t codepoint) {
+    return (int)((codepoint * 2654435761u) >> 22) & (GLYPH_CACHE_SLOTS - 1);
+}
+
+static int glyph_cache_find(const GlyphCache* cache, uint32_t codepoint) {
+    if (codepoint < 128) return cache->ascii_index[codepoint];
+
+    int slot = glyph_slot_hash(codepoint);
+    while (cache->slots[slot].codepoint != 0) {
+        if (cache->slots[slot].codepoint == codepoint) return cache->slots[slot].index;
+        slot = (slot + 1) & (GLYPH_CACHE_SLOTS - 1);
+    }
+    return -1;
+}
+
+static void glyph_render(GlyphCache* cache, uint32_t codepoint, uint8_t* cell) {
+    memset(cell, 0, (size_t)cache->cell_width * cache->cell_height);
+    if (!cache->font || codepoint == ' ' || !TTF_GlyphIsProvided32(cache->font, codepoint)) return;
+
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Color black = {0, 0, 0, 255};
+    SDL_Surface* surface = TTF_RenderGlyph32_Shaded(cache->font, codepoint, white, black);
+    if (!surface) return;
+
+    // Shaded glyphs are 8-bit with a linear black-to-white palette, so the
+    // pixel index is the coverage
+    if (surface->format->BytesPerPixel == 1) {
+        int w = surface->w < cache->cell_width ? surface->w : cache->cell_width;
+        int h = surface->h < cache->cell_height ? surface->h : cache->cell_height;
+        for (int y = 0; y < h; y++) {
+            memcpy(cell + (size_t)y * cache->cell_width,
+                   (const uint8_t*)surface->pixels + (size_t)y * surface->pitch, w);
+        }
+    }
+    SDL_FreeSurface(surface);
+}
+
+static int glyph_cache_add(GlyphCache* cache, uint32_t codepoint) {
+    if (codepoint == 0) return GLYPH_BLANK;
+
+    int index = glyph_cache_find(cache, codepoint);
+    if (index >= 0) return index;
+
+    size_t cell_size = (size_t)cache->cell_width * cache->cell_height;
+    if (cache->num_glyphs == cache->capacity) {
+        int capacity = cache->capacity ? cache->capacity * 2 : 512;
+        uint8_t* bitmaps = realloc(cache->bitmaps, cell_size * capacity);
+        if (!bitmaps) return GLYPH_BLANK;
+        cache->bitmaps = bitmaps;
+        cache->capacity = capacity;
+    }
+
+    index = cache->num_glyphs++;
+    glyph_render(cache, codepoint, cache->bitmaps + cell_size * index);
+
+    if (codepoint < 128) {
+        cache->ascii_index[codepoint] = index;
+    } else {
+        int slot = glyph_slot_hash(codepoint);
+        while (cache->slots[slot].codepoint != 0) {
+            slot = (slot + 1) & (GLYPH_CACHE_SLOTS - 1);
+        }
+        cache->slots[slot].codepoint = codepoint;
+        cache->slots[slot].index = index;
+    }
+    return index;
+}
+
+GlyphCache* glyph_cache_create(int font_size) {
+    GlyphCache* cache = calloc(1, sizeof(GlyphCache));
+    if (!cache) return NULL;
+
+    if (!TTF_WasInit()) {
+        if (TTF_Init() == -1) {
+            fprintf(stderr, "SDL_ttf could not initialize! SDL_ttf Error: %s\n", TTF_GetError());
+            free(cache);
+            return NULL;
+        }
+        cache->owns_ttf = 1;
+    }
+
+    cache->font = font_loader_open(font_size, &cache->cell_width, &cache->cell_height, NULL);
+    if (!cache->font) {
+        fprintf(stderr, "Error: Could not load any font for glyph rasterization\n");
+        glyph_cache_destroy(cache);
+        return NULL;
+    }
+
+    for (int i = 0; i < 128; i++) cache->ascii_index[i] = -1;
+
+    // Index 0 is the blank cell every unknown codepoint falls back to
+    glyph_cache_add(cache, ' ');
+
+    for (uint32_t c = 33; c < 127; c++) glyph_cache_add(cache, c);
+
+    for (int s = 0; s < NUM_ASCII_SETS; s++) {
+        const char* p = ASCII_SETS[s].chars;
+        while (*p) {
+            uint32_t codepoint;
+            p += utf8_decode(p, &codepoint);
+            glyph_cache_add(cache, codepoint);
+        }
+    }
+
+    for (uint32_t c = 0x2800; c <= 0x28FF; c++) glyph_cache_add(cache, c);
+    glyph_cache_add(cache, 0x2580);
+
+    printf("Glyph cache: %d glyphs at %dx%d\n", cache->num_glyphs, cache->cell_width,
+           cache->cell_height);
+    return cache;
+}
+
+void glyph_cache_destroy(GlyphCache* cache) {
+    if (!cache) return;
+
+    if (cache->font) TTF_CloseFont(cache->font);
+    if (cache->owns_ttf) TTF_Quit();
+    free(cache->bitmaps);
+    free(cache);
+}
+
+// Unknown codepoints render as blanks rather than failing the frame
+const uint8_t* glyph_cache_lookup(const GlyphCache* cache, uint32_t codepoint) {
+    int index = glyph_cache_find(cache, codepoint);
+    if (index < 0) index = GLYPH_BLANK;
+    return cache->bitmaps + (size_t)cache->cell_width * cache->cell_height * index;
+}
+
+// Shape-mode masks for the printable ASCII glyphs, space first so blank
+// cells prefer it over glyphs too thin to leave a mask bit
+int glyph_cache_shape_glyphs(const GlyphCache* cache, ShapeGlyphs* shapes) {
+    char glyphs[SHAPE_MAX_GLYPHS + 1];
+    const uint8_t* bitmaps[SHAPE_MAX_GLYPHS];
+
+    for (int i = 0; i < SHAPE_MAX_GLYPHS; i++) {
+        glyphs[i] = (char)(' ' + i);
+        bitmaps[i] = glyph_cache_lookup(cache, (uint32_t)(' ' + i));
+    }
+    glyphs[SHAPE_MAX_GLYPHS] = '\0';
+
+    return shape_glyphs_build(shapes, glyphs, bitmaps, cache->cell_width, cache->cell_height);
+}
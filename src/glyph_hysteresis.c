@@ -0,0 +1,131 @@
+#include "glyph_hysteresis.h"
+#include "image_processing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+GlyphHysteresis* glyph_hysteresis_create(int margin) {
+    GlyphHysteresis* h = calloc(1, sizeof(GlyphHysteresis));
+    if (!h) {
+        fprintf(stderr, "Error: Cannot allocate glyph hysteresis\n");
+        return NULL;
+    }
+    h->margin = margin < 0 ? 0 : margin;
+    return h;
+}
+
+void glyph_hysteresis_destroy(GlyphHysteresis* h) {
+    if (!h) return;
+    free(h->cells);
+    free(h);
+}
+
+// Forgets every cell's glyph; the next frame is quantized as is
+void glyph_hysteresis_reset(GlyphHysteresis* h) {
+    if (!h) return;
+    if (h->cells) memset(h->cells, GLYPH_HYSTERESIS_NONE, (size_t)h->cols * h->rows);
+    h->has_samples = 0;
+    h->cells_changed = 0;
+    h->cells_total = 0;
+}
+
+// A glyph is kept while the level stays within margin of the range of
+// levels that quantize to it; anything further out is quantized normally
+static void build_table(GlyphHysteresis* h) {
+    for (int g = 0; g <= GLYPH_HYSTERESIS_NONE; g++) {
+        int lo = 256, hi = -1;
+        if (g < h->num_glyphs) {
+            for (int v = 0; v < 256; v++) {
+                if (h->levels[v] != g) continue;
+                if (v < lo) lo = v;
+                hi = v;
+            }
+        }
+        for (int v = 0; v < 256; v++) {
+            int hold = hi >= 0 && v >= lo - h->margin && v <= hi + h->margin;
+            h->table[g][v] = hold ? (uint8_t)g : h->levels[v];
+        }
+    }
+}
+
+void glyph_hysteresis_set_margin(GlyphHysteresis* h, int margin) {
+    if (!h) return;
+    h->margin = margin < 0 ? 0 : margin;
+    if (h->num_glyphs > 0) build_table(h);
+}
+
+// Mean luma change over a sparse grid of samples, compared against the
+// previous frame's
+static int scene_cut(GlyphHysteresis* h, const Image* img) {
+    int n = GLYPH_HYSTERESIS_SAMPLES;
+    uint32_t diff = 0;
+
+    for (int sy = 0; sy < n; sy++) {
+        int y = (2 * sy + 1) * img->height / (2 * n);
+        for (int sx = 0; sx < n; sx++) {
+            int x = (2 * sx + 1) * img->width / (2 * n);
+            const uint8_t* p = img->data + ((size_t)y * img->width + x) * img->channels;
+            int luma = img->channels < 3 ? p[0] : rgb_luma(p[0], p[1], p[2]);
+            uint8_t* sample = &h->samples[sy * n + sx];
+            diff += (uint32_t)abs(luma - *sample);
+            *sample = (uint8_t)luma;
+        }
+    }
+
+    int cut = h->has_samples && diff > (uint32_t)(GLYPH_HYSTERESIS_SCENE_CUT * n * n);
+    h->has_samples = 1;
+    return cut;
+}
+
+// Sizes the cell memory for a cols x rows grid and forgets every held
+// glyph. The allocation only grows, so sizing for the largest grid up
+// front keeps later frames from allocating. Returns 0 without printing
+// when the cells cannot be allocated.
+int glyph_hysteresis_resize(GlyphHysteresis* h, int cols, int rows) {
+    if (!h || cols < 0 || rows < 0) return 0;
+
+    size_t count = (size_t)cols * rows;
+    if (count > h->capacity || !h->cells) {
+        uint8_t* cells = realloc(h->cells, count > 0 ? count : 1);
+        if (!cells) return 0;
+        h->cells = cells;
+        h->capacity = count > 0 ? count : 1;
+    }
+    h->cols = cols;
+    h->rows = rows;
+    glyph_hysteresis_reset(h);
+    return 1;
+}
+
+// Called by the converter before each frame: resizes the cell memory for
+// the grid, rebuilds the table when the glyph quantizer changed, and drops
+// every held glyph on a scene cut. Returns 0, holding nothing this frame,
+// when the cells cannot be allocated.
+int glyph_hysteresis_prepare(GlyphHysteresis* h, const Image* img, const uint8_t levels[256],
+                             int num_glyphs, int cols, int rows) {
+    if (num_glyphs > GLYPH_HYSTERESIS_NONE) return 0;
+
+    if ((cols != h->cols || rows != h->rows || !h->cells) &&
+        !glyph_hysteresis_resize(h, cols, rows)) {
+        return 0;
+    }
+
+    if (num_glyphs != h->num_glyphs || memcmp(levels, h->levels, sizeof(h->levels)) != 0) {
+        memcpy(h->levels, levels, sizeof(h->levels));
+        h->num_glyphs = num_glyphs;
+        build_table(h);
+        glyph_hysteresis_reset(h);
+    }
+
+    if (scene_cut(h, img)) {
+        memset(h->cells, GLYPH_HYSTERESIS_NONE, (size_t)cols * rows);
+        h->scene_cuts++;
+    }
+    return 1;
+}
+
+// Share of cells whose glyph changed, over the frames since the last reset
+double glyph_hysteresis_change_rate(const GlyphHysteresis* h) {
+    if (!h || h->cells_total == 0) return 0.0;
+    return (double)h->cells_changed / (double)h->cells_total;
+}
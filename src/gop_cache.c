@@ -0,0 +1,358 @@
+#define _GNU_SOURCE
+#include "gop_cache.h"
+#include "startup_profile.h"
+#include "span_trace.h"
+#include "alloc_stats.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void free_frames(GopFrame* frames, int count) {
+    for (int i = 0; i < count; i++) free_image(frames[i].image);
+}
+
+// Runs on the helper thread, which alone touches the private decoder
+static int decode_segment(GopCache* cache, double end, int grid_w, int grid_h, ResizeFilter filter,
+                          const int roi[4], GopFrame* out, int max_frames) {
+    if (!cache->video_processor) {
+        cache->video_processor = video_processor_init(cache->video_file);
+        if (!cache->video_processor) return -1;
+    }
+    VideoProcessor* vp = cache->video_processor;
+
+    // Same crop as the player, so cached frames match what it shows
+    if (!video_processor_set_roi(vp, roi[0], roi[1], roi[2], roi[3])) return -1;
+    if (!cache->frame_buffer || cache->frame_buffer->width != vp->width ||
+        cache->frame_buffer->height != vp->height) {
+        free_image(cache->frame_buffer);
+        cache->frame_buffer = create_image(vp->width, vp->height, 3);
+        if (!cache->frame_buffer) return -1;
+    }
+
+    ResizePlan* plan = cache->resize_plan;
+    if (!plan || plan->src_width != vp->width || plan->src_height != vp->height ||
+        plan->dst_width != grid_w || plan->dst_height != grid_h || plan->filter != filter) {
+        resize_plan_destroy(plan);
+        plan = resize_plan_create(vp->width, vp->height, grid_w, grid_h, 3, filter);
+        cache->resize_plan = plan;
+        if (!plan) return -1;
+    }
+
+    double half = cache->frame_interval * 0.5;
+    if (end - half <= 0.0 || !video_processor_seek_time(vp, end - half)) return 0;
+
+    int n = 0;
+    while (video_processor_read_frame(vp, cache->frame_buffer)) {
+        double t = video_processor_frame_time(vp);
+        if (t >= end - half) break;
+
+        // A GOP longer than the cache keeps only its newest frames
+        if (n == max_frames) {
+            free_image(out[0].image);
+            memmove(out, out + 1, (n - 1) * sizeof(GopFrame));
+            n--;
+        }
+
+        Image* img = create_image(grid_w, grid_h, 3);
+        if (!img) break;
+        resize_plan_run(plan, cache->frame_buffer, img, NULL);
+        out[n].image = img;
+        out[n].time = t;
+        n++;
+    }
+    return n;
+}
+
+// Prepends a segment that ends where the cache begins, or replaces the
+// cache with an unrelated one. Older frames win over newer ones when full.
+static void merge_segment(GopCache* cache, GopFrame* seg, int n, double end) {
+    double eps = cache->frame_interval * 0.5;
+
+    if (n == 0) {
+        cache->at_start = 1;
+        return;
+    }
+
+    if (cache->count > 0 && fabs(cache->frames[0].time - end) < eps) {
+        int keep = cache->count;
+        if (n + keep > cache->capacity) {
+            int drop = n + keep - cache->capacity;
+            if (drop > keep) drop = keep;
+            free_frames(cache->frames + keep - drop, drop);
+            keep -= drop;
+        }
+        memmove(cache->frames + n, cache->frames, keep * sizeof(GopFrame));
+        memcpy(cache->frames, seg, n * sizeof(GopFrame));
+        cache->count = n + keep;
+    } else {
+        free_frames(cache->frames, cache->count);
+        memcpy(cache->frames, seg, n * sizeof(GopFrame));
+        cache->count = n;
+    }
+    cache->at_start = 0;
+}
+
+static void* gop_cache_thread(void* arg) {
+    GopCache* cache = (GopCache*)arg;
+    span_trace_name_thread("gop decode");
+    alloc_scope_enter(ALLOC_SCOPE_DECODE);
+
+    pthread_mutex_lock(&cache->lock);
+    while (1) {
+        while (!cache->request_pending && !cache->shutdown) {
+            pthread_cond_wait(&cache->wake, &cache->lock);
+        }
+        if (cache->shutdown) break;
+
+        double end = cache->request_end;
+        int generation = cache->generation;
+        int grid_w = cache->grid_width;
+        int grid_h = cache->grid_height;
+        ResizeFilter filter = cache->filter;
+        int roi[4] = {cache->roi_x, cache->roi_y, cache->roi_width, cache->roi_height};
+        int capacity = cache->capacity;
+        cache->request_pending = 0;
+        cache->decoding = 1;
+        pthread_mutex_unlock(&cache->lock);
+
+        GopFrame* seg = malloc(capacity * sizeof(GopFrame));
+        double start = startup_now_ms();
+        uint64_t span = span_begin();
+        int n = seg ? decode_segment(cache, end, grid_w, grid_h, filter, roi, seg, capacity) : -1;
+        span_end("decode_gop", span);
+        double elapsed = startup_now_ms() - start;
+
+        pthread_mutex_lock(&cache->lock);
+        cache->decoding = 0;
+        if (n < 0) {
+            fprintf(stderr, "Error: GOP decode failed\n");
+            cache->at_start = 1;
+        } else if (generation == cache->generation) {
+            merge_segment(cache, seg, n, end);
+            cache->gops_decoded++;
+            cache->last_decode_ms = elapsed;
+            n = 0;
+        }
+        if (seg && n > 0) free_frames(seg, n);
+        free(seg);
+        pthread_cond_broadcast(&cache->ready);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    return NULL;
+}
+
+GopCache* gop_cache_create(const char* video_file, double fps) {
+    if (!video_file) return NULL;
+
+    GopCache* cache = calloc(1, sizeof(GopCache));
+    if (!cache) return NULL;
+
+    cache->video_file = strdup(video_file);
+    cache->frame_interval = fps > 0.0 ? 1.0 / fps : 1.0 / 30.0;
+    cache->filter = RESIZE_DEFAULT_FILTER;
+    if (!cache->video_file) {
+        free(cache);
+        return NULL;
+    }
+
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_cond_init(&cache->wake, NULL);
+    pthread_cond_init(&cache->ready, NULL);
+
+    // The private decoder is opened on first use, on the helper thread
+    if (pthread_create(&cache->thread, NULL, gop_cache_thread, cache) != 0) {
+        fprintf(stderr, "Error: Cannot start GOP decode thread\n");
+        pthread_mutex_destroy(&cache->lock);
+        pthread_cond_destroy(&cache->wake);
+        pthread_cond_destroy(&cache->ready);
+        free(cache->video_file);
+        free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+void gop_cache_destroy(GopCache* cache) {
+    if (!cache) return;
+
+    pthread_mutex_lock(&cache->lock);
+    cache->shutdown = 1;
+    pthread_cond_signal(&cache->wake);
+    pthread_mutex_unlock(&cache->lock);
+    pthread_join(cache->thread, NULL);
+
+    free_frames(cache->frames, cache->count);
+    free(cache->frames);
+    if (cache->video_processor) video_processor_cleanup(cache->video_processor);
+    free_image(cache->frame_buffer);
+    resize_plan_destroy(cache->resize_plan);
+    pthread_mutex_destroy(&cache->lock);
+    pthread_cond_destroy(&cache->wake);
+    pthread_cond_destroy(&cache->ready);
+    free(cache->video_file);
+    free(cache);
+}
+
+// Frames are stored at grid size, so any grid or filter change drops them
+int gop_cache_configure(GopCache* cache, int grid_width, int grid_height, ResizeFilter filter) {
+    if (!cache || grid_width <= 0 || grid_height <= 0) return 0;
+
+    pthread_mutex_lock(&cache->lock);
+    if (cache->frames && cache->grid_width == grid_width && cache->grid_height == grid_height &&
+        cache->filter == filter) {
+        pthread_mutex_unlock(&cache->lock);
+        return 1;
+    }
+
+    size_t frame_bytes = (size_t)grid_width * grid_height * 3;
+    int capacity = (int)(GOP_CACHE_MAX_BYTES / frame_bytes);
+    if (capacity < GOP_CACHE_MIN_FRAMES) capacity = GOP_CACHE_MIN_FRAMES;
+
+    GopFrame* frames = realloc(cache->frames, capacity * sizeof(GopFrame));
+    int ok = frames != NULL;
+    if (ok) {
+        free_frames(frames, cache->count);
+        cache->frames = frames;
+        cache->capacity = capacity;
+        cache->grid_width = grid_width;
+        cache->grid_height = grid_height;
+        cache->filter = filter;
+    } else {
+        free_frames(cache->frames, cache->count);
+    }
+    cache->count = 0;
+    cache->at_start = 0;
+    cache->request_pending = 0;
+    cache->generation++;
+    pthread_mutex_unlock(&cache->lock);
+
+    return ok;
+}
+
+// The crop changes what every cached frame shows, so it drops them too
+int gop_cache_set_roi(GopCache* cache, int x, int y, int width, int height) {
+    if (!cache) return 0;
+
+    pthread_mutex_lock(&cache->lock);
+    if (cache->roi_x != x || cache->roi_y != y || cache->roi_width != width ||
+        cache->roi_height != height) {
+        cache->roi_x = x;
+        cache->roi_y = y;
+        cache->roi_width = width;
+        cache->roi_height = height;
+        free_frames(cache->frames, cache->count);
+        cache->count = 0;
+        cache->at_start = 0;
+        cache->request_pending = 0;
+        cache->generation++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    return 1;
+}
+
+static void request_segment(GopCache* cache, double end) {
+    cache->request_end = end;
+    cache->request_pending = 1;
+    pthread_cond_signal(&cache->wake);
+}
+
+static void copy_frame(const GopFrame* frame, Image* dst, double* frame_time) {
+    memcpy(dst->data, frame->image->data, (size_t)dst->width * dst->height * dst->channels);
+    if (frame_time) *frame_time = frame->time;
+}
+
+// Newest cached frame older than time. Returns 1 with the frame in dst, 0
+// while its GOP is still being decoded (only when not waiting), and -1 at
+// the start of the video.
+int gop_cache_frame_before(GopCache* cache, double time, Image* dst, double* frame_time, int wait) {
+    if (!cache || !dst || dst->width != cache->grid_width || dst->height != cache->grid_height ||
+        dst->channels != 3) {
+        return -1;
+    }
+
+    double eps = cache->frame_interval * 0.5;
+    if (time <= eps) return -1;
+
+    pthread_mutex_lock(&cache->lock);
+    for (int attempt = 0; attempt < 3; attempt++) {
+        int found = -1;
+        if (cache->count > 0 && time <= cache->frames[cache->count - 1].time + 3.0 * eps) {
+            for (int i = cache->count - 1; i >= 0; i--) {
+                if (cache->frames[i].time < time - eps) {
+                    found = i;
+                    break;
+                }
+            }
+        }
+
+        if (found >= 0) {
+            copy_frame(&cache->frames[found], dst, frame_time);
+
+            // Keep the next older GOP decoding while this one plays out,
+            // without letting the prepend evict frames still ahead
+            if (!cache->request_pending && !cache->decoding && !cache->at_start &&
+                found < cache->capacity / 2) {
+                request_segment(cache, cache->frames[0].time);
+            }
+            pthread_mutex_unlock(&cache->lock);
+            return 1;
+        }
+
+        if (cache->count > 0 && time <= cache->frames[cache->count - 1].time + 3.0 * eps) {
+            // Before everything cached: the GOP ending at frames[0]
+            if (cache->at_start) {
+                pthread_mutex_unlock(&cache->lock);
+                return -1;
+            }
+            if (!cache->request_pending && !cache->decoding) {
+                request_segment(cache, cache->frames[0].time);
+            }
+        } else if (!cache->request_pending && !cache->decoding) {
+            // Nothing cached near time: start over from there
+            free_frames(cache->frames, cache->count);
+            cache->count = 0;
+            cache->at_start = 0;
+            cache->generation++;
+            request_segment(cache, time);
+        }
+
+        if (!wait) break;
+        while (cache->request_pending || cache->decoding) {
+            pthread_cond_wait(&cache->ready, &cache->lock);
+        }
+        if (cache->count == 0 && cache->at_start) break;
+    }
+
+    int result = cache->count == 0 && cache->at_start ? -1 : 0;
+    pthread_mutex_unlock(&cache->lock);
+    return result;
+}
+
+// Oldest cached frame newer than time, if it directly follows it
+int gop_cache_frame_after(GopCache* cache, double time, Image* dst, double* frame_time) {
+    if (!cache || !dst || dst->width != cache->grid_width || dst->height != cache->grid_height ||
+        dst->channels != 3) {
+        return 0;
+    }
+
+    double eps = cache->frame_interval * 0.5;
+    int result = 0;
+
+    pthread_mutex_lock(&cache->lock);
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->frames[i].time > time + eps) {
+            if (cache->frames[i].time <= time + 3.0 * eps) {
+                copy_frame(&cache->frames[i], dst, frame_time);
+                result = 1;
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    return result;
+}
@@ -0,0 +1,77 @@
+#include "grid_controller.h"
+#include <math.h>
+
+void grid_controller_init(GridController* gc, int enabled) {
+    gc->enabled = enabled;
+    gc->level = 0;
+    gc->hold = 0;
+    gc->hold_windows = GRID_CONTROL_HOLD;
+    gc->stepped_up = 0;
+    gc->average_ms = 0.0;
+    gc->steps = 0;
+    grid_controller_restart(gc);
+}
+
+// Drops the partial window; frames measured at another grid would skew it
+void grid_controller_restart(GridController* gc) {
+    gc->sum_ms = 0.0;
+    gc->samples = 0;
+}
+
+double grid_controller_level_scale(int level) {
+    return pow(GRID_CONTROL_STEP, level);
+}
+
+double grid_controller_scale(const GridController* gc) {
+    return gc->enabled ? grid_controller_level_scale(gc->level) : 1.0;
+}
+
+// Adds one frame's grid-dependent work. Returns 1 when the level changed
+// and the grid has to be rebuilt.
+int grid_controller_sample(GridController* gc, double work_ms, double budget_ms) {
+    if (!gc->enabled || budget_ms <= 0.0) return 0;
+
+    gc->sum_ms += work_ms;
+    if (++gc->samples < GRID_CONTROL_WINDOW) return 0;
+
+    double average = gc->sum_ms / gc->samples;
+    double scale = grid_controller_level_scale(gc->level);
+    int level = gc->level;
+    gc->average_ms = average;
+    grid_controller_restart(gc);
+
+    if (average > GRID_CONTROL_OVER * budget_ms) {
+        // Far enough down to land near the target in one step
+        while (level < GRID_CONTROL_LEVELS - 1) {
+            level++;
+            double ratio = grid_controller_level_scale(level) / scale;
+            if (average * ratio * ratio <= GRID_CONTROL_TARGET * budget_ms) break;
+        }
+        // Going back down right after going up: wait longer next time
+        if (gc->stepped_up) {
+            gc->hold_windows *= 2;
+            if (gc->hold_windows > GRID_CONTROL_MAX_HOLD) gc->hold_windows = GRID_CONTROL_MAX_HOLD;
+        }
+        gc->hold = gc->hold_windows;
+        gc->stepped_up = 0;
+    } else {
+        if (gc->stepped_up) {
+            gc->stepped_up = 0;
+            gc->hold_windows = GRID_CONTROL_HOLD;
+        }
+        if (gc->hold > 0) {
+            gc->hold--;
+        } else if (level > 0) {
+            double ratio = grid_controller_level_scale(level - 1) / scale;
+            if (average * ratio * ratio < GRID_CONTROL_UNDER * budget_ms) {
+                level--;
+                gc->stepped_up = 1;
+            }
+        }
+    }
+
+    if (level == gc->level) return 0;
+    gc->level = level;
+    gc->steps++;
+    return 1;
+}
@@ -1,4 +1,5 @@
 #include "image_processing.h"
+#include "image_resize.h"
 #include <math.h>
 #include <string.h>
 
@@ -26,8 +27,7 @@ Image* convert_to_grayscale(const Image* img) {
             uint8_t b = img->data[rgb_idx + 2];
             
             
-            uint8_t gray = (uint8_t)(0.299 * r + 0.587 * g + 0.114 * b);
-            gray_img->data[gray_idx] = gray;
+            gray_img->data[gray_idx] = rgb_luma(r, g, b);
         }
     }
     
@@ -46,7 +46,7 @@ uint8_t get_pixel_brightness(const Image* img, int x, int y) {
         uint8_t r = img->data[idx];
         uint8_t g = img->data[idx + 1];
         uint8_t b = img->data[idx + 2];
-        return (uint8_t)(0.299 * r + 0.587 * g + 0.114 * b);
+        return rgb_luma(r, g, b);
     }
 }
 
@@ -86,43 +86,52 @@ uint8_t bilinear_interpolate(const Image* img, float x, float y, int channel) {
     return (uint8_t)val;
 }
 
+// One-off resize; callers resizing every frame keep a ResizePlan instead
+// so the coefficient tables are built once
+int resize_image_into(const Image* img, Image* dst) {
+    if (!img || !img->data || !dst || !dst->data) return 0;
+    if (dst->width <= 0 || dst->height <= 0 || dst->channels != img->channels) return 0;
+
+    ResizePlan* plan = resize_plan_create(img->width, img->height, dst->width, dst->height,
+                                          img->channels, RESIZE_DEFAULT_FILTER);
+    if (!plan) return 0;
+
+    int ok = resize_plan_run(plan, img, dst, NULL);
+    resize_plan_destroy(plan);
+    return ok;
+}
+
 Image* resize_image(const Image* img, int new_width, int new_height) {
     if (!img || !img->data || new_width <= 0 || new_height <= 0) return NULL;
     
     Image* resized = create_image(new_width, new_height, img->channels);
     if (!resized) return NULL;
     
-    float x_ratio = (float)img->width / new_width;
-    float y_ratio = (float)img->height / new_height;
-    
-    for (int y = 0; y < new_height; y++) {
-        for (int x = 0; x < new_width; x++) {
-            float src_x = x * x_ratio;
-            float src_y = y * y_ratio;
-            
-            for (int c = 0; c < img->channels; c++) {
-                uint8_t pixel_val = bilinear_interpolate(img, src_x, src_y, c);
-                int dst_idx = (y * new_width + x) * img->channels + c;
-                resized->data[dst_idx] = pixel_val;
-            }
-        }
-    }
+    resize_image_into(img, resized);
     
     return resized;
 }
 
-Image* resize_image_aspect_ratio(const Image* img, int max_width, int max_height) {
-    if (!img || !img->data || max_width <= 0 || max_height <= 0) return NULL;
-    
-    float width_ratio = (float)max_width / img->width;
-    float height_ratio = (float)max_height / img->height;
+void fit_aspect_ratio(int width, int height, int max_width, int max_height, int* out_width, int* out_height) {
+    float width_ratio = (float)max_width / width;
+    float height_ratio = (float)max_height / height;
     float scale = (width_ratio < height_ratio) ? width_ratio : height_ratio;
     
-    int new_width = (int)(img->width * scale);
-    int new_height = (int)(img->height * scale);
+    int new_width = (int)(width * scale);
+    int new_height = (int)(height * scale);
     
     if (new_width < 1) new_width = 1;
     if (new_height < 1) new_height = 1;
+
+    *out_width = new_width;
+    *out_height = new_height;
+}
+
+Image* resize_image_aspect_ratio(const Image* img, int max_width, int max_height) {
+    if (!img || !img->data || max_width <= 0 || max_height <= 0) return NULL;
+    
+    int new_width, new_height;
+    fit_aspect_ratio(img->width, img->height, max_width, max_height, &new_width, &new_height);
     
     return resize_image(img, new_width, new_height);
 }
@@ -0,0 +1,371 @@
+#define _GNU_SOURCE
+#include "image_resize.h"
+#include "span_trace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define RESIZE_ONE (1 << RESIZE_COEF_BITS)
+#define RESIZE_ROUND (1 << (RESIZE_COEF_BITS - 1))
+#define RESIZE_BANDS_PER_THREAD 2
+
+static const char* filter_names[RESIZE_FILTER_COUNT] = {
+    "Nearest",
+    "Box",
+    "Bilinear",
+    "Lanczos"
+};
+
+// Kernel half-width in source pixels at 1:1; widened by the scale factor
+// when downscaling so every source pixel contributes (antialiasing)
+static const double filter_support[RESIZE_FILTER_COUNT] = {0.0, 0.5, 1.0, 3.0};
+
+static double sinc(double x) {
+    if (x == 0.0) return 1.0;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+static double filter_weight(ResizeFilter filter, double x) {
+    switch (filter) {
+        case RESIZE_BOX:
+            return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+        case RESIZE_BILINEAR:
+            x = fabs(x);
+            return x < 1.0 ? 1.0 - x : 0.0;
+        case RESIZE_LANCZOS:
+            return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+        default:
+            return 0.0;
+    }
+}
+
+static inline uint8_t clamp_pixel(int32_t acc) {
+    acc >>= RESIZE_COEF_BITS;
+    return (uint8_t)(acc < 0 ? 0 : acc > 255 ? 255 : acc);
+}
+
+const char* resize_filter_name(ResizeFilter filter) {
+    if (filter < 0 || filter >= RESIZE_FILTER_COUNT) return "Unknown";
+    return filter_names[filter];
+}
+
+static int axis_init(ResizeAxis* axis, int src_size, int dst_size, ResizeFilter filter) {
+    double scale = (double)src_size / dst_size;
+    double filterscale = scale < 1.0 ? 1.0 : scale;
+    double support = filter_support[filter] * filterscale;
+
+    int taps = filter == RESIZE_NEAREST ? 1 : (int)ceil(support) * 2 + 1;
+    if (taps > src_size) taps = src_size;
+
+    axis->src_size = src_size;
+    axis->dst_size = dst_size;
+    axis->taps = taps;
+    axis->start = malloc(dst_size * sizeof(int));
+    axis->coef = calloc((size_t)dst_size * taps, sizeof(int16_t));
+    double* weights = malloc(taps * sizeof(double));
+    if (!axis->start || !axis->coef || !weights) {
+        free(weights);
+        return 0;
+    }
+
+    for (int i = 0; i < dst_size; i++) {
+        double center = (i + 0.5) * scale;
+        int16_t* coef = axis->coef + (size_t)i * taps;
+
+        if (filter == RESIZE_NEAREST) {
+            int s = (int)center;
+            axis->start[i] = s < src_size ? s : src_size - 1;
+            coef[0] = RESIZE_ONE;
+            continue;
+        }
+
+        int xmin = (int)(center - support + 0.5);
+        int xmax = (int)(center + support + 0.5);
+        if (xmin < 0) xmin = 0;
+        if (xmax > src_size) xmax = src_size;
+        int count = xmax - xmin;
+        if (count > taps) count = taps;
+
+        double total = 0.0;
+        for (int j = 0; j < count; j++) {
+            weights[j] = filter_weight(filter, (j + xmin - center + 0.5) / filterscale);
+            total += weights[j];
+        }
+
+        // Keep the window inside the source so the passes need no clamping
+        int start = xmin + taps > src_size ? src_size - taps : xmin;
+        int offset = xmin - start;
+        axis->start[i] = start;
+
+        if (total == 0.0) {
+            coef[offset] = RESIZE_ONE;
+            continue;
+        }
+
+        // Quantize, then hand the rounding error to the largest tap so
+        // flat areas come out exactly flat
+        int sum = 0, largest = 0;
+        for (int j = 0; j < count; j++) {
+            int q = (int)lround(weights[j] / total * RESIZE_ONE);
+            coef[offset + j] = (int16_t)q;
+            sum += q;
+            if (abs(q) > abs(coef[offset + largest])) largest = j;
+        }
+        coef[offset + largest] += (int16_t)(RESIZE_ONE - sum);
+    }
+
+    free(weights);
+    return 1;
+}
+
+static void axis_free(ResizeAxis* axis) {
+    free(axis->start);
+    free(axis->coef);
+}
+
+ResizePlan* resize_plan_create(int src_width, int src_height, int dst_width, int dst_height,
+                               int channels, ResizeFilter filter) {
+    if (src_width <= 0 || src_height <= 0 || dst_width <= 0 || dst_height <= 0 ||
+        channels <= 0 || filter < 0 || filter >= RESIZE_FILTER_COUNT) {
+        return NULL;
+    }
+
+    ResizePlan* plan = calloc(1, sizeof(ResizePlan));
+    if (!plan) return NULL;
+
+    plan->src_width = src_width;
+    plan->src_height = src_height;
+    plan->dst_width = dst_width;
+    plan->dst_height = dst_height;
+    plan->channels = channels;
+    plan->filter = filter;
+    plan->temp = malloc((size_t)src_height * dst_width * channels);
+
+    if (!plan->temp || !axis_init(&plan->horizontal, src_width, dst_width, filter) ||
+        !axis_init(&plan->vertical, src_height, dst_height, filter)) {
+        resize_plan_destroy(plan);
+        return NULL;
+    }
+
+    // Rows no vertical tap touches (sparse nearest or box windows) are never
+    // filtered horizontally
+    plan->rows = malloc(src_height * sizeof(int));
+    if (!plan->rows) {
+        resize_plan_destroy(plan);
+        return NULL;
+    }
+    int next = 0;
+    for (int y = 0; y < dst_height; y++) {
+        int first = plan->vertical.start[y];
+        if (first < next) first = next;
+        for (int r = first; r < plan->vertical.start[y] + plan->vertical.taps; r++) {
+            plan->rows[plan->num_rows++] = r;
+        }
+        if (plan->vertical.start[y] + plan->vertical.taps > next) {
+            next = plan->vertical.start[y] + plan->vertical.taps;
+        }
+    }
+
+    plan->work = ((int64_t)plan->num_rows * plan->horizontal.taps +
+                  (int64_t)dst_height * plan->vertical.taps) * dst_width * channels;
+    return plan;
+}
+
+void resize_plan_destroy(ResizePlan* plan) {
+    if (!plan) return;
+    axis_free(&plan->horizontal);
+    axis_free(&plan->vertical);
+    free(plan->rows);
+    free(plan->temp);
+    free(plan);
+}
+
+int resize_plan_matches(const ResizePlan* plan, const Image* src, const Image* dst, ResizeFilter filter) {
+    return plan && src && dst && plan->filter == filter && plan->channels == src->channels &&
+           plan->src_width == src->width && plan->src_height == src->height &&
+           plan->dst_width == dst->width && plan->dst_height == dst->height;
+}
+
+// Keeps the plan when the geometry is unchanged, otherwise replaces it
+ResizePlan* resize_plan_update(ResizePlan* plan, const Image* src, const Image* dst, ResizeFilter filter) {
+    if (resize_plan_matches(plan, src, dst, filter)) return plan;
+
+    resize_plan_destroy(plan);
+    if (!src || !dst || src->channels != dst->channels) return NULL;
+    return resize_plan_create(src->width, src->height, dst->width, dst->height, src->channels, filter);
+}
+
+static void horizontal_row(const ResizeAxis* axis, const uint8_t* src, uint8_t* dst, int channels) {
+    int taps = axis->taps;
+
+    for (int x = 0; x < axis->dst_size; x++) {
+        const int16_t* coef = axis->coef + (size_t)x * taps;
+        const uint8_t* s = src + (size_t)axis->start[x] * channels;
+        uint8_t* out = dst + (size_t)x * channels;
+        int k = 0;
+
+#ifdef __SSE2__
+        if (channels == 3 || channels == 4) {
+            // Two taps per step: interleave two pixels' channels and let
+            // madd form c0*p0 + c1*p1 for every channel at once. 3-channel
+            // rows read one byte past each pixel, so the row's last pixel
+            // stays on the scalar path.
+            int limit = channels == 3 ? axis->src_size - 2 - axis->start[x] : taps;
+            __m128i acc = _mm_setzero_si128();
+            __m128i zero = _mm_setzero_si128();
+
+            for (; k + 1 < taps && k + 1 <= limit; k += 2) {
+                uint32_t a, b;
+                memcpy(&a, s + (size_t)k * channels, 4);
+                memcpy(&b, s + (size_t)(k + 1) * channels, 4);
+                __m128i pix = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)a), _mm_cvtsi32_si128((int)b));
+                pix = _mm_unpacklo_epi8(pix, zero);
+                __m128i c = _mm_set1_epi32((int)(((uint32_t)(uint16_t)coef[k + 1] << 16) |
+                                                 (uint16_t)coef[k]));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(pix, c));
+            }
+
+            int32_t sums[4];
+            _mm_storeu_si128((__m128i*)sums, acc);
+            for (int c = 0; c < channels; c++) {
+                int32_t total = sums[c] + RESIZE_ROUND;
+                for (int j = k; j < taps; j++) total += coef[j] * s[(size_t)j * channels + c];
+                out[c] = clamp_pixel(total);
+            }
+            continue;
+        }
+#endif
+
+        for (int c = 0; c < channels; c++) {
+            int32_t total = RESIZE_ROUND;
+            for (k = 0; k < taps; k++) total += coef[k] * s[(size_t)k * channels + c];
+            out[c] = clamp_pixel(total);
+        }
+    }
+}
+
+static void vertical_row(const ResizeAxis* axis, const uint8_t* temp, size_t row_bytes, int y,
+                         uint8_t* dst) {
+    int taps = axis->taps;
+    const int16_t* coef = axis->coef + (size_t)y * taps;
+    const uint8_t* rows = temp + (size_t)axis->start[y] * row_bytes;
+    size_t x = 0;
+
+#ifdef __SSE2__
+    // Eight bytes per step, two source rows per madd
+    __m128i zero = _mm_setzero_si128();
+    for (; x + 8 <= row_bytes; x += 8) {
+        __m128i lo = _mm_set1_epi32(RESIZE_ROUND);
+        __m128i hi = lo;
+
+        for (int k = 0; k < taps; k += 2) {
+            __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(rows + k * row_bytes + x)), zero);
+            __m128i b = zero;
+            uint32_t pair = (uint16_t)coef[k];
+            if (k + 1 < taps) {
+                b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(rows + (k + 1) * row_bytes + x)), zero);
+                pair |= (uint32_t)(uint16_t)coef[k + 1] << 16;
+            }
+            __m128i c = _mm_set1_epi32((int)pair);
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), c));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), c));
+        }
+
+        lo = _mm_srai_epi32(lo, RESIZE_COEF_BITS);
+        hi = _mm_srai_epi32(hi, RESIZE_COEF_BITS);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(lo, hi), zero);
+        _mm_storel_epi64((__m128i*)(dst + x), packed);
+    }
+#endif
+
+    for (; x < row_bytes; x++) {
+        int32_t total = RESIZE_ROUND;
+        for (int k = 0; k < taps; k++) total += coef[k] * rows[k * row_bytes + x];
+        dst[x] = clamp_pixel(total);
+    }
+}
+
+typedef struct {
+    ResizePlan* plan;
+    const uint8_t* src;
+    size_t src_stride;
+    Image* dst;
+    int band_rows;
+} ResizeJob;
+
+static void horizontal_band(void* arg, int band) {
+    ResizeJob* job = (ResizeJob*)arg;
+    ResizePlan* plan = job->plan;
+    size_t row_bytes = (size_t)plan->dst_width * plan->channels;
+    int first = band * job->band_rows;
+    int last = first + job->band_rows;
+    if (last > plan->num_rows) last = plan->num_rows;
+
+    for (int i = first; i < last; i++) {
+        int y = plan->rows[i];
+        horizontal_row(&plan->horizontal, job->src + y * job->src_stride,
+                       plan->temp + y * row_bytes, plan->channels);
+    }
+}
+
+static void vertical_band(void* arg, int band) {
+    ResizeJob* job = (ResizeJob*)arg;
+    ResizePlan* plan = job->plan;
+    size_t row_bytes = (size_t)plan->dst_width * plan->channels;
+    int first = band * job->band_rows;
+    int last = first + job->band_rows;
+    if (last > plan->dst_height) last = plan->dst_height;
+
+    for (int y = first; y < last; y++) {
+        vertical_row(&plan->vertical, plan->temp, row_bytes, y, job->dst->data + y * row_bytes);
+    }
+}
+
+static int band_count(int rows, int bands, int* band_rows) {
+    *band_rows = (rows + bands - 1) / bands;
+    if (*band_rows < 1) *band_rows = 1;
+    return (rows + *band_rows - 1) / *band_rows;
+}
+
+// Horizontal pass into the plan's scratch rows, then the vertical pass into
+// dst. With a pool and enough work, both passes split rows into bands. The
+// pool must not be one whose task is calling this.
+int resize_plan_run(ResizePlan* plan, const Image* src, Image* dst, ThreadPool* pool) {
+    if (!plan || !src || !src->data) return 0;
+    if (src->width != plan->src_width || src->height != plan->src_height ||
+        src->channels != plan->channels) {
+        return 0;
+    }
+    return resize_plan_run_strided(plan, src->data, (size_t)src->width * src->channels, dst, pool);
+}
+
+// Same as resize_plan_run for a source whose rows are stride bytes apart,
+// such as one plane of a decoded frame
+int resize_plan_run_strided(ResizePlan* plan, const uint8_t* src, size_t src_stride, Image* dst,
+                            ThreadPool* pool) {
+    if (!plan || !src || !dst || !dst->data) return 0;
+    if (dst->width != plan->dst_width || dst->height != plan->dst_height ||
+        dst->channels != plan->channels || src_stride < (size_t)plan->src_width * plan->channels) {
+        return 0;
+    }
+
+    uint64_t span = span_begin();
+    ResizeJob job = {plan, src, src_stride, dst, 0};
+    int bands = 1;
+    if (pool && plan->work >= RESIZE_PARALLEL_MIN_WORK) {
+        bands = (pool->num_threads + 1) * RESIZE_BANDS_PER_THREAD;
+    }
+
+    int count = band_count(plan->num_rows, bands, &job.band_rows);
+    thread_pool_parallel_for(bands > 1 ? pool : NULL, count, horizontal_band, &job);
+
+    count = band_count(plan->dst_height, bands, &job.band_rows);
+    thread_pool_parallel_for(bands > 1 ? pool : NULL, count, vertical_band, &job);
+    span_end("resize", span);
+    return 1;
+}
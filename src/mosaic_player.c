@@ -0,0 +1,390 @@
+#define _GNU_SOURCE
+#include "mosaic_player.h"
+#include "video_sdl_player.h"
+#include "image_processing.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static double mosaic_clock_ms(const MosaicPlayer* mp) {
+    double now = mp->paused ? mp->pause_start_ms : get_current_time_ms();
+    return now - mp->clock_start_ms;
+}
+
+// Runs on a pool worker. A tile that has fallen behind the shared clock
+// decodes and discards frames (bounded per job) so only its own output
+// degrades; the converted result lands in the back buffer.
+static void mosaic_tile_job(void* arg) {
+    MosaicTile* tile = (MosaicTile*)arg;
+    double start = get_current_time_ms();
+    int skipped = 0;
+
+    while (tile->media_ms + tile->frame_interval_ms <= tile->job_clock_ms &&
+           skipped < MOSAIC_MAX_CATCHUP) {
+        if (!video_processor_skip_frame(tile->video_processor)) {
+            video_processor_reset(tile->video_processor);
+            break;
+        }
+        tile->media_ms += tile->frame_interval_ms;
+        skipped++;
+    }
+
+    int decoded = video_processor_read_frame(tile->video_processor, tile->frame_buffer);
+    if (!decoded) {
+        // Loop this tile on its own; the others keep playing
+        video_processor_reset(tile->video_processor);
+        decoded = video_processor_read_frame(tile->video_processor, tile->frame_buffer);
+    }
+    tile->media_ms += tile->frame_interval_ms;
+
+    if (decoded) {
+        // Already on a pool worker, so the resize stays on this thread
+        resize_plan_run(tile->resize_plan, tile->frame_buffer, tile->grid_buffer, NULL);
+        decoded = image_to_ascii_into(tile->grid_buffer, tile->ascii_config,
+                                      tile->ascii_back, tile->ascii_size);
+    }
+
+    tile->frames_dropped += skipped;
+    tile->job_time_ms = get_current_time_ms() - start;
+
+    if (decoded) {
+        __atomic_store_n(&tile->ready, 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&tile->busy, 0, __ATOMIC_RELEASE);
+}
+
+// Splits the display grid into tiles and sizes each tile's buffers.
+// Workers must be idle when this runs.
+static int mosaic_player_layout(MosaicPlayer* mp) {
+    if (!sdl_display_grid_size(mp->display, &mp->cols, &mp->rows)) return 0;
+
+    mp->tiles_x = (int)ceil(sqrt((double)mp->num_tiles));
+    mp->tiles_y = (mp->num_tiles + mp->tiles_x - 1) / mp->tiles_x;
+
+    // One blank column/row between tiles
+    int tile_cols = mp->cols / mp->tiles_x - 1;
+    int tile_rows = mp->rows / mp->tiles_y - 1;
+    if (tile_cols < 1) tile_cols = 1;
+    if (tile_rows < 1) tile_rows = 1;
+
+    for (int i = 0; i < mp->num_tiles; i++) {
+        MosaicTile* tile = &mp->tiles[i];
+        int grid_w, grid_h, max_grid_w, max_grid_h;
+        ascii_grid_limits(&mp->ascii_config, tile_cols, tile_rows, &max_grid_w, &max_grid_h);
+        fit_aspect_ratio(tile->frame_buffer->width, tile->frame_buffer->height,
+                         max_grid_w, max_grid_h, &grid_w, &grid_h);
+
+        if (!tile->grid_buffer || tile->grid_buffer->width != grid_w ||
+            tile->grid_buffer->height != grid_h) {
+            Image* grid = create_image(grid_w, grid_h, 3);
+            if (!grid) return 0;
+            free_image(tile->grid_buffer);
+            tile->grid_buffer = grid;
+        }
+
+        tile->resize_plan = resize_plan_update(tile->resize_plan, tile->frame_buffer,
+                                               tile->grid_buffer, RESIZE_DEFAULT_FILTER);
+        if (!tile->resize_plan) return 0;
+
+        size_t needed = ascii_buffer_size(grid_w, grid_h, &mp->ascii_config);
+        if (needed > tile->ascii_size) {
+            char* front = realloc(tile->ascii_front, needed);
+            if (!front) return 0;
+            tile->ascii_front = front;
+            char* back = realloc(tile->ascii_back, needed);
+            if (!back) return 0;
+            tile->ascii_back = back;
+            tile->ascii_size = needed;
+        }
+        tile->ascii_front[0] = '\0';
+        tile->ready = 0;
+
+        tile->text_cols = ascii_output_width(grid_w, &mp->ascii_config);
+        tile->text_rows = ascii_output_height(grid_h, &mp->ascii_config);
+        tile->cell_x = (i % mp->tiles_x) * (tile_cols + 1);
+        tile->cell_y = (i / mp->tiles_x) * (tile_rows + 1);
+    }
+
+    size_t needed = (size_t)(mp->cols + 1) * mp->rows + 1;
+    if (needed > mp->composite_size) {
+        char* composite = realloc(mp->composite, needed);
+        if (!composite) return 0;
+        mp->composite = composite;
+        mp->composite_size = needed;
+    }
+
+    return 1;
+}
+
+// Rebuilds the whole composite grid from each tile's front buffer. Tiles
+// use the default single-byte charset, so bytes map 1:1 to cells.
+static void mosaic_player_compose(MosaicPlayer* mp) {
+    char* out = mp->composite;
+
+    for (int y = 0; y < mp->rows; y++) {
+        char* row = out;
+        memset(row, ' ', mp->cols);
+        row[mp->cols] = '\n';
+        out += mp->cols + 1;
+    }
+    *out = '\0';
+
+    for (int i = 0; i < mp->num_tiles; i++) {
+        const MosaicTile* tile = &mp->tiles[i];
+        const char* src = tile->ascii_front;
+
+        for (int y = 0; y < tile->text_rows && *src; y++) {
+            int dst_y = tile->cell_y + y;
+            const char* eol = strchr(src, '\n');
+            int len = eol ? (int)(eol - src) : (int)strlen(src);
+
+            if (dst_y < mp->rows) {
+                int room = mp->cols - tile->cell_x;
+                int n = len < room ? len : room;
+                if (n > 0) {
+                    memcpy(mp->composite + (size_t)dst_y * (mp->cols + 1) + tile->cell_x, src, n);
+                }
+            }
+
+            if (!eol) break;
+            src = eol + 1;
+        }
+    }
+}
+
+MosaicPlayer* mosaic_player_init(const char** video_files, int num_files, int window_width,
+                                 int window_height, int num_threads) {
+    if (!video_files || num_files <= 0) {
+        fprintf(stderr, "Error: No video files specified\n");
+        return NULL;
+    }
+
+    MosaicPlayer* mp = calloc(1, sizeof(MosaicPlayer));
+    if (!mp) {
+        fprintf(stderr, "Error: Cannot allocate memory for mosaic player\n");
+        return NULL;
+    }
+
+    mp->tiles = calloc(num_files, sizeof(MosaicTile));
+    if (!mp->tiles) {
+        fprintf(stderr, "Error: Cannot allocate memory for mosaic tiles\n");
+        free(mp);
+        return NULL;
+    }
+    mp->num_tiles = num_files;
+    mp->ascii_config = create_default_config();
+    mp->show_stats = 1;
+
+    for (int i = 0; i < num_files; i++) {
+        MosaicTile* tile = &mp->tiles[i];
+        tile->source = video_files[i];
+        tile->ascii_config = &mp->ascii_config;
+        tile->video_processor = video_processor_init(video_files[i]);
+        if (!tile->video_processor) {
+            fprintf(stderr, "Error: Failed to open %s\n", video_files[i]);
+            mosaic_player_cleanup(mp);
+            return NULL;
+        }
+
+        double fps = video_processor_get_fps(tile->video_processor);
+        tile->frame_interval_ms = fps > 0.0 ? 1000.0 / fps : 1000.0 / 30.0;
+        tile->frame_buffer = create_image(video_processor_get_width(tile->video_processor),
+                                          video_processor_get_height(tile->video_processor), 3);
+        if (!tile->frame_buffer) {
+            fprintf(stderr, "Error: Cannot allocate frame buffer for %s\n", video_files[i]);
+            mosaic_player_cleanup(mp);
+            return NULL;
+        }
+    }
+
+    if (num_threads <= 0) num_threads = thread_pool_cpu_count();
+    if (num_threads > num_files) num_threads = num_files;
+
+    // Each tile has at most one job in flight, so the queue never needs more
+    mp->pool = thread_pool_create(num_threads, num_files);
+    if (!mp->pool) {
+        fprintf(stderr, "Error: Failed to create worker pool\n");
+        mosaic_player_cleanup(mp);
+        return NULL;
+    }
+
+    mp->display = sdl_display_init(window_width, window_height, NULL);
+    if (!mp->display) {
+        fprintf(stderr, "Error: Failed to initialize SDL display\n");
+        mosaic_player_cleanup(mp);
+        return NULL;
+    }
+    // The tiles keep the pool busy, so the raster draws on this thread
+    if (mp->display->software_renderer) sdl_display_set_raster(mp->display, 1, NULL);
+
+    if (!mosaic_player_layout(mp)) {
+        fprintf(stderr, "Error: Cannot allocate mosaic buffers\n");
+        mosaic_player_cleanup(mp);
+        return NULL;
+    }
+
+    printf("Mosaic Player Initialized:\n");
+    printf("  Tiles: %d (%dx%d)\n", mp->num_tiles, mp->tiles_x, mp->tiles_y);
+    printf("  Workers: %d\n", mp->pool->num_threads);
+    printf("  ASCII dimensions: %dx%d characters\n", mp->cols, mp->rows);
+
+    return mp;
+}
+
+void mosaic_player_cleanup(MosaicPlayer* mp) {
+    if (!mp) return;
+
+    // Workers reference tile buffers, so stop them first
+    if (mp->pool) thread_pool_destroy(mp->pool);
+
+    for (int i = 0; i < mp->num_tiles; i++) {
+        MosaicTile* tile = &mp->tiles[i];
+        if (tile->video_processor) video_processor_cleanup(tile->video_processor);
+        free_image(tile->frame_buffer);
+        free_image(tile->grid_buffer);
+        resize_plan_destroy(tile->resize_plan);
+        free(tile->ascii_front);
+        free(tile->ascii_back);
+    }
+
+    if (mp->display) sdl_display_cleanup(mp->display);
+    free(mp->composite);
+    free(mp->tiles);
+    free(mp);
+}
+
+static int mosaic_player_handle_events(MosaicPlayer* mp) {
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        switch (e.type) {
+            case SDL_QUIT:
+                return 0;
+
+            case SDL_WINDOWEVENT:
+                if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                    mp->resize_pending = 1;
+                    mp->pending_width = e.window.data1;
+                    mp->pending_height = e.window.data2;
+                }
+                break;
+
+            case SDL_KEYDOWN:
+                switch (e.key.keysym.sym) {
+                    case SDLK_q:
+                    case SDLK_ESCAPE:
+                        return 0;
+
+                    case SDLK_SPACE:
+                        if (mp->paused) {
+                            mp->clock_start_ms += get_current_time_ms() - mp->pause_start_ms;
+                            mp->paused = 0;
+                        } else {
+                            mp->pause_start_ms = get_current_time_ms();
+                            mp->paused = 1;
+                        }
+                        break;
+
+                    case SDLK_t:
+                        mp->show_stats = !mp->show_stats;
+                        break;
+                }
+                break;
+        }
+    }
+
+    return 1;
+}
+
+int mosaic_player_run(MosaicPlayer* mp) {
+    if (!mp) return -1;
+
+    printf("Starting mosaic player...\n");
+    mp->clock_start_ms = get_current_time_ms();
+
+    int64_t presented = 0;
+    double job_time_total = 0.0;
+    int64_t job_count = 0;
+    double fps_window_start = get_current_time_ms();
+    int64_t fps_window_frames = 0;
+    double display_fps = 0.0;
+
+    while (mosaic_player_handle_events(mp)) {
+        if (mp->resize_pending) {
+            mp->resize_pending = 0;
+            thread_pool_wait_idle(mp->pool);
+            for (int i = 0; i < mp->num_tiles; i++) {
+                mp->tiles[i].busy = 0;
+            }
+            if (!sdl_display_resize(mp->display, mp->pending_width, mp->pending_height) ||
+                !mosaic_player_layout(mp)) {
+                fprintf(stderr, "Error: Failed to resize mosaic\n");
+                break;
+            }
+        }
+
+        double clock = mosaic_clock_ms(mp);
+        int updated = 0;
+
+        for (int i = 0; i < mp->num_tiles; i++) {
+            MosaicTile* tile = &mp->tiles[i];
+            if (__atomic_load_n(&tile->busy, __ATOMIC_ACQUIRE)) continue;
+
+            if (tile->ready) {
+                char* tmp = tile->ascii_front;
+                tile->ascii_front = tile->ascii_back;
+                tile->ascii_back = tmp;
+                tile->ready = 0;
+                tile->frames_shown++;
+                job_time_total += tile->job_time_ms;
+                job_count++;
+                updated = 1;
+            }
+
+            if (!mp->paused && tile->media_ms <= clock) {
+                tile->job_clock_ms = clock;
+                tile->busy = 1;
+                if (!thread_pool_submit(mp->pool, mosaic_tile_job, tile)) {
+                    tile->busy = 0;
+                }
+            }
+        }
+
+        // One batched draw for every tile that changed since the last present
+        if (updated) {
+            mosaic_player_compose(mp);
+
+            SDLPerformanceStats stats = {0};
+            if (mp->show_stats) {
+                stats.fps = display_fps;
+                stats.frame_count = (int)presented;
+                stats.avg_process_time = job_count > 0 ? job_time_total / job_count : 0.0;
+            }
+            sdl_display_frame_split(mp->display, NULL, mp->composite,
+                                    mp->show_stats ? &stats : NULL);
+            presented++;
+            fps_window_frames++;
+
+            double now = get_current_time_ms();
+            if (now - fps_window_start >= 1000.0) {
+                display_fps = fps_window_frames * 1000.0 / (now - fps_window_start);
+                fps_window_start = now;
+                fps_window_frames = 0;
+                job_time_total = 0.0;
+                job_count = 0;
+            }
+        }
+
+        SDL_Delay(1);
+    }
+
+    thread_pool_wait_idle(mp->pool);
+
+    printf("Mosaic player stopped\n");
+    for (int i = 0; i < mp->num_tiles; i++) {
+        printf("  Tile %d (%s): %ld frames shown, %ld dropped\n", i, mp->tiles[i].source,
+               mp->tiles[i].frames_shown, mp->tiles[i].frames_dropped);
+    }
+
+    return 0;
+}
@@ -1,53 +1,48 @@
+#define _GNU_SOURCE
 #include "sdl_display.h"
+#include "span_trace.h"
 #include "image_processing.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-SDLDisplay* sdl_display_init(int width, int height) {
+SDLDisplay* sdl_display_init(int width, int height, StartupProfile* profile) {
     SDLDisplay* display = malloc(sizeof(SDLDisplay));
     if (!display) return NULL;
     
     memset(display, 0, sizeof(SDLDisplay));
     
+    double phase_start = startup_now_ms();
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         fprintf(stderr, "SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
         free(display);
         return NULL;
     }
+    startup_profile_record(profile, STARTUP_PHASE_SDL_INIT, phase_start);
     
+    phase_start = startup_now_ms();
     if (TTF_Init() == -1) {
         fprintf(stderr, "SDL_ttf could not initialize! SDL_ttf Error: %s\n", TTF_GetError());
         SDL_Quit();
         free(display);
         return NULL;
     }
+    startup_profile_record(profile, STARTUP_PHASE_TTF_INIT, phase_start);
     
     display->font_size = DEFAULT_FONT_SIZE;
 
-    const char* font_paths[] = {
-        "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
-        "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
-        "/System/Library/Fonts/Monaco.ttf",
-        "/usr/share/fonts/truetype/liberation/LiberationMono-Regular.ttf",
-        NULL
-    };
-
-    for (int i = 0; font_paths[i] != NULL; i++) {
-        display->font = TTF_OpenFont(font_paths[i], display->font_size);
-        if (display->font) break;
-    }
+    phase_start = startup_now_ms();
+    int cache_hit = 0;
+    display->font = font_loader_open(display->font_size, &display->char_width,
+                                     &display->char_height, &cache_hit);
+    if (profile) profile->font_cache_hit = cache_hit;
 
     if (!display->font) {
         fprintf(stderr, "Warning: Could not load any font, using default\n");
         display->char_width = 7;
         display->char_height = 14;
-    } else {
-        int w, h;
-        TTF_SizeText(display->font, "M", &w, &h);
-        display->char_width = w;
-        display->char_height = h;
     }
+    startup_profile_record(profile, STARTUP_PHASE_FONT_LOAD, phase_start);
 
     int ascii_cols = width / display->char_width;
     int ascii_rows = height / display->char_height;
@@ -58,8 +53,12 @@ SDLDisplay* sdl_display_init(int width, int height) {
     display->video_height = display->window_height;
     display->ascii_width = display->window_width;
     display->ascii_height = display->window_height;
+    display->text_width = display->ascii_width;
+    display->text_height = display->ascii_height;
+    display->present_ms = 0.0;
     display->font_size = DEFAULT_FONT_SIZE;
     
+    phase_start = startup_now_ms();
     display->window = SDL_CreateWindow("ASCII Video Player",
                                       SDL_WINDOWPOS_UNDEFINED,
                                       SDL_WINDOWPOS_UNDEFINED,
@@ -77,6 +76,10 @@ SDLDisplay* sdl_display_init(int width, int height) {
     
     display->renderer = SDL_CreateRenderer(display->window, -1, 
                                           SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if (!display->renderer) {
+        fprintf(stderr, "Warning: No accelerated renderer (%s), using software\n", SDL_GetError());
+        display->renderer = SDL_CreateRenderer(display->window, -1, SDL_RENDERER_SOFTWARE);
+    }
     
     if (!display->renderer) {
         fprintf(stderr, "Renderer could not be created! SDL_Error: %s\n", SDL_GetError());
@@ -97,6 +100,13 @@ SDLDisplay* sdl_display_init(int width, int height) {
         return NULL;
     }
     
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(display->renderer, &info) == 0) {
+        display->software_renderer = (info.flags & SDL_RENDERER_SOFTWARE) != 0;
+    }
+
+    startup_profile_record(profile, STARTUP_PHASE_WINDOW, phase_start);
+
     printf("SDL Display initialized: %dx%d window, font size: %d, char: %dx%d\n",
            display->window_width, display->window_height, 
            display->font_size, display->char_width, display->char_height);
@@ -135,15 +145,46 @@ SDL_Texture* create_texture_from_image(SDLDisplay* display, const Image* img) {
     return texture;
 }
 
+static int ensure_ascii_texture(SDLDisplay* display) {
+    if (display->ascii_texture) return 1;
+
+    display->ascii_texture = SDL_CreateTexture(display->renderer,
+                                               SDL_PIXELFORMAT_RGBA8888,
+                                               SDL_TEXTUREACCESS_TARGET,
+                                               display->ascii_width, display->ascii_height);
+    return display->ascii_texture != NULL;
+}
+
+// Rasterizes the grid on the CPU and uploads it with one texture update;
+// only the part the grid fills is locked
+static SDL_Texture* raster_texture_from_ascii(SDLDisplay* display, const char* ascii_art) {
+    if (!display->raster_texture) {
+        display->raster_texture = SDL_CreateTexture(display->renderer, SDL_PIXELFORMAT_RGB888,
+                                                    SDL_TEXTUREACCESS_STREAMING,
+                                                    display->ascii_width, display->ascii_height);
+        if (!display->raster_texture) return NULL;
+        SDL_SetTextureBlendMode(display->raster_texture, SDL_BLENDMODE_NONE);
+    }
+
+    SDL_Rect text_rect = {0, 0, display->text_width, display->text_height};
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(display->raster_texture, &text_rect, &pixels, &pitch) != 0) return NULL;
+    int ok = ascii_raster_render_xrgb(display->raster, ascii_art, (uint32_t*)pixels,
+                                      display->text_width, display->text_height,
+                                      pitch / (int)sizeof(uint32_t));
+    SDL_UnlockTexture(display->raster_texture);
+
+    return ok ? display->raster_texture : NULL;
+}
+
 SDL_Texture* create_texture_from_ascii(SDLDisplay* display, const char* ascii_art) {
     if (!display || !ascii_art) return NULL;
+    if (display->raster) return raster_texture_from_ascii(display, ascii_art);
     
-    SDL_Texture* texture = SDL_CreateTexture(display->renderer,
-                                           SDL_PIXELFORMAT_RGBA8888,
-                                           SDL_TEXTUREACCESS_TARGET,
-                                           display->ascii_width, display->ascii_height);
-    
-    if (!texture) return NULL;
+    // The target texture lives as long as the current window size
+    if (!ensure_ascii_texture(display)) return NULL;
+    SDL_Texture* texture = display->ascii_texture;
     
     SDL_SetRenderTarget(display->renderer, texture);
     
@@ -152,34 +193,41 @@ SDL_Texture* create_texture_from_ascii(SDLDisplay* display, const char* ascii_ar
     
     SDL_Color white = {255, 255, 255, 255};
 
-    int x = 0, y = 0; 
+    int y = 0;
     const char* ptr = ascii_art;
-    char line[1024];
-    int line_pos = 0;
     
-    while (*ptr) {
-        if (*ptr == '\n' || line_pos >= (int)sizeof(line) - 1) {
-            line[line_pos] = '\0';
-            if (line_pos > 0) {
-                SDL_Surface* text_surface = TTF_RenderText_Solid(display->font, line, white);
-                if (text_surface) {
-                    SDL_Texture* text_texture = SDL_CreateTextureFromSurface(display->renderer, text_surface);
-                    if (text_texture) {
-                        SDL_Rect dst_rect = {x, y, text_surface->w, text_surface->h};
-                        SDL_RenderCopy(display->renderer, text_texture, NULL, &dst_rect);
-                        SDL_DestroyTexture(text_texture);
-                    }
-                    SDL_FreeSurface(text_surface);
+    // Rows are copied whole (they may hold multibyte UTF-8 glyphs) into a
+    // line buffer that only grows
+    while (*ptr && y < display->text_height) {
+        const char* eol = strchr(ptr, '\n');
+        size_t len = eol ? (size_t)(eol - ptr) : strlen(ptr);
+
+        if (len > 0 && len + 1 > display->line_capacity) {
+            char* grown = realloc(display->line_buffer, len + 1);
+            if (!grown) break;
+            display->line_buffer = grown;
+            display->line_capacity = len + 1;
+        }
+
+        if (len > 0) {
+            memcpy(display->line_buffer, ptr, len);
+            display->line_buffer[len] = '\0';
+
+            SDL_Surface* text_surface = TTF_RenderUTF8_Solid(display->font, display->line_buffer, white);
+            if (text_surface) {
+                SDL_Texture* text_texture = SDL_CreateTextureFromSurface(display->renderer, text_surface);
+                if (text_texture) {
+                    SDL_Rect dst_rect = {0, y, text_surface->w, text_surface->h};
+                    SDL_RenderCopy(display->renderer, text_texture, NULL, &dst_rect);
+                    SDL_DestroyTexture(text_texture);
                 }
+                SDL_FreeSurface(text_surface);
             }
-            y += display->char_height;
-            line_pos = 0;
-
-            if (y >= display->ascii_height) break;
-        } else {
-            line[line_pos++] = *ptr;
         }
-        ptr++;
+
+        y += display->char_height;
+        if (!eol) break;
+        ptr = eol + 1;
     }
 
     SDL_SetRenderTarget(display->renderer, NULL);
@@ -187,43 +235,238 @@ SDL_Texture* create_texture_from_ascii(SDLDisplay* display, const char* ascii_ar
     return texture;
 }
 
+int sdl_display_resize(SDLDisplay* display, int width, int height) {
+    if (!display || width <= 0 || height <= 0) return 0;
+
+    if (width == display->window_width && height == display->window_height && display->ascii_texture) {
+        return 1;
+    }
+
+    display->window_width = width;
+    display->window_height = height;
+    display->ascii_width = width;
+    display->ascii_height = height;
+    display->text_width = width;
+    display->text_height = height;
+    display->video_width = width / 2;
+    display->video_height = height;
+
+    // Dropped here and recreated lazily at the new size on the next frame
+    display->shown_texture = NULL;
+    if (display->ascii_texture) {
+        SDL_DestroyTexture(display->ascii_texture);
+        display->ascii_texture = NULL;
+    }
+    if (display->raster_texture) {
+        SDL_DestroyTexture(display->raster_texture);
+        display->raster_texture = NULL;
+    }
+
+    return 1;
+}
+
+int sdl_display_grid_size(const SDLDisplay* display, int* cols, int* rows) {
+    if (!display || display->char_width <= 0 || display->char_height <= 0) return 0;
+
+    *cols = display->window_width / display->char_width;
+    *rows = display->window_height / display->char_height;
+    if (*cols < 1) *cols = 1;
+    if (*rows < 1) *rows = 1;
+    return 1;
+}
+
+// Grids smaller than the window's are drawn into the top-left of the same
+// texture and scaled up on copy, so changing the grid never recreates it
+void sdl_display_set_text_grid(SDLDisplay* display, int cols, int rows) {
+    if (!display) return;
+
+    display->text_width = cols * display->char_width;
+    display->text_height = rows * display->char_height;
+    if (display->text_width > display->ascii_width) display->text_width = display->ascii_width;
+    if (display->text_height > display->ascii_height) display->text_height = display->ascii_height;
+    if (display->text_width < 1) display->text_width = 1;
+    if (display->text_height < 1) display->text_height = 1;
+}
+
+// Switches text drawing between per-line TTF rendering and the glyph
+// raster, which splits its rows across the pool. The glyph cells must match
+// the display's character cell, or the grid would not line up.
+int sdl_display_set_raster(SDLDisplay* display, int enabled, ThreadPool* pool) {
+    if (!display) return 0;
+
+    if (!enabled) {
+        ascii_raster_destroy(display->raster);
+        glyph_cache_destroy(display->glyphs);
+        if (display->raster_texture) SDL_DestroyTexture(display->raster_texture);
+        display->raster = NULL;
+        display->glyphs = NULL;
+        display->raster_texture = NULL;
+        display->shown_texture = NULL;
+        printf("Text backend: TTF\n");
+        return 1;
+    }
+
+    if (!display->glyphs) {
+        display->glyphs = glyph_cache_create(display->font_size);
+        if (!display->glyphs) return 0;
+    }
+    if (display->glyphs->cell_width != display->char_width ||
+        display->glyphs->cell_height != display->char_height) {
+        fprintf(stderr, "Error: Glyph cells are %dx%d, the display's %dx%d\n",
+                display->glyphs->cell_width, display->glyphs->cell_height,
+                display->char_width, display->char_height);
+        glyph_cache_destroy(display->glyphs);
+        display->glyphs = NULL;
+        return 0;
+    }
+
+    ascii_raster_destroy(display->raster);
+    display->raster = ascii_raster_create(display->glyphs, pool);
+    if (!display->raster) return 0;
+    printf("Text backend: glyph raster\n");
+    return 1;
+}
+
+// Paints a half-block grid image: every pixel is half a character cell,
+// so the image is drawn in luma and stretched over the cells it covers.
+static void draw_halfblock_image(SDLDisplay* display, const Image* img) {
+    if (display->video_texture && (display->video_texture_width != img->width ||
+                                   display->video_texture_height != img->height)) {
+        SDL_DestroyTexture(display->video_texture);
+        display->video_texture = NULL;
+    }
+
+    if (!display->video_texture) {
+        display->video_texture = SDL_CreateTexture(display->renderer, SDL_PIXELFORMAT_RGB24,
+                                                   SDL_TEXTUREACCESS_STREAMING,
+                                                   img->width, img->height);
+        if (!display->video_texture) return;
+        display->video_texture_width = img->width;
+        display->video_texture_height = img->height;
+    }
+
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(display->video_texture, NULL, &pixels, &pitch) != 0) return;
+
+    for (int y = 0; y < img->height; y++) {
+        uint8_t* dst = (uint8_t*)pixels + (size_t)y * pitch;
+        for (int x = 0; x < img->width; x++) {
+            uint8_t luma = get_pixel_brightness(img, x, y);
+            dst[x * 3] = luma;
+            dst[x * 3 + 1] = luma;
+            dst[x * 3 + 2] = luma;
+        }
+    }
+    SDL_UnlockTexture(display->video_texture);
+
+    int cells_w = img->width * display->char_width;
+    int cells_h = img->height / 2 * display->char_height;
+    SDL_Rect dst_rect = {0, 0, cells_w * display->ascii_width / display->text_width,
+                         cells_h * display->ascii_height / display->text_height};
+    SDL_RenderCopy(display->renderer, display->video_texture, NULL, &dst_rect);
+
+    display->shown_texture = display->video_texture;
+    display->shown_src = (SDL_Rect){0, 0, img->width, img->height};
+    display->shown_dst = dst_rect;
+}
+
+static void draw_stats(SDLDisplay* display, const SDLPerformanceStats* stats) {
+    char stats_text[256];
+    int len = snprintf(stats_text, sizeof(stats_text), "FPS: %.1f | Frames: %d | Process: %.1fms",
+                       stats->fps, stats->frame_count, stats->avg_process_time);
+    if (stats->speed != 0.0 && len > 0 && (size_t)len < sizeof(stats_text)) {
+        len += snprintf(stats_text + len, sizeof(stats_text) - len,
+                        " | Speed: %.2fx (actual %.2fx)", stats->speed, stats->actual_speed);
+    }
+    if (stats->static_rate > 0.0 && len > 0 && (size_t)len < sizeof(stats_text)) {
+        len += snprintf(stats_text + len, sizeof(stats_text) - len, " | Static: %.0f%%",
+                        stats->static_rate * 100.0);
+    }
+    if (stats->change_rate > 0.0 && len > 0 && (size_t)len < sizeof(stats_text)) {
+        len += snprintf(stats_text + len, sizeof(stats_text) - len, " | Changed: %.1f%%",
+                        stats->change_rate * 100.0);
+    }
+    if (stats->grid_cols > 0 && len > 0 && (size_t)len < sizeof(stats_text)) {
+        len += snprintf(stats_text + len, sizeof(stats_text) - len, " | Grid: %dx%d",
+                        stats->grid_cols, stats->grid_rows);
+    }
+    if (stats->av_sync && len > 0 && (size_t)len < sizeof(stats_text)) {
+        len += snprintf(stats_text + len, sizeof(stats_text) - len,
+                        " | A/V: %+.0f ms, %lld dropped, %lld underruns",
+                        stats->av_drift_ms, (long long)stats->frames_dropped,
+                        (long long)stats->audio_underruns);
+    }
+    if (stats->rss_peak_mb > 0.0 && len > 0 && (size_t)len < sizeof(stats_text)) {
+        snprintf(stats_text + len, sizeof(stats_text) - len,
+                 " | Allocs: %llu (%.1f KB) | Heap peak: %.1f MB | RSS peak: %.1f MB",
+                 (unsigned long long)stats->frame_allocs, stats->frame_alloc_bytes / 1024.0,
+                 stats->heap_peak_mb, stats->rss_peak_mb);
+    }
+
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface* text_surface = TTF_RenderText_Solid(display->font, stats_text, white);
+    if (text_surface) {
+        SDL_Texture* text_texture = SDL_CreateTextureFromSurface(display->renderer, text_surface);
+        if (text_texture) {
+            SDL_Rect text_rect = {10, display->window_height - 30, text_surface->w, text_surface->h};
+            SDL_RenderCopy(display->renderer, text_texture, NULL, &text_rect);
+            SDL_DestroyTexture(text_texture);
+        }
+        SDL_FreeSurface(text_surface);
+    }
+}
+
+static void present(SDLDisplay* display) {
+    uint64_t span = span_begin();
+    double present_start = startup_now_ms();
+    SDL_RenderPresent(display->renderer);
+    display->present_ms = startup_now_ms() - present_start;
+    span_end("SDL_RenderPresent", span);
+}
 
 int sdl_display_frame_split(SDLDisplay* display, const Image* img, const char* ascii_art, SDLPerformanceStats* stats) {
-    (void)img;
     if (!display) return -1;
 
     SDL_SetRenderDrawColor(display->renderer, 0, 0, 0, 255);
     SDL_RenderClear(display->renderer);
+    display->shown_texture = NULL;
+
+    if (!ascii_art && img) {
+        draw_halfblock_image(display, img);
+    }
 
     if (ascii_art) {
+        uint64_t span = span_begin();
         SDL_Texture* ascii_texture = create_texture_from_ascii(display, ascii_art);
+        span_end("create_texture_from_ascii", span);
         if (ascii_texture) {
+            SDL_Rect text_rect = {0, 0, display->text_width, display->text_height};
             SDL_Rect ascii_rect = {0, 0, display->ascii_width, display->ascii_height};
-            SDL_RenderCopy(display->renderer, ascii_texture, NULL, &ascii_rect);
-            SDL_DestroyTexture(ascii_texture);
-        }
-    }
-    
-    if (stats) {
-        char stats_text[256];
-        snprintf(stats_text, sizeof(stats_text), "FPS: %.1f | Frames: %d | Process: %.1fms", 
-                stats->fps, stats->frame_count, stats->avg_process_time);
-        
-        SDL_Color white = {255, 255, 255, 255};
-        SDL_Surface* text_surface = TTF_RenderText_Solid(display->font, stats_text, white);
-        if (text_surface) {
-            SDL_Texture* text_texture = SDL_CreateTextureFromSurface(display->renderer, text_surface);
-            if (text_texture) {
-                SDL_Rect text_rect = {10, display->window_height - 30, text_surface->w, text_surface->h};
-                SDL_RenderCopy(display->renderer, text_texture, NULL, &text_rect);
-                SDL_DestroyTexture(text_texture);
-            }
-            SDL_FreeSurface(text_surface);
+            SDL_RenderCopy(display->renderer, ascii_texture, &text_rect, &ascii_rect);
+            display->shown_texture = ascii_texture;
+            display->shown_src = text_rect;
+            display->shown_dst = ascii_rect;
         }
     }
     
-    SDL_RenderPresent(display->renderer);
-    
+    if (stats) draw_stats(display, stats);
+    present(display);
+
+    return 0;
+}
+
+// Repaints the last frame from its texture with a fresh overlay, for
+// frames that matched the one on screen and were not converted
+int sdl_display_redraw(SDLDisplay* display, SDLPerformanceStats* stats) {
+    if (!display || !display->shown_texture) return -1;
+
+    SDL_SetRenderDrawColor(display->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(display->renderer);
+    SDL_RenderCopy(display->renderer, display->shown_texture, &display->shown_src, &display->shown_dst);
+    if (stats) draw_stats(display, stats);
+    present(display);
+
     return 0;
 }
 
@@ -264,6 +507,12 @@ int sdl_handle_events(void) {
 
 void sdl_display_cleanup(SDLDisplay* display) {
     if (display) {
+        if (display->ascii_texture) SDL_DestroyTexture(display->ascii_texture);
+        if (display->video_texture) SDL_DestroyTexture(display->video_texture);
+        if (display->raster_texture) SDL_DestroyTexture(display->raster_texture);
+        ascii_raster_destroy(display->raster);
+        glyph_cache_destroy(display->glyphs);
+        free(display->line_buffer);
         if (display->font) TTF_CloseFont(display->font);
         if (display->renderer) SDL_DestroyRenderer(display->renderer);
         if (display->window) SDL_DestroyWindow(display->window);
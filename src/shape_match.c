@@ -0,0 +1,168 @@
+#include "shape_match.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define SHAPE_MASK_BITS (SHAPE_MASK_SIZE * SHAPE_MASK_SIZE)
+
+static inline int popcount64(uint64_t x) {
+#ifdef __POPCNT__
+    return __builtin_popcountll(x);
+#else
+    // Without the instruction the builtin is a library call
+    x -= (x >> 1) & 0x5555555555555555ULL;
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Area-averages the glyph's coverage into the 8x8 mask grid; cells smaller
+// than 8 pixels on a side reuse their nearest pixel
+static uint64_t glyph_mask(const uint8_t* bitmap, int width, int height) {
+    uint64_t mask = 0;
+
+    for (int my = 0; my < SHAPE_MASK_SIZE; my++) {
+        int y0 = my * height / SHAPE_MASK_SIZE;
+        int y1 = (my + 1) * height / SHAPE_MASK_SIZE;
+        if (y1 <= y0) y1 = y0 + 1;
+
+        for (int mx = 0; mx < SHAPE_MASK_SIZE; mx++) {
+            int x0 = mx * width / SHAPE_MASK_SIZE;
+            int x1 = (mx + 1) * width / SHAPE_MASK_SIZE;
+            if (x1 <= x0) x1 = x0 + 1;
+
+            int sum = 0;
+            for (int y = y0; y < y1; y++) {
+                for (int x = x0; x < x1; x++) sum += bitmap[(size_t)y * width + x];
+            }
+            if (sum >= SHAPE_COVERAGE_THRESHOLD * (y1 - y0) * (x1 - x0)) {
+                mask |= 1ULL << (my * SHAPE_MASK_SIZE + mx);
+            }
+        }
+    }
+
+    return mask;
+}
+
+// glyphs[i] is drawn by bitmaps[i], a cell_width x cell_height coverage cell
+int shape_glyphs_build(ShapeGlyphs* shapes, const char* glyphs, const uint8_t* const* bitmaps,
+                       int cell_width, int cell_height) {
+    if (!shapes || !glyphs || !bitmaps || cell_width <= 0 || cell_height <= 0) {
+        fprintf(stderr, "Error: Invalid glyph cells for shape matching\n");
+        return 0;
+    }
+
+    memset(shapes, 0, sizeof(*shapes));
+    int n = 0;
+    for (int i = 0; glyphs[i] && n < SHAPE_MAX_GLYPHS; i++) {
+        uint64_t mask = glyph_mask(bitmaps[i], cell_width, cell_height);
+        int seen = 0;
+        for (int j = 0; j < n && !seen; j++) seen = shapes->masks[j] == mask;
+        if (seen) continue;
+
+        // Insertion keeps equal popcounts in glyph order
+        int bits = popcount64(mask);
+        int at = n++;
+        while (at > 0 && popcount64(shapes->masks[at - 1]) > bits) {
+            shapes->masks[at] = shapes->masks[at - 1];
+            shapes->glyphs[at] = shapes->glyphs[at - 1];
+            at--;
+        }
+        shapes->masks[at] = mask;
+        shapes->glyphs[at] = glyphs[i];
+    }
+    shapes->count = n;
+    for (int i = 0; i < n; i++) shapes->bits[i] = (uint8_t)popcount64(shapes->masks[i]);
+
+    int k = 0;
+    for (int bits = 0; bits <= SHAPE_MASK_BITS + 1; bits++) {
+        while (k < n && shapes->bits[k] < bits) k++;
+        shapes->start[bits] = k;
+    }
+
+    if (n == 0) {
+        fprintf(stderr, "Error: No glyphs for shape matching\n");
+        return 0;
+    }
+    return 1;
+}
+
+// Best match so far as distance << SHAPE_INDEX_BITS | glyph index, so the
+// smallest key is the closest glyph and, among equals, the first one
+#define SHAPE_INDEX_BITS 7
+
+// Lowers *best to the smallest key among glyphs first..end-1
+static inline void scan_range(const ShapeGlyphs* shapes, uint64_t mask, int first, int end,
+                              int* best) {
+    int i = first;
+
+#ifdef __SSE2__
+    // Two glyphs per step: bytewise popcount of the xor, summed per 64-bit
+    // lane by psadbw into words 0 and 4. The other words are pinned to the
+    // largest key so one signed 16-bit min keeps the running best.
+    if (i + 2 <= end) {
+        const __m128i m1 = _mm_set1_epi8(0x55);
+        const __m128i m2 = _mm_set1_epi8(0x33);
+        const __m128i m4 = _mm_set1_epi8(0x0F);
+        const __m128i step = _mm_set_epi16(0, 0, 0, 2, 0, 0, 0, 2);
+        __m128i cell = _mm_set1_epi64x((long long)mask);
+        __m128i index = _mm_set_epi16(0x7FFF, 0x7FFF, 0x7FFF, (short)(i + 1),
+                                      0x7FFF, 0x7FFF, 0x7FFF, (short)i);
+        __m128i keys = _mm_set1_epi16(0x7FFF);
+        for (; i + 2 <= end; i += 2) {
+            __m128i x = _mm_xor_si128(cell, _mm_loadu_si128((const __m128i*)&shapes->masks[i]));
+            x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi16(x, 1), m1));
+            x = _mm_add_epi8(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi16(x, 2), m2));
+            x = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi16(x, 4)), m4);
+            x = _mm_sad_epu8(x, _mm_setzero_si128());
+            keys = _mm_min_epi16(keys, _mm_or_si128(_mm_slli_epi16(x, SHAPE_INDEX_BITS), index));
+            index = _mm_add_epi16(index, step);
+        }
+        keys = _mm_min_epi16(keys, _mm_srli_si128(keys, 8));
+        int key = _mm_cvtsi128_si32(keys) & 0xFFFF;
+        if (key < *best) *best = key;
+    }
+#endif
+    for (; i < end; i++) {
+        int key = popcount64(mask ^ shapes->masks[i]) << SHAPE_INDEX_BITS | i;
+        if (key < *best) *best = key;
+    }
+}
+
+// Exact nearest glyph by Hamming distance. A glyph whose popcount differs
+// from the cell's by d is at least d away, so a window over the sorted
+// masks grows outward from the cell's popcount a chunk at a time until
+// every glyph left outside it is bound to be further than the best found.
+char shape_glyphs_match(const ShapeGlyphs* shapes, uint64_t mask) {
+    int bits = popcount64(mask);
+    int n = shapes->count;
+    int lo = shapes->start[bits];
+    int hi = lo;
+    int best = (SHAPE_MASK_BITS + 1) << SHAPE_INDEX_BITS;
+
+    while (lo > 0 || hi < n) {
+        int first = lo > SHAPE_SCAN_CHUNK ? lo - SHAPE_SCAN_CHUNK : 0;
+        int end = hi + SHAPE_SCAN_CHUNK < n ? hi + SHAPE_SCAN_CHUNK : n;
+        scan_range(shapes, mask, first, lo, &best);
+        scan_range(shapes, mask, hi, end, &best);
+        lo = first;
+        hi = end;
+
+        int bound = SHAPE_MASK_BITS + 1;
+        if (lo > 0) bound = bits - shapes->bits[lo - 1];
+        if (hi < n && shapes->bits[hi] - bits < bound) bound = shapes->bits[hi] - bits;
+        if (bound >= best >> SHAPE_INDEX_BITS) break;
+    }
+
+    return n > 0 ? shapes->glyphs[best & ((1 << SHAPE_INDEX_BITS) - 1)] : ' ';
+}
+
+// Fills every entry with the empty mask's glyph
+void shape_memo_init(ShapeMemo* memo, const ShapeGlyphs* shapes) {
+    char blank = shape_glyphs_match(shapes, 0);
+    memset(memo->masks, 0, sizeof(memo->masks));
+    memset(memo->glyphs, blank, sizeof(memo->glyphs));
+}
@@ -0,0 +1,155 @@
+#define _GNU_SOURCE
+#include "span_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+int span_trace_enabled = 0;
+
+static char* trace_path = NULL;
+static uint64_t trace_origin_ns = 0;
+static SpanRing* rings[SPAN_TRACE_MAX_THREADS];
+static int num_rings = 0;
+static __thread SpanRing* local_ring = NULL;
+static __thread int local_ring_failed = 0;
+
+uint64_t span_trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Claims a slot for the calling thread on its first span. Threads beyond
+// SPAN_TRACE_MAX_THREADS are simply not traced.
+static SpanRing* span_trace_ring(void) {
+    if (local_ring || local_ring_failed) return local_ring;
+
+    int slot = __atomic_fetch_add(&num_rings, 1, __ATOMIC_ACQ_REL);
+    if (slot >= SPAN_TRACE_MAX_THREADS) {
+        local_ring_failed = 1;
+        return NULL;
+    }
+
+    SpanRing* ring = calloc(1, sizeof(SpanRing));
+    if (!ring) {
+        local_ring_failed = 1;
+        return NULL;
+    }
+    ring->tid = slot + 1;
+    snprintf(ring->thread_name, sizeof(ring->thread_name), "thread %d", ring->tid);
+    __atomic_store_n(&rings[slot], ring, __ATOMIC_RELEASE);
+    local_ring = ring;
+    return ring;
+}
+
+int span_trace_start(const char* path) {
+    if (!path || span_trace_enabled) return 0;
+
+    // Fail now rather than after the run
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot create trace file %s\n", path);
+        return 0;
+    }
+    fclose(f);
+
+    trace_path = strdup(path);
+    if (!trace_path) return 0;
+
+    trace_origin_ns = span_trace_now_ns();
+    __atomic_store_n(&span_trace_enabled, 1, __ATOMIC_RELEASE);
+    span_trace_name_thread("main");
+    return 1;
+}
+
+void span_trace_name_thread(const char* name) {
+    if (!span_trace_enabled || !name) return;
+    SpanRing* ring = span_trace_ring();
+    if (!ring) return;
+    snprintf(ring->thread_name, sizeof(ring->thread_name), "%s", name);
+}
+
+void span_trace_record(const char* name, uint64_t start_ns) {
+    SpanRing* ring = span_trace_ring();
+    if (!ring) return;
+
+    uint64_t head = ring->head;
+    TraceSpan* span = &ring->spans[head & (SPAN_TRACE_RING_SIZE - 1)];
+    span->name = name;
+    span->start_ns = start_ns;
+    span->end_ns = span_trace_now_ns();
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void write_json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+// Writes every recorded span as Chrome trace-event JSON ("X" complete
+// events in microseconds), loadable in chrome://tracing and Perfetto
+int span_trace_stop(void) {
+    if (!span_trace_enabled) return 0;
+    __atomic_store_n(&span_trace_enabled, 0, __ATOMIC_RELEASE);
+
+    FILE* f = fopen(trace_path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot write trace file %s\n", trace_path);
+        free(trace_path);
+        trace_path = NULL;
+        return 0;
+    }
+
+    int count = __atomic_load_n(&num_rings, __ATOMIC_ACQUIRE);
+    if (count > SPAN_TRACE_MAX_THREADS) count = SPAN_TRACE_MAX_THREADS;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int first = 1;
+    int64_t total = 0;
+    int64_t dropped = 0;
+    for (int r = 0; r < count; r++) {
+        SpanRing* ring = __atomic_load_n(&rings[r], __ATOMIC_ACQUIRE);
+        if (!ring) continue;
+
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                first ? "" : ",\n", ring->tid);
+        write_json_string(f, ring->thread_name);
+        fprintf(f, "}}");
+        first = 0;
+
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint64_t begin = head > SPAN_TRACE_RING_SIZE ? head - SPAN_TRACE_RING_SIZE : 0;
+        dropped += (int64_t)begin;
+        for (uint64_t i = begin; i < head; i++) {
+            const TraceSpan* span = &ring->spans[i & (SPAN_TRACE_RING_SIZE - 1)];
+            if (span->start_ns < trace_origin_ns || span->end_ns < span->start_ns) continue;
+            fprintf(f, ",\n{\"name\":");
+            write_json_string(f, span->name);
+            fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    ring->tid, (span->start_ns - trace_origin_ns) / 1000.0,
+                    (span->end_ns - span->start_ns) / 1000.0);
+            total++;
+        }
+    }
+    fprintf(f, "\n]}\n");
+
+    int ok = fclose(f) == 0;
+    if (ok) {
+        printf("Trace: %ld spans from %d threads written to %s", total, count, trace_path);
+        if (dropped > 0) printf(" (%ld oldest overwritten)", dropped);
+        printf("\n");
+    } else {
+        fprintf(stderr, "Error: Failed to write trace file %s\n", trace_path);
+    }
+
+    // Rings stay allocated: threads that are still running keep pointers
+    // to them, and they are only ever written while tracing is enabled
+    free(trace_path);
+    trace_path = NULL;
+    return ok;
+}
@@ -0,0 +1,50 @@
+#define _GNU_SOURCE
+#include "startup_profile.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char* phase_names[STARTUP_PHASE_COUNT] = {
+    "Decoder open",
+    "SDL init",
+    "TTF init",
+    "Font load",
+    "Window/renderer",
+    "First frame"
+};
+
+double startup_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void startup_profile_begin(StartupProfile* profile) {
+    if (!profile) return;
+    memset(profile, 0, sizeof(StartupProfile));
+    profile->start_ms = startup_now_ms();
+}
+
+void startup_profile_record(StartupProfile* profile, StartupPhase phase, double since_ms) {
+    if (!profile || phase < 0 || phase >= STARTUP_PHASE_COUNT) return;
+    profile->phase_ms[phase] = startup_now_ms() - since_ms;
+}
+
+void startup_profile_finish(StartupProfile* profile) {
+    if (!profile) return;
+    profile->total_ms = startup_now_ms() - profile->start_ms;
+}
+
+void startup_profile_print(const StartupProfile* profile) {
+    if (!profile) return;
+
+    // Decoder open runs concurrently with the SDL phases, so the phases
+    // do not add up to the init total. First frame is measured from launch.
+    printf("\n=== Startup Report ===\n");
+    for (int i = 0; i < STARTUP_PHASE_COUNT; i++) {
+        printf("  %-16s %8.2f ms\n", phase_names[i], profile->phase_ms[i]);
+    }
+    printf("  %-16s %8s\n", "Font cache", profile->font_cache_hit ? "hit" : "miss");
+    printf("  %-16s %8.2f ms\n", "Init total", profile->total_ms);
+    printf("======================\n\n");
+}
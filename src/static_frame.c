@@ -0,0 +1,109 @@
+#include "static_frame.h"
+#include "image_processing.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Returns 0 when the luma plane cannot be allocated
+int frame_signature_compute(FrameSignature* sig, const Image* grid) {
+    size_t pixels = (size_t)grid->width * grid->height;
+    if (pixels > sig->capacity) {
+        uint8_t* luma = realloc(sig->luma, pixels);
+        if (!luma) return 0;
+        sig->luma = luma;
+        sig->capacity = pixels;
+    }
+    sig->width = grid->width;
+    sig->height = grid->height;
+
+    int channels = grid->channels;
+    const uint8_t* p = grid->data;
+    if (channels >= 3) {
+        for (size_t i = 0; i < pixels; i++, p += channels) {
+            sig->luma[i] = rgb_luma(p[0], p[1], p[2]);
+        }
+    } else {
+        for (size_t i = 0; i < pixels; i++, p += channels) sig->luma[i] = p[0];
+    }
+    return 1;
+}
+
+// Matches when no pixel's luma differs by more than noise
+int frame_signature_matches(const FrameSignature* a, const FrameSignature* b, int noise) {
+    if (a->width != b->width || a->height != b->height) return 0;
+
+    size_t count = (size_t)a->width * a->height;
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i limit = _mm_set1_epi8((char)(noise < 0 ? 0 : noise > 255 ? 255 : noise));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a->luma + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b->luma + i));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x));
+        __m128i over = _mm_subs_epu8(diff, limit);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(over, zero)) != 0xFFFF) return 0;
+    }
+#endif
+    for (; i < count; i++) {
+        if (abs((int)a->luma[i] - (int)b->luma[i]) > noise) return 0;
+    }
+    return 1;
+}
+
+void static_frame_init(StaticFrameDetector* detector) {
+    memset(detector, 0, sizeof(StaticFrameDetector));
+}
+
+void static_frame_free(StaticFrameDetector* detector) {
+    if (!detector) return;
+    free(detector->presented.luma);
+    free(detector->current.luma);
+    static_frame_init(detector);
+}
+
+// A disabled detector lets every frame through
+void static_frame_set_enabled(StaticFrameDetector* detector, int enabled) {
+    if (!detector) return;
+    detector->disabled = !enabled;
+    detector->has_presented = 0;
+}
+
+// Returns 1 when grid shows what was last presented, so conversion and
+// drawing can be skipped. Otherwise grid becomes the presented frame.
+int static_frame_check(StaticFrameDetector* detector, const Image* grid) {
+    if (!detector || !grid || !grid->data) return 0;
+
+    detector->frames++;
+    if (detector->disabled) return 0;
+
+    if (!frame_signature_compute(&detector->current, grid)) {
+        detector->has_presented = 0;
+        return 0;
+    }
+    if (detector->has_presented &&
+        frame_signature_matches(&detector->current, &detector->presented, STATIC_FRAME_NOISE)) {
+        detector->skipped++;
+        return 1;
+    }
+
+    // The buffers trade places rather than copying the plane
+    FrameSignature presented = detector->presented;
+    detector->presented = detector->current;
+    detector->current = presented;
+    detector->has_presented = 1;
+    return 0;
+}
+
+// Forces the next frame through, e.g. after a setting changed what the
+// same pixels turn into
+void static_frame_reset(StaticFrameDetector* detector) {
+    if (detector) detector->has_presented = 0;
+}
+
+double static_frame_skip_rate(const StaticFrameDetector* detector) {
+    if (!detector || detector->frames == 0) return 0.0;
+    return (double)detector->skipped / detector->frames;
+}
@@ -0,0 +1,138 @@
+#define _GNU_SOURCE
+#include "term_display.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+static int out_reserve(TermDisplay* td, size_t extra) {
+    if (td->out_len + extra <= td->out_capacity) return 1;
+
+    size_t capacity = td->out_capacity ? td->out_capacity : 4096;
+    while (capacity < td->out_len + extra) capacity *= 2;
+
+    char* out = realloc(td->out, capacity);
+    if (!out) return 0;
+    td->out = out;
+    td->out_capacity = capacity;
+    return 1;
+}
+
+static int out_append(TermDisplay* td, const char* data, size_t len) {
+    if (!out_reserve(td, len)) return 0;
+    memcpy(td->out + td->out_len, data, len);
+    td->out_len += len;
+    return 1;
+}
+
+TermDisplay* term_display_init(int fd) {
+    TermDisplay* td = calloc(1, sizeof(TermDisplay));
+    if (!td) return NULL;
+
+    td->fd = fd;
+
+    // A negative fd only encodes diffs (the asciicast recorder uses this)
+    if (fd < 0) return td;
+
+    // Hide the cursor and clear once; frames then only rewrite changed rows
+    if (write(fd, TERM_DISPLAY_SETUP, sizeof(TERM_DISPLAY_SETUP) - 1) < 0) {
+        fprintf(stderr, "Warning: Cannot write to terminal\n");
+    }
+
+    return td;
+}
+
+void term_display_cleanup(TermDisplay* td) {
+    if (!td) return;
+
+    static const char restore[] = "\x1b[0m\x1b[?25h\n";
+    if (td->fd >= 0 && write(td->fd, restore, sizeof(restore) - 1) < 0) {
+        // Nothing useful left to do with a dead terminal
+    }
+
+    free(td->prev);
+    free(td->out);
+    free(td);
+}
+
+void term_display_invalidate(TermDisplay* td) {
+    if (td) td->has_prev = 0;
+}
+
+// Builds the escape sequence that turns the previously encoded frame into
+// this one: a cursor move plus the new text for every row that differs.
+// The result is left in td->out / td->out_len.
+int term_display_encode_frame(TermDisplay* td, const char* ascii_art) {
+    if (!td || !ascii_art) return 0;
+
+    td->out_len = 0;
+    td->rows_changed = 0;
+
+    const char* cur = ascii_art;
+    const char* prev = td->has_prev ? td->prev : NULL;
+    int row = 0;
+
+    while (*cur) {
+        const char* cur_eol = strchr(cur, '\n');
+        size_t cur_len = cur_eol ? (size_t)(cur_eol - cur) : strlen(cur);
+
+        int changed = 1;
+        if (prev && *prev) {
+            const char* prev_eol = strchr(prev, '\n');
+            size_t prev_len = prev_eol ? (size_t)(prev_eol - prev) : strlen(prev);
+            changed = prev_len != cur_len || memcmp(prev, cur, cur_len) != 0;
+            prev = prev_eol ? prev_eol + 1 : prev + prev_len;
+        }
+
+        if (changed) {
+            char move[32];
+            int n = snprintf(move, sizeof(move), "\x1b[%d;1H", row + 1);
+            if (!out_append(td, move, n) || !out_append(td, cur, cur_len) ||
+                !out_append(td, "\x1b[K", 3)) {
+                return 0;
+            }
+            td->rows_changed++;
+        }
+
+        row++;
+        if (!cur_eol) break;
+        cur = cur_eol + 1;
+    }
+
+    // The previous frame was taller: clear what is left below
+    if (prev && *prev) {
+        char move[32];
+        int n = snprintf(move, sizeof(move), "\x1b[%d;1H\x1b[J", row + 1);
+        if (!out_append(td, move, n)) return 0;
+    }
+
+    // Remember this frame for the next diff
+    size_t size = strlen(ascii_art) + 1;
+    if (size > td->prev_size) {
+        char* copy = realloc(td->prev, size);
+        if (!copy) return 0;
+        td->prev = copy;
+        td->prev_size = size;
+    }
+    memcpy(td->prev, ascii_art, size);
+    td->has_prev = 1;
+
+    return 1;
+}
+
+int term_display_present(TermDisplay* td, const char* ascii_art) {
+    if (!term_display_encode_frame(td, ascii_art)) return 0;
+
+    size_t written = 0;
+    while (written < td->out_len) {
+        ssize_t n = write(td->fd, td->out + written, td->out_len - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        written += n;
+    }
+
+    return 1;
+}
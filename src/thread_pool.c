@@ -0,0 +1,221 @@
+#define _GNU_SOURCE
+#include "thread_pool.h"
+#include "span_trace.h"
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void* thread_pool_worker(void* arg) {
+    ThreadPool* pool = (ThreadPool*)arg;
+    span_trace_name_thread("pool worker");
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->queue_count == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->work_available, &pool->lock);
+        }
+        if (pool->queue_count == 0 && pool->shutdown) break;
+
+        ThreadPoolJob job = pool->queue[pool->queue_head];
+        pool->queue_head = (pool->queue_head + 1) % pool->queue_capacity;
+        pool->queue_count--;
+        pool->active++;
+        pthread_mutex_unlock(&pool->lock);
+
+        job.task(job.arg);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->active--;
+        if (pool->queue_count == 0 && pool->active == 0) {
+            pthread_cond_broadcast(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+// Pins worker i to the (i + 1)-th CPU the process may run on, so banded
+// work does not migrate between cores mid-frame. The first allowed CPU gets
+// no worker, but nothing keeps other threads off it or off the pinned
+// ones: decoders, helpers and audio still compete with the workers. That
+// only pays off on a machine dedicated to playback, so callers pin on
+// request. With more workers than allowed CPUs past the first, pinning
+// would stack workers on one core, so none are pinned. Returns the number
+// of workers pinned; where affinity is not available the workers simply
+// stay unpinned.
+int thread_pool_pin_workers(ThreadPool* pool) {
+    if (!pool) return 0;
+
+    int pinned = 0;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return 0;
+
+    int cpus[CPU_SETSIZE];
+    int count = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) cpus[count++] = cpu;
+    }
+    if (pool->num_threads > count - 1) return 0;
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[i + 1], &set);
+        if (pthread_setaffinity_np(pool->threads[i], sizeof(set), &set) == 0) pinned++;
+    }
+#endif
+    return pinned;
+}
+
+int thread_pool_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+ThreadPool* thread_pool_create(int num_threads, int queue_capacity) {
+    if (num_threads <= 0) num_threads = thread_pool_cpu_count();
+    if (queue_capacity <= 0) queue_capacity = num_threads;
+
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+
+    pool->threads = calloc(num_threads, sizeof(pthread_t));
+    pool->queue = calloc(queue_capacity, sizeof(ThreadPoolJob));
+    if (!pool->threads || !pool->queue) {
+        fprintf(stderr, "Error: Cannot allocate thread pool\n");
+        free(pool->threads);
+        free(pool->queue);
+        free(pool);
+        return NULL;
+    }
+
+    pool->queue_capacity = queue_capacity;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, thread_pool_worker, pool) != 0) {
+            fprintf(stderr, "Error: Cannot start worker thread %d\n", i);
+            break;
+        }
+        pool->num_threads++;
+    }
+
+    if (pool->num_threads == 0) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void thread_pool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_available);
+    pthread_cond_destroy(&pool->work_done);
+    free(pool->threads);
+    free(pool->queue);
+    free(pool);
+}
+
+// Never blocks: returns 0 when the bounded queue is full so the caller can
+// decide what to drop.
+int thread_pool_submit(ThreadPool* pool, ThreadPoolTask task, void* arg) {
+    if (!pool || !task) return 0;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->shutdown || pool->queue_count == pool->queue_capacity) {
+        pthread_mutex_unlock(&pool->lock);
+        return 0;
+    }
+
+    int tail = (pool->queue_head + pool->queue_count) % pool->queue_capacity;
+    pool->queue[tail].task = task;
+    pool->queue[tail].arg = arg;
+    pool->queue_count++;
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    return 1;
+}
+
+void thread_pool_wait_idle(ThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->queue_count > 0 || pool->active > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+typedef struct {
+    ThreadPool* pool;
+    ThreadPoolRangeTask task;
+    void* arg;
+    int count;
+    int next;
+    int runners_done;
+} ParallelFor;
+
+static void parallel_for_drain(ParallelFor* pf) {
+    int index;
+    while ((index = __atomic_fetch_add(&pf->next, 1, __ATOMIC_RELAXED)) < pf->count) {
+        pf->task(pf->arg, index);
+    }
+}
+
+static void parallel_for_runner(void* arg) {
+    ParallelFor* pf = (ParallelFor*)arg;
+    parallel_for_drain(pf);
+
+    // The caller's stack frame owns pf; signal under the pool lock so it
+    // cannot return before this runner is done touching it.
+    pthread_mutex_lock(&pf->pool->lock);
+    pf->runners_done++;
+    pthread_cond_broadcast(&pf->pool->work_done);
+    pthread_mutex_unlock(&pf->pool->lock);
+}
+
+// Runs task(arg, i) for i in [0, count) and returns once all have finished.
+// The calling thread takes indices too, so a busy or full pool only costs
+// parallelism, never correctness.
+void thread_pool_parallel_for(ThreadPool* pool, int count, ThreadPoolRangeTask task, void* arg) {
+    if (!task || count <= 0) return;
+
+    ParallelFor pf = {pool, task, arg, count, 0, 0};
+    int runners = 0;
+
+    if (pool) {
+        int wanted = count - 1 < pool->num_threads ? count - 1 : pool->num_threads;
+        while (runners < wanted && thread_pool_submit(pool, parallel_for_runner, &pf)) {
+            runners++;
+        }
+    }
+
+    parallel_for_drain(&pf);
+
+    if (runners > 0) {
+        pthread_mutex_lock(&pool->lock);
+        while (pf.runners_done < runners) {
+            pthread_cond_wait(&pool->work_done, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
@@ -0,0 +1,294 @@
+#define _GNU_SOURCE
+#include "video_exporter.h"
+#include "video_processor.h"
+#include "image_processing.h"
+#include "image_resize.h"
+#include "ascii_converter.h"
+#include "ascii_raster.h"
+#include "font_loader.h"
+#include <libavutil/opt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double export_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static const AVCodec* find_export_encoder(void) {
+    const AVCodec* codec = avcodec_find_encoder_by_name(EXPORT_ENCODER_PRIMARY);
+    if (codec) return codec;
+
+    fprintf(stderr, "Warning: %s not available, falling back to MPEG-4 Part 2\n",
+            EXPORT_ENCODER_PRIMARY);
+    return avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+}
+
+VideoExporter* video_exporter_init(const char* filename, int width, int height,
+                                   AVRational time_base, AVRational frame_rate) {
+    if (!filename || width <= 0 || height <= 0) return NULL;
+
+    VideoExporter* ex = calloc(1, sizeof(VideoExporter));
+    if (!ex) return NULL;
+
+    // 4:2:0 needs even dimensions
+    ex->width = width & ~1;
+    ex->height = height & ~1;
+    ex->source_time_base = time_base;
+    ex->last_pts = AV_NOPTS_VALUE;
+
+    if (avformat_alloc_output_context2(&ex->format_ctx, NULL, NULL, filename) < 0 || !ex->format_ctx) {
+        fprintf(stderr, "Error: Cannot determine output format for %s\n", filename);
+        free(ex);
+        return NULL;
+    }
+
+    const AVCodec* codec = find_export_encoder();
+    if (!codec) {
+        fprintf(stderr, "Error: No usable video encoder\n");
+        video_exporter_cleanup(ex);
+        return NULL;
+    }
+
+    ex->stream = avformat_new_stream(ex->format_ctx, NULL);
+    ex->codec_ctx = avcodec_alloc_context3(codec);
+    if (!ex->stream || !ex->codec_ctx) {
+        fprintf(stderr, "Error: Cannot allocate encoder\n");
+        video_exporter_cleanup(ex);
+        return NULL;
+    }
+
+    // Encode in the source time base so timestamps pass through untouched;
+    // MPEG-4 Part 2 caps the denominator, so it gets the frame rate instead
+    AVRational encoder_time_base = time_base;
+    if (codec->id == AV_CODEC_ID_MPEG4 && time_base.den > 65535) {
+        encoder_time_base = av_inv_q(frame_rate);
+    }
+
+    ex->codec_ctx->width = ex->width;
+    ex->codec_ctx->height = ex->height;
+    ex->codec_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ex->codec_ctx->color_range = AVCOL_RANGE_JPEG;
+    ex->codec_ctx->time_base = encoder_time_base;
+    ex->codec_ctx->framerate = frame_rate;
+    ex->codec_ctx->gop_size = frame_rate.den > 0 ? 2 * frame_rate.num / frame_rate.den : 60;
+    ex->codec_ctx->thread_count = 0;
+    if (codec->id == AV_CODEC_ID_MPEG4) {
+        ex->codec_ctx->bit_rate = (int64_t)ex->width * ex->height * 4;
+    } else {
+        av_opt_set(ex->codec_ctx->priv_data, "preset", "veryfast", 0);
+        av_opt_set(ex->codec_ctx->priv_data, "crf", EXPORT_CRF, 0);
+    }
+    if (ex->format_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
+        ex->codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    if (avcodec_open2(ex->codec_ctx, codec, NULL) < 0) {
+        fprintf(stderr, "Error: Cannot open %s encoder\n", codec->name);
+        video_exporter_cleanup(ex);
+        return NULL;
+    }
+
+    ex->frame_duration = av_rescale_q(1, av_inv_q(frame_rate), encoder_time_base);
+    if (ex->frame_duration < 1) ex->frame_duration = 1;
+
+    ex->stream->time_base = encoder_time_base;
+    ex->stream->avg_frame_rate = frame_rate;
+    if (avcodec_parameters_from_context(ex->stream->codecpar, ex->codec_ctx) < 0) {
+        fprintf(stderr, "Error: Cannot copy encoder parameters\n");
+        video_exporter_cleanup(ex);
+        return NULL;
+    }
+
+    ex->frame = av_frame_alloc();
+    ex->packet = av_packet_alloc();
+    if (!ex->frame || !ex->packet) {
+        fprintf(stderr, "Error: Cannot allocate frames/packet\n");
+        video_exporter_cleanup(ex);
+        return NULL;
+    }
+
+    ex->frame->format = AV_PIX_FMT_YUV420P;
+    ex->frame->width = ex->width;
+    ex->frame->height = ex->height;
+    if (av_frame_get_buffer(ex->frame, 0) < 0) {
+        fprintf(stderr, "Error: Cannot allocate export frame\n");
+        video_exporter_cleanup(ex);
+        return NULL;
+    }
+
+    // Gray content: neutral chroma once, luma rewritten every frame
+    for (int plane = 1; plane < 3; plane++) {
+        for (int y = 0; y < ex->height / 2; y++) {
+            memset(ex->frame->data[plane] + (size_t)y * ex->frame->linesize[plane], 128, ex->width / 2);
+        }
+    }
+
+    if (!(ex->format_ctx->oformat->flags & AVFMT_NOFILE) &&
+        avio_open(&ex->format_ctx->pb, filename, AVIO_FLAG_WRITE) < 0) {
+        fprintf(stderr, "Error: Cannot open %s for writing\n", filename);
+        video_exporter_cleanup(ex);
+        return NULL;
+    }
+
+    if (avformat_write_header(ex->format_ctx, NULL) < 0) {
+        fprintf(stderr, "Error: Cannot write header to %s\n", filename);
+        video_exporter_cleanup(ex);
+        return NULL;
+    }
+
+    return ex;
+}
+
+void video_exporter_cleanup(VideoExporter* ex) {
+    if (!ex) return;
+
+    if (ex->frame) av_frame_free(&ex->frame);
+    if (ex->packet) av_packet_free(&ex->packet);
+    if (ex->codec_ctx) avcodec_free_context(&ex->codec_ctx);
+    if (ex->format_ctx) {
+        if (ex->format_ctx->pb && !(ex->format_ctx->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&ex->format_ctx->pb);
+        }
+        avformat_free_context(ex->format_ctx);
+    }
+    free(ex);
+}
+
+// The encoder may still reference the previous frame's buffers
+uint8_t* video_exporter_luma(VideoExporter* ex, int* stride) {
+    if (!ex || av_frame_make_writable(ex->frame) < 0) return NULL;
+    if (stride) *stride = ex->frame->linesize[0];
+    return ex->frame->data[0];
+}
+
+static int drain_packets(VideoExporter* ex) {
+    int ret;
+    while ((ret = avcodec_receive_packet(ex->codec_ctx, ex->packet)) == 0) {
+        av_packet_rescale_ts(ex->packet, ex->codec_ctx->time_base, ex->stream->time_base);
+        ex->packet->stream_index = ex->stream->index;
+        if (av_interleaved_write_frame(ex->format_ctx, ex->packet) < 0) {
+            fprintf(stderr, "Error: Cannot write packet\n");
+            return 0;
+        }
+    }
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+}
+
+// pts is in the source time base; missing or non-increasing stamps are
+// continued at the nominal frame rate so the encoder never rejects a frame
+int video_exporter_write_frame(VideoExporter* ex, int64_t pts) {
+    if (!ex) return 0;
+
+    if (pts != AV_NOPTS_VALUE) {
+        pts = av_rescale_q(pts, ex->source_time_base, ex->codec_ctx->time_base);
+    }
+    if (pts == AV_NOPTS_VALUE || (ex->last_pts != AV_NOPTS_VALUE && pts <= ex->last_pts)) {
+        pts = ex->last_pts == AV_NOPTS_VALUE ? 0 : ex->last_pts + ex->frame_duration;
+    }
+    ex->last_pts = pts;
+    ex->frame->pts = pts;
+
+    if (avcodec_send_frame(ex->codec_ctx, ex->frame) < 0) {
+        fprintf(stderr, "Error: Encoder rejected frame %ld\n", ex->frames_written);
+        return 0;
+    }
+    ex->frames_written++;
+    return drain_packets(ex);
+}
+
+int video_exporter_finish(VideoExporter* ex) {
+    if (!ex) return 0;
+
+    avcodec_send_frame(ex->codec_ctx, NULL);
+    int ok = drain_packets(ex);
+    return av_write_trailer(ex->format_ctx) == 0 && ok;
+}
+
+int video_exporter_export(const char* video_file, const char* output_file, int cols, int rows,
+                          int num_threads, int pin_threads) {
+    VideoProcessor* vp = video_processor_init(video_file);
+    if (!vp) {
+        fprintf(stderr, "Error: Failed to initialize video processor\n");
+        return 1;
+    }
+
+    AsciiConfig config = create_default_config();
+    int grid_w, grid_h, max_grid_w, max_grid_h;
+    ascii_grid_limits(&config, cols, rows, &max_grid_w, &max_grid_h);
+    fit_aspect_ratio(vp->width, vp->height, max_grid_w, max_grid_h, &grid_w, &grid_h);
+
+    // The calling thread rasterizes a share of the bands itself
+    if (num_threads <= 0) num_threads = thread_pool_cpu_count();
+    ThreadPool* pool = num_threads > 1 ? thread_pool_create(num_threads - 1, num_threads) : NULL;
+    if (pin_threads) thread_pool_pin_workers(pool);
+    config.pool = pool;
+
+    GlyphCache* glyphs = glyph_cache_create(DEFAULT_FONT_SIZE);
+    AsciiRaster* raster = ascii_raster_create(glyphs, pool);
+    Image* frame = create_image(vp->width, vp->height, 3);
+    Image* grid = create_image(grid_w, grid_h, 3);
+    ResizePlan* plan = resize_plan_create(vp->width, vp->height, grid_w, grid_h, 3,
+                                          RESIZE_DEFAULT_FILTER);
+    if (!plan) fprintf(stderr, "Error: Cannot allocate resize plan\n");
+    size_t ascii_size = ascii_buffer_size(grid_w, grid_h, &config);
+    char* ascii = malloc(ascii_size);
+
+    VideoExporter* ex = NULL;
+    if (raster && frame && grid && plan && ascii) {
+        int out_w = ascii_output_width(grid_w, &config) * glyphs->cell_width;
+        int out_h = ascii_output_height(grid_h, &config) * glyphs->cell_height;
+        ex = video_exporter_init(output_file, out_w, out_h, vp->time_base, vp->frame_rate);
+    }
+
+    int result = 1;
+    if (ex) {
+        printf("Exporting %s to %s (%dx%d, %d threads)\n", video_file, output_file,
+               ex->width, ex->height, num_threads);
+
+        double start = export_now_ms();
+        result = 0;
+
+        while (video_processor_read_frame(vp, frame)) {
+            int stride;
+            uint8_t* luma = video_exporter_luma(ex, &stride);
+
+            resize_plan_run(plan, frame, grid, pool);
+            if (!luma || !image_to_ascii_into(grid, &config, ascii, ascii_size)) {
+                fprintf(stderr, "Error: Cannot convert frame %ld to ASCII\n", vp->current_frame);
+                result = 1;
+                break;
+            }
+            if (!ascii_raster_render(raster, ascii, luma, ex->width, ex->height, stride) ||
+                !video_exporter_write_frame(ex, vp->frame_pts)) {
+                fprintf(stderr, "Error: Export failed at frame %ld\n", vp->current_frame);
+                result = 1;
+                break;
+            }
+        }
+
+        if (!video_exporter_finish(ex)) result = 1;
+
+        double elapsed = (export_now_ms() - start) / 1000.0;
+        double media = vp->fps > 0.0 ? ex->frames_written / vp->fps : 0.0;
+        printf("Exported %ld frames in %.2f s (%.1f FPS, %.2fx real time)\n",
+               ex->frames_written, elapsed, elapsed > 0.0 ? ex->frames_written / elapsed : 0.0,
+               elapsed > 0.0 ? media / elapsed : 0.0);
+    } else {
+        fprintf(stderr, "Error: Failed to set up export\n");
+    }
+
+    video_exporter_cleanup(ex);
+    free(ascii);
+    resize_plan_destroy(plan);
+    free_image(grid);
+    free_image(frame);
+    ascii_raster_destroy(raster);
+    glyph_cache_destroy(glyphs);
+    thread_pool_destroy(pool);
+    video_processor_cleanup(vp);
+    return result;
+}
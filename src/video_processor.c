@@ -1,4 +1,5 @@
 #include "video_processor.h"
+#include "span_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +35,12 @@ VideoProcessor* video_processor_init(const char* filename) {
         return NULL;
     }
 
+    // Audio and every other stream are skipped in the demuxer; the audio
+    // player reads the same file through its own
+    for (unsigned int i = 0; i < vp->format_ctx->nb_streams; i++) {
+        if ((int)i != vp->video_stream_index) vp->format_ctx->streams[i]->discard = AVDISCARD_ALL;
+    }
+
     AVCodecParameters* codecpar = vp->format_ctx->streams[vp->video_stream_index]->codecpar;
 
     vp->codec = avcodec_find_decoder(codecpar->codec_id);
@@ -79,6 +86,8 @@ VideoProcessor* video_processor_init(const char* filename) {
     
     vp->width = vp->codec_ctx->width;
     vp->height = vp->codec_ctx->height;
+    vp->source_width = vp->width;
+    vp->source_height = vp->height;
     
     AVRational time_base = vp->format_ctx->streams[vp->video_stream_index]->time_base;
     AVRational frame_rate = vp->format_ctx->streams[vp->video_stream_index]->r_frame_rate;
@@ -87,7 +96,11 @@ VideoProcessor* video_processor_init(const char* filename) {
         vp->fps = (double)frame_rate.num / frame_rate.den;
     } else {
         vp->fps = 1.0 / av_q2d(time_base);
+        frame_rate = av_inv_q(time_base);
     }
+    vp->time_base = time_base;
+    vp->frame_rate = frame_rate;
+    vp->frame_pts = AV_NOPTS_VALUE;
     
     int64_t duration = vp->format_ctx->duration;
     if (duration != AV_NOPTS_VALUE) {
@@ -159,14 +172,78 @@ void video_processor_cleanup(VideoProcessor* vp) {
     free(vp);
 }
 
-Image* video_processor_get_next_frame(VideoProcessor* vp) {
-    if (!vp || !video_processor_is_valid(vp)) {
-        return NULL;
+static int traced_read_packet(VideoProcessor* vp) {
+    uint64_t span = span_begin();
+    int ret = av_read_frame(vp->format_ctx, vp->packet);
+    span_end("av_read_frame", span);
+    return ret;
+}
+
+static int traced_receive_frame(VideoProcessor* vp) {
+    uint64_t span = span_begin();
+    int ret = avcodec_receive_frame(vp->codec_ctx, vp->frame);
+    span_end("avcodec_receive_frame", span);
+    return ret;
+}
+
+// Bookkeeping for a frame that just came out of the decoder. The frame
+// number follows the timestamp when there is one, so it stays right after
+// a seek.
+static void video_processor_frame_decoded(VideoProcessor* vp) {
+    vp->frame_pts = vp->frame->best_effort_timestamp;
+    if (vp->frame_pts != AV_NOPTS_VALUE && vp->fps > 0.0) {
+        vp->current_frame = (int64_t)(video_processor_frame_time(vp) * vp->fps + 0.5) + 1;
+    } else {
+        vp->current_frame++;
+    }
+}
+
+// Converts the most recently decoded frame (read or skipped) to RGB
+int video_processor_convert_frame(VideoProcessor* vp, Image* dst) {
+    if (!vp || !video_processor_is_valid(vp) || !dst || !dst->data) return 0;
+    if (dst->width != vp->width || dst->height != vp->height || dst->channels != 3) {
+        fprintf(stderr, "Error: Frame buffer does not match video dimensions\n");
+        return 0;
+    }
+
+    // A region of interest is handed to swscale as plane pointers offset
+    // into the decoded frame, so only its pixels are ever converted
+    const uint8_t* src_data[4];
+    for (int p = 0; p < 4; p++) {
+        src_data[p] = vp->frame->data[p];
+        if (src_data[p] && (vp->roi_x || vp->roi_y)) {
+            const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(vp->codec_ctx->pix_fmt);
+            int chroma = (p == 1 || p == 2) && desc;
+            int x = chroma ? vp->roi_x >> desc->log2_chroma_w : vp->roi_x;
+            int y = chroma ? vp->roi_y >> desc->log2_chroma_h : vp->roi_y;
+            src_data[p] += (ptrdiff_t)y * vp->frame->linesize[p] + x * vp->roi_pixstep[p];
+        }
+    }
+
+    // Convert straight into the caller's buffer
+    uint64_t span = span_begin();
+    uint8_t* dst_data[4] = {dst->data, NULL, NULL, NULL};
+    int dst_linesize[4] = {dst->width * 3, 0, 0, 0};
+    sws_scale(vp->sws_ctx, src_data, vp->frame->linesize,
+             0, vp->height,
+             dst_data, dst_linesize);
+    span_end("sws_scale", span);
+    return 1;
+}
+
+int video_processor_read_frame(VideoProcessor* vp, Image* dst) {
+    if (!vp || !video_processor_is_valid(vp) || !dst || !dst->data) {
+        return 0;
+    }
+
+    if (dst->width != vp->width || dst->height != vp->height || dst->channels != 3) {
+        fprintf(stderr, "Error: Frame buffer does not match video dimensions\n");
+        return 0;
     }
 
     int ret;
 
-    while ((ret = av_read_frame(vp->format_ctx, vp->packet)) >= 0) {
+    while ((ret = traced_read_packet(vp)) >= 0) {
         if (vp->packet->stream_index == vp->video_stream_index) {
             ret = avcodec_send_packet(vp->codec_ctx, vp->packet);
             if (ret < 0) {
@@ -174,28 +251,57 @@ Image* video_processor_get_next_frame(VideoProcessor* vp) {
                 continue;
             }
 
-            ret = avcodec_receive_frame(vp->codec_ctx, vp->frame);
+            ret = traced_receive_frame(vp);
             if (ret == 0) {
                 av_packet_unref(vp->packet);
+                video_processor_frame_decoded(vp);
+                return video_processor_convert_frame(vp, dst);
+            }
+        }
+        av_packet_unref(vp->packet);
+    }
+
+    return 0;
+}
 
-                sws_scale(vp->sws_ctx,
-                         (const uint8_t* const*)vp->frame->data, vp->frame->linesize,
-                         0, vp->height,
-                         vp->rgb_frame->data, vp->rgb_frame->linesize);
+// Decodes the next frame without converting it to RGB
+int video_processor_skip_frame(VideoProcessor* vp) {
+    if (!vp || !video_processor_is_valid(vp)) {
+        return 0;
+    }
 
-                Image* img = create_image(vp->width, vp->height, 3);
-                if (img) {
-                    memcpy(img->data, vp->rgb_buffer, vp->rgb_buffer_size);
-                    vp->current_frame++;
-                }
+    while (traced_read_packet(vp) >= 0) {
+        if (vp->packet->stream_index == vp->video_stream_index) {
+            int ret = avcodec_send_packet(vp->codec_ctx, vp->packet);
+            av_packet_unref(vp->packet);
+            if (ret < 0) continue;
 
-                return img;
+            if (traced_receive_frame(vp) == 0) {
+                video_processor_frame_decoded(vp);
+                return 1;
             }
+            continue;
         }
         av_packet_unref(vp->packet);
     }
 
-    return NULL;
+    return 0;
+}
+
+Image* video_processor_get_next_frame(VideoProcessor* vp) {
+    if (!vp || !video_processor_is_valid(vp)) {
+        return NULL;
+    }
+
+    Image* img = create_image(vp->width, vp->height, 3);
+    if (!img) return NULL;
+
+    if (!video_processor_read_frame(vp, img)) {
+        free_image(img);
+        return NULL;
+    }
+
+    return img;
 }
 
 void video_processor_reset(VideoProcessor* vp) {
@@ -206,6 +312,94 @@ void video_processor_reset(VideoProcessor* vp) {
     av_seek_frame(vp->format_ctx, vp->video_stream_index, 0, AVSEEK_FLAG_BACKWARD);
     avcodec_flush_buffers(vp->codec_ctx);
     vp->current_frame = 0;
+    vp->frame_pts = AV_NOPTS_VALUE;
+}
+
+// Seeks to the last keyframe at or before the given time; the next frame
+// read is that keyframe
+int video_processor_seek_time(VideoProcessor* vp, double seconds) {
+    if (!vp || !video_processor_is_valid(vp)) return 0;
+
+    int64_t start = vp->format_ctx->streams[vp->video_stream_index]->start_time;
+    if (start == AV_NOPTS_VALUE) start = 0;
+    if (seconds < 0.0) seconds = 0.0;
+
+    int64_t ts = start + (int64_t)(seconds / av_q2d(vp->time_base));
+    if (av_seek_frame(vp->format_ctx, vp->video_stream_index, ts, AVSEEK_FLAG_BACKWARD) < 0) {
+        return 0;
+    }
+
+    avcodec_flush_buffers(vp->codec_ctx);
+    vp->frame_pts = AV_NOPTS_VALUE;
+    vp->current_frame = (int64_t)(seconds * vp->fps);
+    return 1;
+}
+
+// Lets the decoder drop frames before decoding them: AVDISCARD_NONREF skips
+// frames nothing else references, AVDISCARD_NONKEY everything but keyframes
+void video_processor_set_discard(VideoProcessor* vp, enum AVDiscard discard) {
+    if (!vp || !video_processor_is_valid(vp)) return;
+    vp->codec_ctx->skip_frame = discard;
+}
+
+// Restricts conversion to a sub-rectangle of the decoded frame; output
+// images take its size. The origin is snapped to the chroma grid and the
+// rectangle clamped to the frame. A width or height of 0 selects the whole
+// frame again.
+int video_processor_set_roi(VideoProcessor* vp, int x, int y, int width, int height) {
+    if (!vp || !video_processor_is_valid(vp)) return 0;
+
+    int full = width <= 0 || height <= 0;
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(vp->codec_ctx->pix_fmt);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM |
+                                 AV_PIX_FMT_FLAG_HWACCEL))) {
+        if (!full) {
+            fprintf(stderr, "Error: Cropping is not supported for this pixel format\n");
+            return 0;
+        }
+        desc = NULL;
+    }
+
+    if (full) {
+        x = 0;
+        y = 0;
+        width = vp->source_width;
+        height = vp->source_height;
+    }
+
+    int align_x = desc ? 1 << desc->log2_chroma_w : 1;
+    int align_y = desc ? 1 << desc->log2_chroma_h : 1;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    x &= ~(align_x - 1);
+    y &= ~(align_y - 1);
+    if (x > vp->source_width - align_x) x = (vp->source_width - align_x) & ~(align_x - 1);
+    if (y > vp->source_height - align_y) y = (vp->source_height - align_y) & ~(align_y - 1);
+    if (width > vp->source_width - x) width = vp->source_width - x;
+    if (height > vp->source_height - y) height = vp->source_height - y;
+    if (width < align_x) width = align_x;
+    if (height < align_y) height = align_y;
+
+    if (x == vp->roi_x && y == vp->roi_y && width == vp->width && height == vp->height) {
+        return 1;
+    }
+
+    struct SwsContext* sws = sws_getContext(width, height, vp->codec_ctx->pix_fmt,
+                                            width, height, AV_PIX_FMT_RGB24,
+                                            SWS_BILINEAR, NULL, NULL, NULL);
+    if (!sws) {
+        fprintf(stderr, "Error: Cannot initialize scaling context\n");
+        return 0;
+    }
+    sws_freeContext(vp->sws_ctx);
+    vp->sws_ctx = sws;
+
+    if (desc) av_image_fill_max_pixsteps(vp->roi_pixstep, NULL, desc);
+    vp->roi_x = x;
+    vp->roi_y = y;
+    vp->width = width;
+    vp->height = height;
+    return 1;
 }
 
 double video_processor_get_duration(VideoProcessor* vp) {
@@ -245,6 +439,20 @@ int64_t video_processor_get_current_frame(VideoProcessor* vp) {
     return vp->current_frame;
 }
 
+// Presentation time of the last decoded frame in seconds from the stream
+// start; falls back to the frame count when the stream has no timestamps
+double video_processor_frame_time(VideoProcessor* vp) {
+    if (!vp || !video_processor_is_valid(vp)) return -1.0;
+
+    if (vp->frame_pts == AV_NOPTS_VALUE) {
+        return vp->fps > 0.0 && vp->current_frame > 0 ? (vp->current_frame - 1) / vp->fps : 0.0;
+    }
+
+    int64_t start = vp->format_ctx->streams[vp->video_stream_index]->start_time;
+    if (start == AV_NOPTS_VALUE) start = 0;
+    return (vp->frame_pts - start) * av_q2d(vp->time_base);
+}
+
 int video_processor_is_valid(VideoProcessor* vp) {
     return vp && vp->format_ctx && vp->codec_ctx && vp->frame && vp->rgb_frame && vp->packet;
 }
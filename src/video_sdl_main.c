@@ -1,4 +1,11 @@
 #include "video_sdl_player.h"
+#include "mosaic_player.h"
+#include "ascii_server.h"
+#include "video_exporter.h"
+#include "asciicast_recorder.h"
+#include "frame_trace.h"
+#include "span_trace.h"
+#include "alloc_stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,24 +13,71 @@
 void print_usage(const char* program_name) {
     printf("SDL2 Video to ASCII Player\n");
     printf("==========================\n\n");
-    printf("Usage: %s <video_file> [options]\n\n", program_name);
+    printf("Usage: %s <video_file> [options]\n", program_name);
+    printf("       %s --mosaic <video_file>... [options]\n", program_name);
+    printf("       %s <video_file> --serve <address> [--grid <cols>x<rows>]\n", program_name);
+    printf("       %s <video_file> --export <out.mp4|out.cast> [--grid <cols>x<rows>]\n", program_name);
+    printf("       %s <video_file> --capture-trace <file> [--grid <cols>x<rows>]\n", program_name);
+    printf("       %s --replay-trace <file> [--iterations <n>] [--threads <n>] [--assert-steady-state]\n\n", program_name);
     printf("Options:\n");
-    printf("  -w <width>   Window width (default: 500)\n");
-    printf("  -h <height>  Window height (default: 500)\n");
+    printf("  -w <width>   Window width (default: 1100)\n");
+    printf("  -h <height>  Window height (default: 1100)\n");
+    printf("  --mosaic     Play every input as a tile of one shared ASCII grid\n");
+    printf("  --threads <n>  Worker threads for mosaic and export (default: CPU count)\n");
+    printf("  --pin-threads  Pin pool workers to their own cores (player, export, replay);\n");
+    printf("               only pays off on a machine dedicated to playback\n");
+    printf("  --serve <address>  Convert once and stream to video_ascii_client\n");
+    printf("               (unix:<path> or tcp:<port>, no window)\n");
+    printf("  --export <file>  Render the ASCII output into a video file, no window\n");
+    printf("               (a .cast file gets an asciicast v2 recording instead)\n");
+    printf("  --record <file>  Record playback as an asciicast v2 file\n");
+    printf("  --capture-trace <file>  Write decoded, grid-scaled frames to a raw trace\n");
+    printf("  --replay-trace <file>  Benchmark conversion and rendering from a trace\n");
+    printf("  --iterations <n>  Passes over the trace when replaying (default: 5)\n");
+    printf("  --grid <cols>x<rows>  Streamed/exported grid size (default: 160x50)\n");
+    printf("  --roi <x,y,w,h>  Crop the source to a region before scaling\n");
+    printf("  --auto-exposure <mode>  Stretch contrast per frame: off, levels or equalize\n");
+    printf("  --dither <0-1>  Ordered-dither strength for charset mode (default: 0)\n");
+    printf("  --hysteresis <n>  Hold each cell's glyph until its luma moves n levels past\n");
+    printf("               the glyph boundary (charset mode)\n");
+    printf("  --fixed-grid  Keep the full window grid instead of shrinking it to hold\n");
+    printf("               the frame rate\n");
+    printf("  --no-static-skip  Convert and draw every frame, even when nothing changed\n");
+    printf("  --raster  Draw text on the CPU from cached glyphs (the default without a GPU)\n");
+    printf("  --trace <file.json>  Write pipeline spans as Chrome trace-event JSON\n");
+    printf("  --startup-report  Print per-phase startup timing after the first frame\n");
+    printf("  --alloc-stats  Count heap allocations per subsystem; report at exit\n");
+    printf("               (needs a build with make ALLOC_STATS=1)\n");
+    printf("  --assert-steady-state  Fail a replay that allocates after its warm-up pass\n");
     printf("  --help       Show this help message\n\n");
     printf("Controls:\n");
     printf("  SPACE:       Play/Pause\n");
     printf("  S:           Stop\n");
     printf("  LEFT/RIGHT:  Seek backward/forward\n");
+    printf("  , / .:       Step one frame backward/forward\n");
+    printf("  B:           Toggle reverse playback\n");
+    printf("  +/-:         Zoom in/out\n");
+    printf("  Keypad 2468: Pan the zoomed region\n");
+    printf("  0:           Show the full frame\n");
     printf("  UP/DOWN:     Speed control\n");
     printf("  1-6:         ASCII character sets\n");
+    printf("  M:           Cycle cell mode\n");
+    printf("  F:           Cycle resize filter\n");
     printf("  I:           Invert brightness\n");
+    printf("  E:           Cycle auto-exposure\n");
+    printf("  [ / ]:       Decrease/increase dither strength\n");
+    printf("  G:           Toggle glyph hysteresis\n");
+    printf("  A:           Toggle adaptive grid size\n");
     printf("  R:           Reset settings\n");
     printf("  Q/ESC:       Quit\n\n");
     printf("Character sets:\n");
     print_available_charsets();
 }
 
+static void write_span_trace(void) {
+    span_trace_stop();
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         print_usage(argv[0]);
@@ -35,26 +89,192 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    const char* video_file = argv[1];
-    int window_width = 500;
-    int window_height = 500;
+    const char* video_files[argc];
+    int num_files = 0;
+    int window_width = 1100;
+    int window_height = 1100;
+    int startup_report = 0;
+    int mosaic = 0;
+    int num_threads = 0;
+    int pin_threads = 0;
+    const char* serve_address = NULL;
+    const char* export_file = NULL;
+    const char* record_file = NULL;
+    const char* capture_file = NULL;
+    const char* replay_file = NULL;
+    const char* span_file = NULL;
+    int roi[4] = {0, 0, 0, 0};
+    int alloc_stats = 0;
+    int steady_state = 0;
+    AutoExposureMode exposure = AUTO_EXPOSURE_OFF;
+    double dither = 0.0;
+    int hysteresis = -1;
+    int fixed_grid = 0;
+    int static_skip = 1;
+    int raster = 0;
+    int iterations = 0;
+    int grid_cols = 160;
+    int grid_rows = 50;
 
-    for (int i = 2; i < argc; i++) {
+    for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
             window_width = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
             window_height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--startup-report") == 0) {
+            startup_report = 1;
+        } else if (strcmp(argv[i], "--mosaic") == 0) {
+            mosaic = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pin-threads") == 0) {
+            pin_threads = 1;
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serve_address = argv[++i];
+        } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            export_file = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_file = argv[++i];
+        } else if (strcmp(argv[i], "--capture-trace") == 0 && i + 1 < argc) {
+            capture_file = argv[++i];
+        } else if (strcmp(argv[i], "--replay-trace") == 0 && i + 1 < argc) {
+            replay_file = argv[++i];
+        } else if (strcmp(argv[i], "--roi") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d,%d,%d,%d", &roi[0], &roi[1], &roi[2], &roi[3]) != 4 ||
+                roi[0] < 0 || roi[1] < 0 || roi[2] <= 0 || roi[3] <= 0) {
+                fprintf(stderr, "Error: Invalid region of interest %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--auto-exposure") == 0 && i + 1 < argc) {
+            if (!auto_exposure_parse_mode(argv[++i], &exposure)) {
+                fprintf(stderr, "Error: Unknown auto-exposure mode %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--alloc-stats") == 0) {
+            alloc_stats = 1;
+        } else if (strcmp(argv[i], "--assert-steady-state") == 0) {
+            alloc_stats = 1;
+            steady_state = 1;
+        } else if (strcmp(argv[i], "--dither") == 0 && i + 1 < argc) {
+            dither = atof(argv[++i]);
+            if (dither < 0.0 || dither > 1.0) {
+                fprintf(stderr, "Error: Dither strength must be between 0 and 1\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--hysteresis") == 0 && i + 1 < argc) {
+            hysteresis = atoi(argv[++i]);
+            if (hysteresis < 0 || hysteresis > 255) {
+                fprintf(stderr, "Error: Hysteresis margin must be between 0 and 255\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--fixed-grid") == 0) {
+            fixed_grid = 1;
+        } else if (strcmp(argv[i], "--no-static-skip") == 0) {
+            static_skip = 0;
+        } else if (strcmp(argv[i], "--raster") == 0) {
+            raster = 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            span_file = argv[++i];
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &grid_cols, &grid_rows) != 2 ||
+                grid_cols <= 0 || grid_rows <= 0) {
+                fprintf(stderr, "Error: Invalid grid size %s\n", argv[i]);
+                return 1;
+            }
         } else if (strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
+        } else if (argv[i][0] != '-') {
+            video_files[num_files++] = argv[i];
+        } else {
+            fprintf(stderr, "Warning: Ignoring unknown option %s\n", argv[i]);
         }
     }
 
+    // Only the single-video player applies the picture settings; the other
+    // modes convert with plain ones, so refuse rather than drop them quietly
+    int player_mode = !replay_file && !capture_file && !export_file && !serve_address && !mosaic;
+    if (!player_mode && roi[2] > 0) {
+        fprintf(stderr, "Error: --roi only applies to windowed playback of one video\n");
+        return 1;
+    }
+    if (!player_mode && exposure != AUTO_EXPOSURE_OFF) {
+        fprintf(stderr, "Error: --auto-exposure only applies to windowed playback of one video\n");
+        return 1;
+    }
+    if (!player_mode && dither > 0.0) {
+        fprintf(stderr, "Error: --dither only applies to windowed playback of one video\n");
+        return 1;
+    }
+    if (!player_mode && hysteresis >= 0) {
+        fprintf(stderr, "Error: --hysteresis only applies to windowed playback of one video\n");
+        return 1;
+    }
+
+    // Spans are written out on exit, whichever mode ran
+    if (span_file) {
+        if (!span_trace_start(span_file)) return 1;
+        atexit(write_span_trace);
+    }
+
+    if (alloc_stats) {
+        if (!alloc_stats_enable()) return 1;
+        atexit(alloc_stats_report);
+    }
+
+    // Replay needs no video, only the trace
+    if (replay_file) {
+        return frame_trace_replay(replay_file, iterations, num_threads, steady_state, pin_threads);
+    }
+
+    if (num_files == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
     if (window_width <= 0 || window_height <= 0) {
         fprintf(stderr, "Error: Invalid window dimensions\n");
         return 1;
     }
 
+    if (capture_file) {
+        return frame_trace_capture(video_files[0], capture_file, grid_cols, grid_rows);
+    }
+
+    if (export_file) {
+        size_t len = strlen(export_file);
+        if (len > 5 && strcmp(export_file + len - 5, ".cast") == 0) {
+            return asciicast_recorder_convert(video_files[0], export_file, grid_cols, grid_rows);
+        }
+        return video_exporter_export(video_files[0], export_file, grid_cols, grid_rows, num_threads,
+                                     pin_threads);
+    }
+
+    if (serve_address) {
+        return ascii_server_stream_video(video_files[0], serve_address, grid_cols, grid_rows,
+                                         static_skip);
+    }
+
+    if (mosaic) {
+        printf("SDL2 Video to ASCII Player (mosaic)\n");
+        printf("Videos: %d | Size: %dx%d\n", num_files, window_width, window_height);
+
+        MosaicPlayer* mp = mosaic_player_init(video_files, num_files, window_width,
+                                              window_height, num_threads);
+        if (!mp) {
+            fprintf(stderr, "Error: Failed to initialize mosaic player\n");
+            return 1;
+        }
+
+        int result = mosaic_player_run(mp);
+        mosaic_player_cleanup(mp);
+        return result;
+    }
+
+    const char* video_file = video_files[0];
+
     printf("SDL2 Video to ASCII Player\n");
     printf("Video: %s | Size: %dx%d\n", video_file, window_width, window_height);
 
@@ -63,6 +283,34 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "Error: Failed to initialize video player\n");
         return 1;
     }
+    player->startup_report = startup_report;
+    if (pin_threads) thread_pool_pin_workers(player->pool);
+
+    if (roi[2] > 0 && !video_player_set_roi(player, roi[0], roi[1], roi[2], roi[3])) {
+        fprintf(stderr, "Error: Cannot crop to the requested region\n");
+        video_player_cleanup(player);
+        return 1;
+    }
+
+    if (exposure != AUTO_EXPOSURE_OFF) video_player_set_exposure(player, exposure);
+    if (dither > 0.0) video_player_set_dither(player, dither);
+    if (fixed_grid) video_player_set_adaptive_grid(player, 0);
+    if (!static_skip) video_player_set_static_skip(player, 0);
+    if (raster && !player->display->raster &&
+        !sdl_display_set_raster(player->display, 1, player->pool)) {
+        video_player_cleanup(player);
+        return 1;
+    }
+    if (hysteresis >= 0 && !video_player_set_hysteresis(player, hysteresis)) {
+        video_player_cleanup(player);
+        return 1;
+    }
+
+    if (record_file && !video_player_start_recording(player, record_file)) {
+        fprintf(stderr, "Error: Cannot record to %s\n", record_file);
+        video_player_cleanup(player);
+        return 1;
+    }
 
     int result = video_player_run(player);
     video_player_cleanup(player);
@@ -1,11 +1,16 @@
 #define _GNU_SOURCE
 #include "video_sdl_player.h"
 #include "image_processing.h"
+#include "span_trace.h"
+#include "alloc_stats.h"
+#include "glyph_cache.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <math.h>
 
 double get_current_time_ms(void) {
     struct timeval tv;
@@ -13,6 +18,252 @@ double get_current_time_ms(void) {
     return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
 }
 
+// Sizes the ASCII grid to the current window, scaled down by the grid
+// controller's level, and (re)allocates the grid image and text buffers.
+// Only called at init, on window or config changes and on controller
+// steps; steps reuse the grid image and each level keeps its own resize
+// plan, so moving between levels does not allocate.
+static int video_player_rebuild_grid(VideoPlayer* player) {
+    int cols, rows;
+    if (!sdl_display_grid_size(player->display, &cols, &rows)) return 0;
+
+    double scale = grid_controller_scale(&player->grid_control);
+    if (scale < 1.0) {
+        cols = (int)(cols * scale);
+        rows = (int)(rows * scale);
+        if (cols < 1) cols = 1;
+        if (rows < 1) rows = 1;
+    }
+    sdl_display_set_text_grid(player->display, cols, rows);
+    grid_controller_restart(&player->grid_control);
+
+    // Each output cell covers a mode-dependent block of grid pixels
+    int grid_w, grid_h, max_grid_w, max_grid_h;
+    ascii_grid_limits(&player->ascii_config, cols, rows, &max_grid_w, &max_grid_h);
+    fit_aspect_ratio(player->frame_buffer->width, player->frame_buffer->height,
+                     max_grid_w, max_grid_h, &grid_w, &grid_h);
+
+    player->ascii_cols = cols;
+    player->ascii_rows = rows;
+
+    size_t grid_bytes = (size_t)grid_w * grid_h * 3;
+    if (player->grid_buffer && grid_bytes <= player->grid_capacity) {
+        player->grid_buffer->width = grid_w;
+        player->grid_buffer->height = grid_h;
+    } else {
+        Image* grid = create_image(grid_w, grid_h, 3);
+        if (!grid) return 0;
+        free_image(player->grid_buffer);
+        player->grid_buffer = grid;
+        player->grid_capacity = grid_bytes;
+    }
+
+    int level = player->grid_control.enabled ? player->grid_control.level : 0;
+    player->level_plans[level] = resize_plan_update(player->level_plans[level], player->frame_buffer,
+                                                    player->grid_buffer, player->resize_filter);
+    player->resize_plan = player->level_plans[level];
+    if (!player->resize_plan) return 0;
+
+    // Same pixels, different picture: the next frame must be drawn
+    static_frame_reset(&player->static_frames);
+
+    // Cached frames are grid-sized, so the cache follows the grid
+    gop_cache_configure(player->gop_cache, grid_w, grid_h, player->resize_filter);
+
+    size_t needed = ascii_buffer_size(grid_w, grid_h, &player->ascii_config);
+    if (needed > player->ascii_buffer_size) {
+        char* buffer = realloc(player->ascii_buffer, needed);
+        if (!buffer) return 0;
+        player->ascii_buffer = buffer;
+        player->ascii_buffer_size = needed;
+    }
+
+    return 1;
+}
+
+// Overlay numbers for the frame being presented
+static void video_player_fill_stats(VideoPlayer* player, SDLPerformanceStats* stats) {
+    stats->fps = player->target_fps;
+    stats->frame_count = (int)player->current_frame;
+    stats->avg_process_time = 0.0; // Could be calculated
+    stats->last_frame_time = get_current_time_ms() - player->last_frame_time;
+    stats->speed = player->reverse ? -1.0 : player->playback_speed;
+    stats->actual_speed = player->actual_speed;
+    stats->static_rate = static_frame_skip_rate(&player->static_frames);
+    if (player->ascii_config.hysteresis) {
+        stats->change_rate = glyph_hysteresis_change_rate(player->ascii_config.hysteresis);
+    }
+    stats->grid_cols = player->ascii_cols;
+    stats->grid_rows = player->ascii_rows;
+    stats->av_sync = player->audio_running;
+    stats->av_drift_ms = player->av_drift_ms;
+    stats->frames_dropped = player->frames_dropped;
+    if (player->audio) {
+        stats->audio_underruns = __atomic_load_n(&player->audio->underruns, __ATOMIC_RELAXED);
+    }
+    if (alloc_stats_enabled) {
+        AllocSnapshot snap;
+        alloc_stats_snapshot(&snap);
+        alloc_stats_last_frame(&stats->frame_allocs, &stats->frame_alloc_bytes);
+        stats->heap_peak_mb = snap.peak_live_bytes / 1048576.0;
+        stats->rss_peak_mb = alloc_stats_peak_rss_kb() / 1024.0;
+    }
+}
+
+// Converts the grid image for position_time and presents it. Returns 0
+// when the frame matched the one on screen and was not converted.
+static int video_player_present_grid(VideoPlayer* player) {
+    // Unchanged content keeps the texture already on screen, unless
+    // auto-exposure is still adapting to it; only the overlay is redrawn
+    int adapting = player->exposure.mode != AUTO_EXPOSURE_OFF && !player->exposure.settled;
+    if (!adapting && static_frame_check(&player->static_frames, player->grid_buffer)) {
+        if (player->show_stats) {
+            SDLPerformanceStats stats = {0};
+            video_player_fill_stats(player, &stats);
+            AllocScope scope = alloc_scope_enter(ALLOC_SCOPE_RENDER);
+            sdl_display_redraw(player->display, &stats);
+            alloc_scope_leave(scope);
+        }
+        return 0;
+    }
+
+    // Half-block cells carry their shades as terminal color escapes, which
+    // the TTF path cannot draw; the display paints the grid pixels instead
+    int halfblock = player->ascii_config.mode == ASCII_MODE_HALFBLOCK;
+
+    const char* ascii_art = NULL;
+    AllocScope scope = alloc_scope_enter(ALLOC_SCOPE_CONVERT);
+    if ((!halfblock || player->recorder) &&
+        image_to_ascii_into(player->grid_buffer, &player->ascii_config,
+                            player->ascii_buffer, player->ascii_buffer_size)) {
+        ascii_art = player->ascii_buffer;
+    }
+    alloc_scope_leave(scope);
+
+    if (player->recorder && ascii_art &&
+        !asciicast_recorder_frame(player->recorder, ascii_art, player->position_time)) {
+        fprintf(stderr, "Error: Recording failed, stopping recorder\n");
+        asciicast_recorder_close(player->recorder);
+        player->recorder = NULL;
+    }
+
+    if (halfblock) {
+        video_player_update_display(player, player->grid_buffer, NULL);
+    } else {
+        video_player_update_display(player, NULL, ascii_art);
+    }
+    return 1;
+}
+
+// Converts the frame currently held in frame_buffer and presents it. The
+// grid-dependent work of a drawn frame, less any vsync wait, feeds the grid
+// controller; a step takes effect from the next frame.
+static void video_player_render_frame(VideoPlayer* player) {
+    double start = get_current_time_ms();
+    AllocScope scope = alloc_scope_enter(ALLOC_SCOPE_RESIZE);
+    resize_plan_run(player->resize_plan, player->frame_buffer, player->grid_buffer, player->pool);
+    alloc_scope_leave(scope);
+    int drawn = video_player_present_grid(player);
+    alloc_stats_frame_end();
+
+    if (drawn && player->state == PLAYER_PLAYING) {
+        double work = get_current_time_ms() - start - player->display->present_ms;
+        if (grid_controller_sample(&player->grid_control, work, player->frame_delay_ms) &&
+            !video_player_rebuild_grid(player)) {
+            fprintf(stderr, "Error: Failed to rebuild ASCII grid\n");
+        }
+    }
+}
+
+// Shows the grid-sized frame a GOP cache lookup just produced
+static void video_player_show_cached(VideoPlayer* player, double frame_time) {
+    player->position_time = frame_time;
+    player->media_time = frame_time;
+    player->current_frame = (int64_t)(frame_time * player->original_fps + 0.5) + 1;
+    player->has_frame = 1;
+    player->forward_synced = 0;
+    video_player_present_grid(player);
+    alloc_stats_frame_end();
+}
+
+// Audio plays, and is the master clock, only while playing forward at 1x;
+// other modes keep the wall clock and leave the device paused. Whenever it
+// starts again it is re-seeked to the picture on screen.
+static void video_player_update_audio(VideoPlayer* player) {
+    if (!player->audio) return;
+
+    int wanted = player->state == PLAYER_PLAYING && !player->reverse &&
+                 fabs(player->playback_speed - 1.0) < 1e-6;
+    if (wanted == player->audio_running) return;
+
+    if (wanted) audio_player_seek(player->audio, player->position_time);
+    audio_player_set_paused(player->audio, !wanted);
+    player->audio_running = wanted;
+}
+
+// The picture jumped while audio was playing
+static void video_player_resync_audio(VideoPlayer* player) {
+    if (player->audio_running) audio_player_seek(player->audio, player->position_time);
+}
+
+// The cache's decoder ran backwards on its own; bring the main decoder to
+// the frame on screen so forward playback continues from there
+static void video_player_sync_forward(VideoPlayer* player) {
+    player->forward_synced = 1;
+    player->media_time = player->position_time;
+    if (!player->has_frame || !video_processor_seek_time(player->video_processor,
+                                                         player->position_time)) {
+        return;
+    }
+
+    double half = 0.5 / player->original_fps;
+    while (video_processor_skip_frame(player->video_processor)) {
+        if (video_processor_frame_time(player->video_processor) >= player->position_time - half) {
+            break;
+        }
+    }
+}
+
+static void video_player_apply_resize(VideoPlayer* player) {
+    player->resize_pending = 0;
+
+    if (!sdl_display_resize(player->display, player->pending_width, player->pending_height) ||
+        !video_player_rebuild_grid(player)) {
+        fprintf(stderr, "Error: Failed to resize ASCII grid\n");
+        return;
+    }
+
+    // While playing the next frame picks up the new grid; otherwise redraw now
+    if (player->state != PLAYER_PLAYING && player->has_frame) {
+        video_player_render_frame(player);
+    }
+}
+
+// Mode and charset changes alter the grid footprint and the bytes per cell
+static void video_player_config_changed(VideoPlayer* player) {
+    if (!video_player_rebuild_grid(player)) {
+        fprintf(stderr, "Error: Failed to rebuild ASCII grid\n");
+        return;
+    }
+    if (player->state != PLAYER_PLAYING && player->has_frame) {
+        video_player_render_frame(player);
+    }
+}
+
+typedef struct {
+    const char* video_file;
+    VideoProcessor* video_processor;
+    double elapsed_ms;
+} DecoderOpenTask;
+
+static void* decoder_open_thread(void* arg) {
+    DecoderOpenTask* task = (DecoderOpenTask*)arg;
+    double start = startup_now_ms();
+    task->video_processor = video_processor_init(task->video_file);
+    task->elapsed_ms = startup_now_ms() - start;
+    return NULL;
+}
+
 VideoPlayer* video_player_init(const char* video_file, int window_width, int window_height) {
     if (!video_file) {
         fprintf(stderr, "Error: No video file specified\n");
@@ -25,14 +276,33 @@ VideoPlayer* video_player_init(const char* video_file, int window_width, int win
         return NULL;
     }
 
-    player->video_processor = video_processor_init(video_file);
+    startup_profile_begin(&player->startup);
+
+    // Probing the container and opening the codec does not touch SDL, so it
+    // runs on a helper thread while SDL, TTF and the font are brought up here
+    // (SDL video must stay on the main thread).
+    DecoderOpenTask decoder_task = {video_file, NULL, 0.0};
+    pthread_t decoder_thread;
+    int threaded = pthread_create(&decoder_thread, NULL, decoder_open_thread, &decoder_task) == 0;
+    if (!threaded) {
+        decoder_open_thread(&decoder_task);
+    }
+
+    player->display = sdl_display_init(window_width, window_height, &player->startup);
+
+    if (threaded) {
+        pthread_join(decoder_thread, NULL);
+    }
+    player->video_processor = decoder_task.video_processor;
+    player->startup.phase_ms[STARTUP_PHASE_DECODER_OPEN] = decoder_task.elapsed_ms;
+
     if (!player->video_processor) {
         fprintf(stderr, "Error: Failed to initialize video processor\n");
+        if (player->display) sdl_display_cleanup(player->display);
         free(player);
         return NULL;
     }
 
-    player->display = sdl_display_init(window_width, window_height);
     if (!player->display) {
         fprintf(stderr, "Error: Failed to initialize SDL display\n");
         video_processor_cleanup(player->video_processor);
@@ -41,6 +311,9 @@ VideoPlayer* video_player_init(const char* video_file, int window_width, int win
     }
 
     player->ascii_config = create_default_config();
+    auto_exposure_init(&player->exposure, AUTO_EXPOSURE_OFF);
+    player->ascii_config.exposure = &player->exposure;
+    grid_controller_init(&player->grid_control, 1);
     player->state = PLAYER_STOPPED;
     player->playback_speed = 1.0;
     player->current_frame = 0;
@@ -49,23 +322,38 @@ VideoPlayer* video_player_init(const char* video_file, int window_width, int win
     player->target_fps = player->original_fps;
     player->show_controls = 1;
     player->show_stats = 1;
-    // Override ASCII grid to 400×400 characters
-    player->ascii_cols = 200;
-    player->ascii_rows = 200;
-    // Resize window to fit exactly 400×400 characters
-    {
-        SDL_SetWindowSize(player->display->window, 1100, 1100);
-        int new_win_w = player->display->char_width * player->ascii_cols;
-        int new_win_h = player->display->char_height * player->ascii_rows;
-        player->display->window_width = new_win_w;
-        player->display->window_height = new_win_h;
-        player->display->ascii_width = new_win_w;
-        player->display->ascii_height = new_win_h;
-        player->display->video_width = new_win_w / 2;
-        player->display->video_height = new_win_h;
+    player->resize_filter = RESIZE_DEFAULT_FILTER;
+
+    // Large downscales and conversions split their rows across the pool;
+    // the main thread takes a share itself, hence one worker fewer than CPUs
+    int cpus = thread_pool_cpu_count();
+    if (cpus > 1) player->pool = thread_pool_create(cpus - 1, cpus);
+    player->ascii_config.pool = player->pool;
+
+    // Per-line TTF textures are slowest exactly where there is no GPU
+    if (player->display->software_renderer) sdl_display_set_raster(player->display, 1, player->pool);
+
+    // Backward stepping and reverse playback decode through their own
+    // decoder, opened only once they are first used
+    player->gop_cache = gop_cache_create(video_file, player->original_fps);
+    player->preroll = decoder_preroll_create(video_file);
+    player->audio = audio_player_create(video_file);
+
+    player->frame_buffer = create_image(video_processor_get_width(player->video_processor),
+                                        video_processor_get_height(player->video_processor), 3);
+    if (!player->frame_buffer || !video_player_rebuild_grid(player)) {
+        fprintf(stderr, "Error: Cannot allocate frame buffers\n");
+        video_player_cleanup(player);
+        return NULL;
     }
     player->frame_delay_ms = 1000.0 / player->target_fps;
     player->last_frame_time = get_current_time_ms();
+    player->forward_synced = 1;
+    player->duration = video_processor_get_duration(player->video_processor);
+    if (player->duration <= 0.0 && player->total_frames > 0) {
+        player->duration = player->total_frames / player->original_fps;
+    }
+    startup_profile_finish(&player->startup);
     
     printf("Video Player Initialized:\n");
     printf("  Video: %s\n", video_file);
@@ -74,6 +362,12 @@ VideoPlayer* video_player_init(const char* video_file, int window_width, int win
            video_processor_get_height(player->video_processor));
     printf("  FPS: %.2f\n", player->original_fps);
     printf("  Total frames: %ld\n", player->total_frames);
+    if (player->audio) {
+        printf("  Audio: %d Hz, %d channel%s\n", player->audio->sample_rate,
+               player->audio->channels, player->audio->channels == 1 ? "" : "s");
+    } else {
+        printf("  Audio: none\n");
+    }
     printf("  ASCII dimensions: %dx%d characters\n", player->ascii_cols, player->ascii_rows);
     
     return player;
@@ -81,20 +375,49 @@ VideoPlayer* video_player_init(const char* video_file, int window_width, int win
 
 void video_player_cleanup(VideoPlayer* player) {
     if (!player) return;
+    if (player->recorder && !asciicast_recorder_close(player->recorder)) {
+        fprintf(stderr, "Error: Recording was not written completely\n");
+    }
+    audio_player_destroy(player->audio);
+    free_image(player->frame_buffer);
+    free_image(player->grid_buffer);
+    for (int i = 0; i < GRID_CONTROL_LEVELS; i++) resize_plan_destroy(player->level_plans[i]);
+    thread_pool_destroy(player->pool);
+    gop_cache_destroy(player->gop_cache);
+    decoder_preroll_destroy(player->preroll);
+    glyph_hysteresis_destroy(player->hysteresis);
+    static_frame_free(&player->static_frames);
+    free(player->shapes);
+    free(player->ascii_buffer);
     if (player->video_processor) video_processor_cleanup(player->video_processor);
     if (player->display) sdl_display_cleanup(player->display);
     free(player);
 }
 
+int video_player_start_recording(VideoPlayer* player, const char* filename) {
+    if (!player || player->recorder) return 0;
+
+    player->recorder = asciicast_recorder_open(filename);
+    if (!player->recorder) return 0;
+
+    printf("Recording to %s\n", filename);
+    return 1;
+}
+
 void video_player_play(VideoPlayer* player) {
     if (!player) return;
     if (player->state == PLAYER_STOPPED) {
         video_processor_reset(player->video_processor);
         player->current_frame = 0;
+        player->position_time = 0.0;
+        player->media_time = 0.0;
+        player->has_frame = 0;
+        player->forward_synced = 1;
     }
     player->state = PLAYER_PLAYING;
     player->last_frame_time = get_current_time_ms();
-    printf("Playing video...\n");
+    player->speed_window_ms = 0.0;
+    printf(player->reverse ? "Playing video in reverse...\n" : "Playing video...\n");
 }
 
 void video_player_pause(VideoPlayer* player) {
@@ -108,15 +431,152 @@ void video_player_stop(VideoPlayer* player) {
     player->state = PLAYER_STOPPED;
     video_processor_reset(player->video_processor);
     player->current_frame = 0;
+    player->position_time = 0.0;
+    player->media_time = 0.0;
+    player->has_frame = 0;
+    player->forward_synced = 1;
+    player->reverse = 0;
     printf("Video stopped\n");
 }
 
+static enum AVDiscard video_player_discard(double speed) {
+    if (speed > PLAYER_KEYFRAME_SPEED) return AVDISCARD_NONKEY;
+    if (speed >= PLAYER_NONREF_SPEED) return AVDISCARD_NONREF;
+    return AVDISCARD_DEFAULT;
+}
+
+// Points the main decoder at the player's region of interest and sizes the
+// frame buffer to it. The frame the decoder still holds is converted again,
+// so a paused picture follows the new crop.
+static int video_player_apply_roi(VideoPlayer* player) {
+    VideoProcessor* vp = player->video_processor;
+    if (!video_processor_set_roi(vp, player->roi_x, player->roi_y,
+                                 player->roi_width, player->roi_height)) {
+        return 0;
+    }
+
+    if (player->frame_buffer->width != vp->width || player->frame_buffer->height != vp->height) {
+        Image* frame = create_image(vp->width, vp->height, 3);
+        if (!frame) return 0;
+        free_image(player->frame_buffer);
+        player->frame_buffer = frame;
+    }
+    // A pan keeps the size but still moves the picture
+    if (player->has_frame) video_processor_convert_frame(vp, player->frame_buffer);
+    return 1;
+}
+
+// Continues from the pre-rolled decoder at the end of the video. Its first
+// frame is already in the new frame buffer, so the loop costs no decode.
+static int video_player_swap_decoder(VideoPlayer* player) {
+    Image* frame = NULL;
+    VideoProcessor* vp = decoder_preroll_take(player->preroll, &frame);
+    if (!vp) return 0;
+
+    decoder_preroll_retire(player->preroll, player->video_processor, player->frame_buffer);
+    player->video_processor = vp;
+    player->frame_buffer = frame;
+    video_processor_set_discard(vp, video_player_discard(player->playback_speed));
+
+    // The crop changed while the next loop was pre-rolling
+    int width = player->roi_width > 0 ? player->roi_width : vp->source_width;
+    int height = player->roi_width > 0 ? player->roi_height : vp->source_height;
+    if (vp->roi_x != player->roi_x || vp->roi_y != player->roi_y ||
+        vp->width != width || vp->height != height) {
+        if (!video_player_apply_roi(player) || !video_player_rebuild_grid(player)) return 0;
+    }
+    return 1;
+}
+
 void video_player_set_speed(VideoPlayer* player, double speed) {
     if (!player || speed <= 0.0) return;
     player->playback_speed = speed;
     player->target_fps = player->original_fps * speed;
-    player->frame_delay_ms = 1000.0 / player->target_fps;
-    printf("Speed: %.2fx (%.2f FPS)\n", speed, player->target_fps);
+
+    // Past 1x the display keeps the source rate and the media clock runs
+    // ahead of it; the frames in between are dropped as early as possible
+    double display_fps = speed > 1.0 ? player->original_fps : player->target_fps;
+    player->frame_delay_ms = 1000.0 / display_fps;
+
+    enum AVDiscard discard = video_player_discard(speed);
+    const char* decode = "";
+    if (discard == AVDISCARD_NONKEY) {
+        decode = ", keyframes only";
+    } else if (discard == AVDISCARD_NONREF) {
+        decode = ", reference frames only";
+    }
+    video_processor_set_discard(player->video_processor, discard);
+    player->key_interval = 0.0;
+    player->media_time = player->position_time;
+    player->speed_window_ms = 0.0;
+
+    printf("Speed: %.2fx (%.2f FPS%s)\n", speed, player->target_fps, decode);
+}
+
+// Decodes the next frame to show into frame_buffer. Returns 1 for a frame,
+// 0 at the end of the video and -1 when the media clock has not reached the
+// next frame yet. With an audio clock the current picture is held (shown
+// again) until its successor is due, and frames whose slot has already
+// passed are decoded but never converted.
+static int video_player_decode_next(VideoPlayer* player, double elapsed_ms,
+                                    const double* audio_clock) {
+    VideoProcessor* vp = player->video_processor;
+    if (audio_clock) {
+        double interval = 1.0 / player->original_fps;
+        if (player->has_frame && *audio_clock < player->position_time + interval) return -1;
+        while (player->has_frame && video_processor_frame_time(vp) + 2.0 * interval <= *audio_clock) {
+            if (!video_processor_skip_frame(vp)) return 0;
+            player->frames_dropped++;
+        }
+        return video_processor_read_frame(vp, player->frame_buffer);
+    }
+
+    if (player->playback_speed <= 1.0) {
+        return video_processor_read_frame(vp, player->frame_buffer);
+    }
+
+    double interval = 1.0 / player->original_fps;
+    player->media_time += elapsed_ms / 1000.0 * player->playback_speed;
+    if (player->has_frame && player->media_time < player->position_time + interval * 0.5) {
+        return -1;
+    }
+
+    if (player->playback_speed > PLAYER_KEYFRAME_SPEED) {
+        // Reading keyframe by keyframe cannot keep up once the clock is more
+        // than a couple of GOPs ahead; jump to the keyframe before it instead
+        double lag = player->media_time - player->position_time;
+        double seek_lag = 2.0 * player->key_interval;
+        if (seek_lag < PLAYER_SEEK_LAG_S) seek_lag = PLAYER_SEEK_LAG_S;
+        if (lag > seek_lag) video_processor_seek_time(vp, player->media_time);
+
+        if (!video_processor_read_frame(vp, player->frame_buffer)) return 0;
+        double key_time = video_processor_frame_time(vp);
+        if (key_time > player->position_time) {
+            player->key_interval = key_time - player->position_time;
+        }
+        return 1;
+    }
+
+    // Frames between display slots are decoded but never converted
+    while (video_processor_frame_time(vp) + 2.0 * interval <= player->media_time) {
+        if (!video_processor_skip_frame(vp)) return 0;
+    }
+    return video_processor_read_frame(vp, player->frame_buffer);
+}
+
+// Media seconds shown per wall-clock second, over roughly one second;
+// negative while playing in reverse
+static void video_player_measure_speed(VideoPlayer* player, double now) {
+    double elapsed = now - player->speed_window_ms;
+    double moved = player->position_time - player->speed_window_time;
+    if (player->speed_window_ms <= 0.0 || (player->reverse ? moved > 0.0 : moved < 0.0)) {
+        player->speed_window_ms = now;
+        player->speed_window_time = player->position_time;
+    } else if (elapsed >= 1000.0) {
+        player->actual_speed = moved * 1000.0 / elapsed;
+        player->speed_window_ms = now;
+        player->speed_window_time = player->position_time;
+    }
 }
 
 int video_player_handle_events(VideoPlayer* player) {
@@ -127,6 +587,23 @@ int video_player_handle_events(VideoPlayer* player) {
         switch (e.type) {
             case SDL_QUIT:
                 return 0;  // Quit
+
+            case SDL_WINDOWEVENT:
+                // Coalesced: the grid is rebuilt once, after the event queue drains
+                if (e.window.event == SDL_WINDOWEVENT_EXPOSED) {
+                    // The skipped-frame shortcut relies on the window keeping
+                    // its contents; redraw when it did not
+                    static_frame_reset(&player->static_frames);
+                    if (player->state != PLAYER_PLAYING && player->has_frame) {
+                        video_player_present_grid(player);
+                    }
+                }
+                if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                    player->resize_pending = 1;
+                    player->pending_width = e.window.data1;
+                    player->pending_height = e.window.data2;
+                }
+                break;
                 
             case SDL_KEYDOWN:
                 switch (e.key.keysym.sym) {
@@ -160,6 +637,53 @@ int video_player_handle_events(VideoPlayer* player) {
                         }
                         break;
                         
+                    case SDLK_COMMA:
+                        // Step back one frame
+                        video_player_step(player, -1);
+                        break;
+
+                    case SDLK_PERIOD:
+                        // Step forward one frame
+                        video_player_step(player, 1);
+                        break;
+
+                    case SDLK_b:
+                        // Toggle reverse playback
+                        video_player_set_reverse(player, !player->reverse);
+                        break;
+
+                    case SDLK_EQUALS:
+                    case SDLK_KP_PLUS:
+                        video_player_zoom(player, PLAYER_ZOOM_STEP);
+                        break;
+
+                    case SDLK_MINUS:
+                    case SDLK_KP_MINUS:
+                        video_player_zoom(player, 1.0 / PLAYER_ZOOM_STEP);
+                        break;
+
+                    case SDLK_KP_4:
+                        video_player_pan(player, -1, 0);
+                        break;
+
+                    case SDLK_KP_6:
+                        video_player_pan(player, 1, 0);
+                        break;
+
+                    case SDLK_KP_8:
+                        video_player_pan(player, 0, -1);
+                        break;
+
+                    case SDLK_KP_2:
+                        video_player_pan(player, 0, 1);
+                        break;
+
+                    case SDLK_0:
+                    case SDLK_KP_0:
+                        // Back to the whole frame
+                        video_player_set_roi(player, 0, 0, 0, 0);
+                        break;
+
                     case SDLK_UP:
                         // Increase speed
                         video_player_set_speed(player, player->playback_speed * 1.25);
@@ -184,18 +708,66 @@ int video_player_handle_events(VideoPlayer* player) {
                         printf("Switched to character set %d: %s\n", 
                                player->ascii_config.char_set_index + 1,
                                ASCII_SETS[player->ascii_config.char_set_index].name);
+                        video_player_config_changed(player);
+                        break;
+
+                    case SDLK_m:
+                        // Cycle cell mode: charset, braille, half-block, shape
+                        if (!video_player_set_mode(player, (player->ascii_config.mode + 1) %
+                                                           ASCII_MODE_COUNT)) {
+                            video_player_set_mode(player, (player->ascii_config.mode + 2) %
+                                                          ASCII_MODE_COUNT);
+                        }
                         break;
                         
+                    case SDLK_f:
+                        // Cycle resize filter
+                        player->resize_filter = (player->resize_filter + 1) % RESIZE_FILTER_COUNT;
+                        printf("Resize filter: %s\n", resize_filter_name(player->resize_filter));
+                        video_player_config_changed(player);
+                        break;
+
                     case SDLK_i:
                         // Invert brightness
                         player->ascii_config.invert_brightness = !player->ascii_config.invert_brightness;
+                        static_frame_reset(&player->static_frames);
                         printf("Brightness inversion: %s\n", 
                                player->ascii_config.invert_brightness ? "ON" : "OFF");
                         break;
+
+                    case SDLK_LEFTBRACKET:
+                        video_player_set_dither(player, player->ascii_config.dither - PLAYER_DITHER_STEP);
+                        break;
+
+                    case SDLK_RIGHTBRACKET:
+                        video_player_set_dither(player, player->ascii_config.dither + PLAYER_DITHER_STEP);
+                        break;
+
+                    case SDLK_a:
+                        // Toggle the adaptive grid
+                        video_player_set_adaptive_grid(player, !player->grid_control.enabled);
+                        break;
+
+                    case SDLK_g:
+                        // Toggle glyph hysteresis
+                        video_player_set_hysteresis(player, player->ascii_config.hysteresis
+                                                                ? -1 : GLYPH_HYSTERESIS_DEFAULT_MARGIN);
+                        break;
+
+                    case SDLK_e:
+                        // Cycle auto-exposure: off, levels, equalize
+                        video_player_set_exposure(player, (player->exposure.mode + 1) %
+                                                          AUTO_EXPOSURE_MODE_COUNT);
+                        break;
                         
                     case SDLK_r:
                         // Reset settings
                         player->ascii_config = create_default_config();
+                        player->ascii_config.exposure = &player->exposure;
+                        player->ascii_config.pool = player->pool;
+                        player->ascii_config.shapes = player->shapes;
+                        auto_exposure_init(&player->exposure, AUTO_EXPOSURE_OFF);
+                        video_player_config_changed(player);
                         video_player_set_speed(player, 1.0);
                         printf("Reset to default settings\n");
                         break;
@@ -211,6 +783,7 @@ int video_player_handle_events(VideoPlayer* player) {
                     case SDLK_t:
                         // Toggle stats display
                         player->show_stats = !player->show_stats;
+                        static_frame_reset(&player->static_frames);
                         break;
                 }
                 break;
@@ -220,40 +793,274 @@ int video_player_handle_events(VideoPlayer* player) {
     return 1;
 }
 
+// The curve starts over from the next converted frame
+void video_player_set_exposure(VideoPlayer* player, AutoExposureMode mode) {
+    if (!player || mode < 0 || mode >= AUTO_EXPOSURE_MODE_COUNT) return;
+
+    auto_exposure_init(&player->exposure, mode);
+    static_frame_reset(&player->static_frames);
+    printf("Auto-exposure: %s\n", auto_exposure_mode_name(mode));
+}
+
+void video_player_set_dither(VideoPlayer* player, double strength) {
+    if (!player) return;
+
+    if (strength < 0.0) strength = 0.0;
+    if (strength > 1.0) strength = 1.0;
+    player->ascii_config.dither = strength;
+    static_frame_reset(&player->static_frames);
+    if (strength > 0.0) {
+        printf("Ordered dither: %.0f%%\n", strength * 100.0);
+    } else {
+        printf("Ordered dither: OFF\n");
+    }
+}
+
+void video_player_set_adaptive_grid(VideoPlayer* player, int enabled) {
+    if (!player) return;
+
+    grid_controller_init(&player->grid_control, enabled);
+    if (!video_player_rebuild_grid(player)) {
+        fprintf(stderr, "Error: Failed to rebuild ASCII grid\n");
+        return;
+    }
+    printf("Adaptive grid: %s\n", enabled ? "ON" : "OFF");
+}
+
+// With the skip off every frame is converted and drawn, changed or not
+void video_player_set_static_skip(VideoPlayer* player, int enabled) {
+    if (!player) return;
+
+    static_frame_set_enabled(&player->static_frames, enabled);
+    printf("Static frame skip: %s\n", enabled ? "ON" : "OFF");
+}
+
+// A negative margin turns hysteresis off; the cell memory is kept for the
+// next time it is turned on
+int video_player_set_hysteresis(VideoPlayer* player, int margin) {
+    if (!player) return 0;
+
+    static_frame_reset(&player->static_frames);
+    if (margin < 0) {
+        player->ascii_config.hysteresis = NULL;
+        printf("Glyph hysteresis: OFF\n");
+        return 1;
+    }
+
+    if (!player->hysteresis) {
+        player->hysteresis = glyph_hysteresis_create(margin);
+        if (!player->hysteresis) return 0;
+    }
+    glyph_hysteresis_set_margin(player->hysteresis, margin);
+    glyph_hysteresis_reset(player->hysteresis);
+    player->ascii_config.hysteresis = player->hysteresis;
+    printf("Glyph hysteresis: %d levels\n", margin);
+    return 1;
+}
+
+// Shape masks are built from the display font the first time shape mode is
+// picked, so startup never pays for them. Fails, leaving the mode as it
+// was, when the font cannot be rasterized.
+int video_player_set_mode(VideoPlayer* player, AsciiMode mode) {
+    if (!player || mode < 0 || mode >= ASCII_MODE_COUNT) return 0;
+
+    if (mode == ASCII_MODE_SHAPE && !player->shapes) {
+        GlyphCache* cache = player->display->glyphs;
+        if (!cache) cache = glyph_cache_create(player->display->font_size);
+        ShapeGlyphs* shapes = malloc(sizeof(ShapeGlyphs));
+        if (cache && shapes && glyph_cache_shape_glyphs(cache, shapes)) {
+            player->shapes = shapes;
+            printf("Shape glyphs: %d masks\n", shapes->count);
+        } else {
+            fprintf(stderr, "Error: Cannot build glyph masks for shape mode\n");
+            free(shapes);
+        }
+        if (cache != player->display->glyphs) glyph_cache_destroy(cache);
+        if (!player->shapes) return 0;
+    }
+
+    player->ascii_config.mode = mode;
+    player->ascii_config.shapes = player->shapes;
+    printf("Cell mode: %s\n", ascii_mode_name(mode));
+    video_player_config_changed(player);
+    return 1;
+}
+
 void video_player_seek_frame(VideoPlayer* player, int64_t frame) {
     if (!player || frame < 0 || frame >= player->total_frames) return;
 
-    video_processor_reset(player->video_processor);
-    player->current_frame = 0;
+    // Jump to the keyframe before the target and decode, without
+    // converting, up to the frame just before it
+    VideoProcessor* vp = player->video_processor;
+    double target = frame / player->original_fps;
+    double half = 0.5 / player->original_fps;
+    if (!video_processor_seek_time(vp, target)) {
+        fprintf(stderr, "Error: Seek to frame %ld failed\n", frame);
+        return;
+    }
 
-    // Skip frames to reach target
-    for (int64_t i = 0; i < frame; i++) {
-        Image* temp_frame = video_processor_get_next_frame(player->video_processor);
-        if (temp_frame) {
-            free_image(temp_frame);
-            player->current_frame++;
-        } else {
-            break;
+    player->has_frame = 0;
+    player->forward_synced = 1;
+    if (frame > 0) {
+        while (video_processor_skip_frame(vp)) {
+            player->has_frame = 1;
+            if (video_processor_frame_time(vp) >= target - 3.0 * half) break;
         }
     }
+    player->current_frame = vp->current_frame;
+
+    if (player->has_frame && video_processor_convert_frame(vp, player->frame_buffer)) {
+        player->position_time = video_processor_frame_time(vp);
+        video_player_render_frame(player);
+    } else {
+        player->position_time = 0.0;
+    }
+    player->media_time = player->position_time;
+    video_player_resync_audio(player);
 
     printf("Seeked to frame %ld\n", player->current_frame);
 }
 
+void video_player_step(VideoPlayer* player, int direction) {
+    if (!player) return;
+    if (player->state == PLAYER_PLAYING) video_player_pause(player);
+
+    double frame_time;
+    if (direction < 0) {
+        int result = gop_cache_frame_before(player->gop_cache, player->position_time,
+                                            player->grid_buffer, &frame_time, 1);
+        if (result > 0) {
+            video_player_show_cached(player, frame_time);
+        } else {
+            printf("At the first frame\n");
+        }
+        return;
+    }
+
+    // Stepping forward again after stepping back is served from the cache
+    if (!player->forward_synced &&
+        gop_cache_frame_after(player->gop_cache, player->position_time,
+                              player->grid_buffer, &frame_time)) {
+        video_player_show_cached(player, frame_time);
+        return;
+    }
+
+    if (!player->forward_synced) video_player_sync_forward(player);
+    if (video_processor_read_frame(player->video_processor, player->frame_buffer)) {
+        player->current_frame = player->video_processor->current_frame;
+        player->position_time = video_processor_frame_time(player->video_processor);
+        player->media_time = player->position_time;
+        player->has_frame = 1;
+        video_player_render_frame(player);
+    } else {
+        printf("At the last frame\n");
+    }
+}
+
+// Crops the source to the given rectangle before any scaling; a width or
+// height of 0 shows the whole frame. The grid keeps its size, so a smaller
+// region shows more detail.
+int video_player_set_roi(VideoPlayer* player, int x, int y, int width, int height) {
+    if (!player) return 0;
+
+    int old[4] = {player->roi_x, player->roi_y, player->roi_width, player->roi_height};
+    player->roi_x = x;
+    player->roi_y = y;
+    player->roi_width = width;
+    player->roi_height = height;
+    if (!video_player_apply_roi(player)) {
+        player->roi_x = old[0];
+        player->roi_y = old[1];
+        player->roi_width = old[2];
+        player->roi_height = old[3];
+        video_player_apply_roi(player);
+        return 0;
+    }
+
+    // Keep the snapped rectangle so panning steps from what is on screen
+    VideoProcessor* vp = player->video_processor;
+    int full = vp->width == vp->source_width && vp->height == vp->source_height;
+    player->roi_x = vp->roi_x;
+    player->roi_y = vp->roi_y;
+    player->roi_width = full ? 0 : vp->width;
+    player->roi_height = full ? 0 : vp->height;
+
+    if (!video_player_rebuild_grid(player)) {
+        fprintf(stderr, "Error: Failed to rebuild ASCII grid\n");
+        return 0;
+    }
+    gop_cache_set_roi(player->gop_cache, player->roi_x, player->roi_y,
+                      player->roi_width, player->roi_height);
+
+    if (player->state != PLAYER_PLAYING && player->has_frame) {
+        if (player->forward_synced) {
+            video_player_render_frame(player);
+        } else {
+            // The picture came from the GOP cache, which just dropped it
+            double frame_time;
+            double next = player->position_time + 0.5 / player->original_fps;
+            if (gop_cache_frame_before(player->gop_cache, next, player->grid_buffer,
+                                       &frame_time, 1) > 0) {
+                video_player_show_cached(player, frame_time);
+            }
+        }
+    }
+
+    if (full) {
+        printf("Region of interest: full frame\n");
+    } else {
+        printf("Region of interest: %dx%d at %d,%d\n", vp->width, vp->height, vp->roi_x, vp->roi_y);
+    }
+    return 1;
+}
+
+// Zooms about the centre of the current region
+void video_player_zoom(VideoPlayer* player, double factor) {
+    if (!player || factor <= 0.0) return;
+
+    VideoProcessor* vp = player->video_processor;
+    int width = (int)(vp->width / factor + 0.5);
+    int height = (int)(vp->height / factor + 0.5);
+    if (width < PLAYER_MIN_ROI || height < PLAYER_MIN_ROI) return;
+    if (width >= vp->source_width || height >= vp->source_height) {
+        video_player_set_roi(player, 0, 0, 0, 0);
+        return;
+    }
+
+    int x = vp->roi_x + (vp->width - width) / 2;
+    int y = vp->roi_y + (vp->height - height) / 2;
+    video_player_set_roi(player, x, y, width, height);
+}
+
+// Moves the region by an eighth of its size per step
+void video_player_pan(VideoPlayer* player, int dx, int dy) {
+    if (!player || player->roi_width <= 0) return;
+
+    int x = player->roi_x + dx * (player->roi_width / 8 > 1 ? player->roi_width / 8 : 1);
+    int y = player->roi_y + dy * (player->roi_height / 8 > 1 ? player->roi_height / 8 : 1);
+    video_player_set_roi(player, x, y, player->roi_width, player->roi_height);
+}
+
+void video_player_set_reverse(VideoPlayer* player, int reverse) {
+    if (!player) return;
+    player->reverse = reverse;
+    player->speed_window_ms = 0.0;
+    if (player->state == PLAYER_STOPPED) player->reverse = 0;
+    printf("Reverse playback: %s\n", player->reverse ? "ON" : "OFF");
+    if (player->state != PLAYER_PLAYING && player->reverse) video_player_play(player);
+}
+
 void video_player_update_display(VideoPlayer* player, const Image* frame, const char* ascii_art) {
     if (!player || !player->display) return;
 
     // Create performance stats
     SDLPerformanceStats stats = {0};
-    if (player->show_stats) {
-        stats.fps = player->target_fps;
-        stats.frame_count = (int)player->current_frame;
-        stats.avg_process_time = 0.0; // Could be calculated
-        stats.last_frame_time = get_current_time_ms() - player->last_frame_time;
-    }
+    if (player->show_stats) video_player_fill_stats(player, &stats);
 
     // Display the frame
+    AllocScope scope = alloc_scope_enter(ALLOC_SCOPE_RENDER);
     sdl_display_frame_split(player->display, frame, ascii_art, player->show_stats ? &stats : NULL);
+    alloc_scope_leave(scope);
 }
 
 // Main video player run loop
@@ -274,41 +1081,101 @@ int video_player_run(VideoPlayer* player) {
             break; // Quit requested
         }
 
-        // Process frame if playing
+        if (player->resize_pending) {
+            video_player_apply_resize(player);
+        }
+
+        video_player_update_audio(player);
+        double audio_clock = 0.0;
+        int audio_clocked = player->audio_running && audio_player_clock(player->audio, &audio_clock);
+
+        // Reverse playback takes frames from the GOP cache; a frame whose GOP
+        // is still decoding is retried on the next pass
         if (player->state == PLAYER_PLAYING) {
+            video_player_measure_speed(player, current_time);
+        }
+
+        if (player->state == PLAYER_PLAYING && player->reverse) {
+            if (current_time - player->last_frame_time >= player->frame_delay_ms) {
+                double frame_time;
+                int result = gop_cache_frame_before(player->gop_cache, player->position_time,
+                                                    player->grid_buffer, &frame_time, 0);
+                if (result > 0) {
+                    video_player_show_cached(player, frame_time);
+                    player->last_frame_time = current_time;
+                } else if (result < 0) {
+                    printf("Start of video reached\n");
+                    player->reverse = 0;
+                    video_player_pause(player);
+                }
+            }
+        } else if (player->state == PLAYER_PLAYING) {
             double time_since_last_frame = current_time - player->last_frame_time;
 
-            if (time_since_last_frame >= player->frame_delay_ms) {
-                // Get next frame
-                Image* frame = video_processor_get_next_frame(player->video_processor);
-                if (frame) {
-                    player->current_frame++;
+            if (audio_clocked || time_since_last_frame >= player->frame_delay_ms) {
+                if (!player->forward_synced) video_player_sync_forward(player);
 
-                    // Create ASCII version (no need for display image anymore)
-                    Image* ascii_img = resize_image_aspect_ratio(frame,
-                                                               player->ascii_cols,
-                                                               player->ascii_rows);
+                // Decode into the reusable frame buffer
+                uint64_t span = span_begin();
+                AllocScope scope = alloc_scope_enter(ALLOC_SCOPE_DECODE);
+                int decoded = video_player_decode_next(player, time_since_last_frame,
+                                                       audio_clocked ? &audio_clock : NULL);
+                alloc_scope_leave(scope);
+                if (decoded < 0) {
+                    if (!audio_clocked) player->last_frame_time = current_time;
+                } else if (decoded) {
+                    player->current_frame = player->video_processor->current_frame;
+                    player->position_time = video_processor_frame_time(player->video_processor);
+                    player->has_frame = 1;
 
-                    char* ascii_art = NULL;
-                    if (ascii_img) {
-                        ascii_art = image_to_ascii(ascii_img, &player->ascii_config);
+                    video_player_render_frame(player);
+                    span_end("frame", span);
+
+                    // Positive while the picture is ahead of the sound
+                    double heard;
+                    if (audio_clocked && audio_player_clock(player->audio, &heard)) {
+                        double drift = (player->position_time - heard) * 1000.0;
+                        player->av_drift_ms += PLAYER_DRIFT_SMOOTHING * (drift - player->av_drift_ms);
                     }
 
-                    // Update display (pass NULL for video image)
-                    video_player_update_display(player, NULL, ascii_art);
+                    if (!player->first_frame_shown) {
+                        player->first_frame_shown = 1;
+                        startup_profile_record(&player->startup, STARTUP_PHASE_FIRST_FRAME,
+                                               player->startup.start_ms);
+                        if (player->startup_report) {
+                            startup_profile_print(&player->startup);
+                        }
+                    }
 
-                    // Cleanup
-                    if (ascii_art) free(ascii_art);
-                    if (ascii_img) free_image(ascii_img);
-                    free_image(frame);
+                    player->last_frame_time = current_time;
 
+                    // Open the decoder for the next loop while this one plays out
+                    if (player->preroll && !player->preroll->running && player->duration > 0.0 &&
+                        player->position_time >= player->duration - DECODER_PREROLL_LEAD_S) {
+                        player->preroll->roi[0] = player->roi_x;
+                        player->preroll->roi[1] = player->roi_y;
+                        player->preroll->roi[2] = player->roi_width;
+                        player->preroll->roi[3] = player->roi_height;
+                        decoder_preroll_start(player->preroll);
+                    }
+                } else if (player->preroll && player->preroll->running &&
+                           video_player_swap_decoder(player)) {
+                    player->current_frame = player->video_processor->current_frame;
+                    player->position_time = video_processor_frame_time(player->video_processor);
+                    player->media_time = player->position_time;
+                    video_player_resync_audio(player);
+                    video_player_render_frame(player);
+                    span_end("frame", span);
                     player->last_frame_time = current_time;
                 } else {
                     // End of video - loop back to beginning
                     printf("End of video reached - looping...\n");
                     video_processor_reset(player->video_processor);
                     player->current_frame = 0;
+                    player->position_time = 0.0;
+                    player->media_time = 0.0;
                     player->last_frame_time = current_time;
+                    video_player_resync_audio(player);
                 }
             }
         }
@@ -323,8 +1190,10 @@ int video_player_run(VideoPlayer* player) {
 
 void video_player_print_controls(void) {
     printf("\n=== Controls ===\n");
-    printf("SPACE: Play/Pause | S: Stop | LEFT/RIGHT: Seek\n");
-    printf("UP/DOWN: Speed | 1-6: Character sets | I: Invert\n");
+    printf("SPACE: Play/Pause | S: Stop | LEFT/RIGHT: Seek | ,/.: Step frame | B: Reverse\n");
+    printf("UP/DOWN: Speed | 1-6: Character sets | M: Cell mode | F: Filter | I: Invert\n");
+    printf("E: Auto-exposure | [/]: Dither strength | G: Glyph hysteresis | A: Adaptive grid\n");
+    printf("+/-: Zoom | Keypad 2/4/6/8: Pan | 0: Full frame\n");
     printf("R: Reset | Q/ESC: Quit | Video loops automatically\n");
     printf("================\n\n");
 }
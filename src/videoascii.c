@@ -0,0 +1,219 @@
+#include "videoascii.h"
+#include "image_processing.h"
+#include <libavutil/frame.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void va_log(const VideoAsciiParams* params, VideoAsciiLogLevel level, const char* fmt, ...) {
+    if (!params || !params->log) return;
+
+    char message[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+    params->log(params->log_user, level, message);
+}
+
+void videoascii_default_params(VideoAsciiParams* params) {
+    if (!params) return;
+    memset(params, 0, sizeof(VideoAsciiParams));
+    params->format = VIDEOASCII_FORMAT_RGB24;
+    params->cols = 160;
+    params->rows = 50;
+    params->keep_aspect = 1;
+    params->ascii = create_default_config();
+    params->filter = RESIZE_DEFAULT_FILTER;
+}
+
+VideoAsciiContext* videoascii_create(const VideoAsciiParams* params) {
+    if (!params) return NULL;
+
+    if (params->source_width <= 0 || params->source_height <= 0 ||
+        params->cols <= 0 || params->rows <= 0) {
+        va_log(params, VIDEOASCII_LOG_ERROR, "Invalid source %dx%d or grid %dx%d",
+               params->source_width, params->source_height, params->cols, params->rows);
+        return NULL;
+    }
+    if (params->format < VIDEOASCII_FORMAT_GRAY8 || params->format > VIDEOASCII_FORMAT_NV12) {
+        va_log(params, VIDEOASCII_LOG_ERROR, "Unknown pixel format %d", params->format);
+        return NULL;
+    }
+    if (params->ascii.char_set_index < 0 || params->ascii.char_set_index >= NUM_ASCII_SETS ||
+        params->ascii.mode < 0 || params->ascii.mode >= ASCII_MODE_COUNT ||
+        params->filter < 0 || params->filter >= RESIZE_FILTER_COUNT) {
+        va_log(params, VIDEOASCII_LOG_ERROR, "Invalid conversion settings");
+        return NULL;
+    }
+    if (params->ascii.mode == ASCII_MODE_SHAPE && !params->ascii.shapes) {
+        va_log(params, VIDEOASCII_LOG_ERROR, "Shape mode needs glyph masks");
+        return NULL;
+    }
+
+    VideoAsciiContext* ctx = calloc(1, sizeof(VideoAsciiContext));
+    if (!ctx) {
+        va_log(params, VIDEOASCII_LOG_ERROR, "Cannot allocate context");
+        return NULL;
+    }
+    ctx->params = *params;
+    ctx->channels = params->format == VIDEOASCII_FORMAT_RGB24 ? 3 : 1;
+
+    int grid_w, grid_h;
+    ascii_grid_limits(&params->ascii, params->cols, params->rows, &grid_w, &grid_h);
+    if (params->keep_aspect) {
+        fit_aspect_ratio(params->source_width, params->source_height, grid_w, grid_h,
+                         &grid_w, &grid_h);
+    }
+
+    ctx->grid = create_image(grid_w, grid_h, ctx->channels);
+    ctx->plan = resize_plan_create(params->source_width, params->source_height, grid_w, grid_h,
+                                   ctx->channels, params->filter);
+    if (!ctx->grid || !ctx->plan) {
+        va_log(params, VIDEOASCII_LOG_ERROR, "Cannot allocate %dx%d grid", grid_w, grid_h);
+        videoascii_destroy(ctx);
+        return NULL;
+    }
+    ctx->output_size = ascii_buffer_size(grid_w, grid_h, &params->ascii);
+
+    // Glyph memory is sized here so the first push does not allocate
+    GlyphHysteresis* hysteresis = params->ascii.hysteresis;
+    if (hysteresis && !glyph_hysteresis_resize(hysteresis, ascii_output_width(grid_w, &params->ascii),
+                                               ascii_output_height(grid_h, &params->ascii))) {
+        va_log(params, VIDEOASCII_LOG_ERROR, "Cannot allocate glyph hysteresis cells");
+        videoascii_destroy(ctx);
+        return NULL;
+    }
+
+    // Video-range luma is stretched after scaling, on grid pixels only
+    ctx->video_range = ctx->channels == 1 && params->format != VIDEOASCII_FORMAT_GRAY8 &&
+                       !params->full_range;
+    for (int v = 0; v < 256; v++) {
+        int level = (v - 16) * 255 / 219;
+        if (level < 0) level = 0;
+        if (level > 255) level = 255;
+        ctx->range_lut[v] = (uint8_t)level;
+    }
+
+    va_log(params, VIDEOASCII_LOG_INFO, "%dx%d source to %dx%d grid (%s, %s)",
+           params->source_width, params->source_height, grid_w, grid_h,
+           ascii_mode_name(params->ascii.mode), resize_filter_name(params->filter));
+    return ctx;
+}
+
+void videoascii_destroy(VideoAsciiContext* ctx) {
+    if (!ctx) return;
+    free_image(ctx->grid);
+    resize_plan_destroy(ctx->plan);
+    free(ctx);
+}
+
+// Bytes an output buffer needs, including the terminating NUL
+size_t videoascii_output_size(const VideoAsciiContext* ctx) {
+    return ctx ? ctx->output_size : 0;
+}
+
+void videoascii_grid_size(const VideoAsciiContext* ctx, int* cols, int* rows) {
+    if (!ctx) return;
+    if (cols) *cols = ascii_output_width(ctx->grid->width, &ctx->params.ascii);
+    if (rows) *rows = ascii_output_height(ctx->grid->height, &ctx->params.ascii);
+}
+
+// Scales and converts one frame; video_range stretches its luma first
+static int videoascii_convert(VideoAsciiContext* ctx, const uint8_t* const planes[],
+                              const int strides[], char* out, size_t out_size, int video_range) {
+    if (!ctx || !planes || !planes[0] || !strides || !out) return VIDEOASCII_ERROR_ARGUMENT;
+
+    if (out_size < ctx->output_size) {
+        va_log(&ctx->params, VIDEOASCII_LOG_ERROR, "Output buffer holds %zu bytes, %zu needed",
+               out_size, ctx->output_size);
+        return VIDEOASCII_ERROR_BUFFER;
+    }
+    if (strides[0] < ctx->params.source_width * ctx->channels) {
+        va_log(&ctx->params, VIDEOASCII_LOG_ERROR, "Stride %d is shorter than a row", strides[0]);
+        return VIDEOASCII_ERROR_SIZE;
+    }
+
+    if (!resize_plan_run_strided(ctx->plan, planes[0], (size_t)strides[0], ctx->grid, NULL)) {
+        va_log(&ctx->params, VIDEOASCII_LOG_ERROR, "Cannot scale the frame to the grid");
+        return VIDEOASCII_ERROR_SIZE;
+    }
+
+    if (video_range) {
+        size_t count = (size_t)ctx->grid->width * ctx->grid->height;
+        for (size_t i = 0; i < count; i++) ctx->grid->data[i] = ctx->range_lut[ctx->grid->data[i]];
+    }
+
+    if (!image_to_ascii_into(ctx->grid, &ctx->params.ascii, out, out_size)) {
+        va_log(&ctx->params, VIDEOASCII_LOG_ERROR, "Cannot convert the grid to %s cells",
+               ascii_mode_name(ctx->params.ascii.mode));
+        return VIDEOASCII_ERROR_ARGUMENT;
+    }
+    ctx->frames++;
+    return VIDEOASCII_OK;
+}
+
+// Converts one frame into out. planes/strides follow the context format:
+// one packed plane for GRAY8 and RGB24, the luma plane first for YUV.
+int videoascii_push(VideoAsciiContext* ctx, const uint8_t* const planes[], const int strides[],
+                    char* out, size_t out_size) {
+    if (!ctx) return VIDEOASCII_ERROR_ARGUMENT;
+    return videoascii_convert(ctx, planes, strides, out, out_size, ctx->video_range);
+}
+
+// Converts a decoded frame straight from its planes. Only the fields of
+// AVFrame are read, so this adds no link dependency on FFmpeg.
+int videoascii_push_avframe(VideoAsciiContext* ctx, const struct AVFrame* frame,
+                            char* out, size_t out_size) {
+    if (!ctx || !frame) return VIDEOASCII_ERROR_ARGUMENT;
+
+    if (frame->width != ctx->params.source_width || frame->height != ctx->params.source_height) {
+        va_log(&ctx->params, VIDEOASCII_LOG_ERROR, "Frame is %dx%d, context expects %dx%d",
+               frame->width, frame->height, ctx->params.source_width, ctx->params.source_height);
+        return VIDEOASCII_ERROR_SIZE;
+    }
+
+    int expected;
+    switch (ctx->params.format) {
+        case VIDEOASCII_FORMAT_GRAY8:
+            expected = AV_PIX_FMT_GRAY8;
+            break;
+        case VIDEOASCII_FORMAT_RGB24:
+            expected = AV_PIX_FMT_RGB24;
+            break;
+        case VIDEOASCII_FORMAT_NV12:
+            expected = AV_PIX_FMT_NV12;
+            break;
+        default:
+            // Only the luma plane is read, so the chroma layout does not matter
+            expected = frame->format == AV_PIX_FMT_YUVJ420P ? AV_PIX_FMT_YUVJ420P : AV_PIX_FMT_YUV420P;
+            break;
+    }
+    if (frame->format != expected) {
+        va_log(&ctx->params, VIDEOASCII_LOG_ERROR, "Frame pixel format %d does not match context",
+               frame->format);
+        return VIDEOASCII_ERROR_FORMAT;
+    }
+    if (frame->linesize[0] <= 0) return VIDEOASCII_ERROR_FORMAT;
+
+    // JPEG-range frames already use the full luma range
+    int video_range = ctx->video_range && frame->format != AV_PIX_FMT_YUVJ420P &&
+                      frame->color_range != AVCOL_RANGE_JPEG;
+
+    const uint8_t* const planes[1] = {frame->data[0]};
+    const int strides[1] = {frame->linesize[0]};
+    return videoascii_convert(ctx, planes, strides, out, out_size, video_range);
+}
+
+const char* videoascii_status_string(int status) {
+    switch (status) {
+        case VIDEOASCII_OK: return "ok";
+        case VIDEOASCII_ERROR_ARGUMENT: return "invalid argument";
+        case VIDEOASCII_ERROR_FORMAT: return "pixel format mismatch";
+        case VIDEOASCII_ERROR_SIZE: return "frame size mismatch";
+        case VIDEOASCII_ERROR_BUFFER: return "output buffer too small";
+        case VIDEOASCII_ERROR_MEMORY: return "out of memory";
+        default: return "unknown error";
+    }
+}